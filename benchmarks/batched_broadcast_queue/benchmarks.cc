@@ -0,0 +1,132 @@
+#include "batched_broadcast_queue/batched_broadcast_queue.hh"
+#include "batched_spsc_queue/batched_spsc_queue.hh"
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace holoflow {
+
+constexpr size_t NB_SLOTS = 64;
+
+// The benchmark thread produces frames of `state.range(1)` bytes for
+// `state.range(0)` consumers, each of which looks at every frame it receives.
+// Every iteration enqueues one frame, so the rates are the ones of the
+// producer.
+static void BM_Broadcast(benchmark::State &state) {
+  const size_t nb_consumers = static_cast<size_t>(state.range(0));
+  const size_t frame_size = static_cast<size_t>(state.range(1));
+
+  std::vector<uint8_t> buffer(NB_SLOTS * frame_size);
+  std::vector<BroadcastConsumerOptions> options(nb_consumers, {1});
+  BatchedBroadcastQueue queue(NB_SLOTS, 1, frame_size, buffer.data(),
+                              options);
+
+  std::vector<uint8_t> source(frame_size);
+  benchmark::DoNotOptimize(source.data());
+  benchmark::DoNotOptimize(buffer.data());
+
+  std::atomic<bool> run = true;
+  std::vector<std::thread> consumers;
+  for (size_t i = 0; i < nb_consumers; i++) {
+    consumers.emplace_back([&queue, &run, i]() {
+      while (run.load(std::memory_order_relaxed)) {
+        uint8_t *frame = queue.read_ptr(i);
+        if (!frame)
+          continue;
+
+        benchmark::DoNotOptimize(frame[0]);
+        queue.commit_read(i);
+      }
+    });
+  }
+
+  for (auto _ : state) {
+    uint8_t *frame = queue.write_ptr();
+    while (!frame)
+      frame = queue.write_ptr();
+
+    std::memcpy(frame, source.data(), frame_size);
+    queue.commit_write();
+  }
+
+  run = false;
+  for (auto &consumer : consumers)
+    consumer.join();
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() *
+                                               frame_size));
+}
+
+// Same as `BM_Broadcast`, but the producer copies each frame into one
+// `BatchedSPSCQueue` per consumer, which is what the broadcast queue replaces.
+static void BM_SPSCFanOut(benchmark::State &state) {
+  const size_t nb_consumers = static_cast<size_t>(state.range(0));
+  const size_t frame_size = static_cast<size_t>(state.range(1));
+
+  std::vector<std::vector<uint8_t>> buffers;
+  std::vector<std::unique_ptr<BatchedSPSCQueue>> queues;
+  for (size_t i = 0; i < nb_consumers; i++) {
+    buffers.emplace_back(NB_SLOTS * frame_size);
+    queues.push_back(std::make_unique<BatchedSPSCQueue>(
+        NB_SLOTS, 1, 1, frame_size, buffers.back().data()));
+  }
+
+  std::vector<uint8_t> source(frame_size);
+  benchmark::DoNotOptimize(source.data());
+
+  std::atomic<bool> run = true;
+  std::vector<std::thread> consumers;
+  for (size_t i = 0; i < nb_consumers; i++) {
+    consumers.emplace_back([queue = queues[i].get(), &run]() {
+      while (run.load(std::memory_order_relaxed)) {
+        uint8_t *frame = queue->read_ptr();
+        if (!frame)
+          continue;
+
+        benchmark::DoNotOptimize(frame[0]);
+        queue->commit_read();
+      }
+    });
+  }
+
+  for (auto _ : state) {
+    for (auto &queue : queues) {
+      uint8_t *frame = queue->write_ptr();
+      while (!frame)
+        frame = queue->write_ptr();
+
+      std::memcpy(frame, source.data(), frame_size);
+      queue->commit_write();
+    }
+  }
+
+  run = false;
+  for (auto &consumer : consumers)
+    consumer.join();
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() *
+                                               frame_size));
+}
+
+// NOLINTBEGIN
+BENCHMARK(BM_Broadcast)
+    ->ArgsProduct({{1, 2, 3}, {4096, 1 << 20}})
+    ->UseRealTime()
+    ->MinTime(5.0);
+BENCHMARK(BM_SPSCFanOut)
+    ->ArgsProduct({{1, 2, 3}, {4096, 1 << 20}})
+    ->UseRealTime()
+    ->MinTime(5.0);
+// NOLINTEND
+
+} // namespace holoflow
+
+BENCHMARK_MAIN();
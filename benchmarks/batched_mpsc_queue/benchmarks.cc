@@ -0,0 +1,80 @@
+#include "batched_mpsc_queue/batched_mpsc_queue.hh"
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace holoflow {
+
+constexpr size_t NB_SLOTS = 1024;
+constexpr size_t ENQUEUE_BATCH_SIZE = 4;
+constexpr size_t DEQUEUE_BATCH_SIZE = 16;
+
+// `state.range(0)` producers feed the benchmark thread, which is the consumer.
+// `state.range(1)` is the element size in bytes. Every iteration dequeues one
+// batch, so the rates are the ones of the consumer.
+static void BM_MPSC(benchmark::State &state) {
+  const size_t nb_producers = static_cast<size_t>(state.range(0));
+  const size_t element_size = static_cast<size_t>(state.range(1));
+  const size_t enqueue_bytes = ENQUEUE_BATCH_SIZE * element_size;
+  const size_t dequeue_bytes = DEQUEUE_BATCH_SIZE * element_size;
+
+  std::vector<uint8_t> buffer(NB_SLOTS * element_size);
+  BatchedMPSCQueue queue(NB_SLOTS, ENQUEUE_BATCH_SIZE, DEQUEUE_BATCH_SIZE,
+                         element_size, buffer.data());
+
+  std::vector<uint8_t> source(enqueue_bytes);
+  std::vector<uint8_t> dest(dequeue_bytes);
+
+  benchmark::DoNotOptimize(source.data());
+  benchmark::DoNotOptimize(dest.data());
+  benchmark::DoNotOptimize(buffer.data());
+
+  std::atomic<bool> run = true;
+  std::vector<std::thread> producers;
+  for (size_t i = 0; i < nb_producers; i++) {
+    producers.emplace_back([&queue, &source, &run]() {
+      while (run.load(std::memory_order_relaxed)) {
+        uint8_t *batch = queue.write_ptr();
+        if (!batch)
+          continue;
+
+        std::memcpy(batch, source.data(), source.size());
+        queue.commit_write(batch);
+      }
+    });
+  }
+
+  for (auto _ : state) {
+    uint8_t *batch = queue.read_ptr();
+    while (!batch)
+      batch = queue.read_ptr();
+
+    std::memcpy(dest.data(), batch, dest.size());
+    queue.commit_read();
+  }
+
+  run = false;
+  for (auto &producer : producers)
+    producer.join();
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          DEQUEUE_BATCH_SIZE);
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() *
+                                               dequeue_bytes));
+}
+
+// NOLINTBEGIN
+BENCHMARK(BM_MPSC)
+    ->ArgsProduct({{1, 2, 4, 8}, {8, 4096}})
+    ->UseRealTime()
+    ->MinTime(5.0);
+// NOLINTEND
+
+} // namespace holoflow
+
+BENCHMARK_MAIN();
@@ -1,14 +1,19 @@
 #include "batched_spsc_queue/batched_spsc_queue.hh"
+#include "batched_spsc_queue/static_batched_spsc_queue.hh"
+#include "uncached_batched_spsc_queue.hh"
 
 #include <array>
 #include <cstdint>
 #include <cstring>
 #include <memory>
 #include <span>
+#include <string>
 #include <thread>
 #include <vector>
 
 #include <benchmark/benchmark.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 namespace holoflow {
 
@@ -20,16 +25,40 @@ constexpr size_t BUFFER_SIZE = NB_SLOTS * ELEMENT_SIZE;
 constexpr size_t ENQUEUE_BYTES = ENQUEUE_BATCH_SIZE * ELEMENT_SIZE;
 constexpr size_t DEQUEUE_BYTES = DEQUEUE_BATCH_SIZE * ELEMENT_SIZE;
 
-static void BM_SPSC(benchmark::State &state) {
-  std::vector<uint8_t> buffer(BUFFER_SIZE);
-  BatchedSPSCQueue queue(NB_SLOTS, ENQUEUE_BATCH_SIZE, DEQUEUE_BATCH_SIZE,
-                         ELEMENT_SIZE, buffer.data());
+using StaticQueue = StaticBatchedSPSCQueue<ELEMENT_SIZE, ENQUEUE_BATCH_SIZE,
+                                           DEQUEUE_BATCH_SIZE, NB_SLOTS>;
+using StaticPow2Queue = StaticBatchedSPSCQueue<ELEMENT_SIZE, ENQUEUE_BATCH_SIZE,
+                                               DEQUEUE_BATCH_SIZE, 1024>;
+
+// Builds any of the benchmarked queues. Compile-time queues carry their own
+// geometry and ignore `nb_slots` and `element_size`.
+template <typename Queue>
+static std::unique_ptr<Queue> make_queue(size_t nb_slots, size_t element_size,
+                                         uint8_t *buffer) {
+  if constexpr (requires { Queue::nb_slots(); })
+    return std::make_unique<Queue>(buffer);
+  else
+    return std::make_unique<Queue>(nb_slots, ENQUEUE_BATCH_SIZE,
+                                   DEQUEUE_BATCH_SIZE, element_size, buffer);
+}
 
-  std::array<uint8_t, ENQUEUE_BATCH_SIZE * ELEMENT_SIZE> source = {0};
-  std::array<uint8_t, DEQUEUE_BATCH_SIZE * ELEMENT_SIZE> dest = {0};
+// Runs a producer and a consumer thread on `Queue`. `state.range(0)` is the
+// element size in bytes and `state.range(1)` the number of slots.
+template <typename Queue> static void BM_SPSC(benchmark::State &state) {
+  const size_t element_size = static_cast<size_t>(state.range(0));
+  const size_t nb_slots = static_cast<size_t>(state.range(1));
+  const size_t enqueue_bytes = ENQUEUE_BATCH_SIZE * element_size;
+  const size_t dequeue_bytes = DEQUEUE_BATCH_SIZE * element_size;
 
-  benchmark::DoNotOptimize(source);
-  benchmark::DoNotOptimize(dest);
+  std::vector<uint8_t> buffer(nb_slots * element_size);
+  auto queue_ptr = make_queue<Queue>(nb_slots, element_size, buffer.data());
+  Queue &queue = *queue_ptr;
+
+  std::vector<uint8_t> source(enqueue_bytes);
+  std::vector<uint8_t> dest(dequeue_bytes);
+
+  benchmark::DoNotOptimize(source.data());
+  benchmark::DoNotOptimize(dest.data());
   benchmark::DoNotOptimize(buffer.data());
 
   std::atomic<bool> run = true;
@@ -60,7 +89,7 @@ static void BM_SPSC(benchmark::State &state) {
       if (batch == nullptr)
         break;
 
-      std::copy(batch, batch + ENQUEUE_BYTES, dest.begin());
+      std::copy(batch, batch + dest.size(), dest.begin());
       queue.commit_read();
       c_count++;
     }
@@ -85,15 +114,16 @@ static void BM_SPSC(benchmark::State &state) {
       static_cast<double>(p_count + c_count), benchmark::Counter::kIsRate);
 
   state.counters["Bandwidth"] = benchmark::Counter(
-      static_cast<double>((p_count + c_count) *
-                          (DEQUEUE_BYTES + ENQUEUE_BYTES)),
+      static_cast<double>(p_count * enqueue_bytes + c_count * dequeue_bytes),
       benchmark::Counter::kIsRate, benchmark::Counter::kIs1024);
 }
 
-static void BM_Enqueue(benchmark::State &state) {
-  std::vector<uint8_t> buffer(BUFFER_SIZE);
-  BatchedSPSCQueue queue(NB_SLOTS, ENQUEUE_BATCH_SIZE, DEQUEUE_BATCH_SIZE,
-                         ELEMENT_SIZE, buffer.data());
+// `state.range(0)` is the number of slots.
+template <typename Queue> static void BM_Enqueue(benchmark::State &state) {
+  const size_t nb_slots = static_cast<size_t>(state.range(0));
+  std::vector<uint8_t> buffer(nb_slots * ELEMENT_SIZE);
+  auto queue_ptr = make_queue<Queue>(nb_slots, ELEMENT_SIZE, buffer.data());
+  Queue &queue = *queue_ptr;
 
   std::array<uint8_t, ENQUEUE_BATCH_SIZE * ELEMENT_SIZE> source = {0};
 
@@ -119,10 +149,12 @@ static void BM_Enqueue(benchmark::State &state) {
       benchmark::Counter::kIsRate, benchmark::Counter::kIs1024);
 }
 
-static void BM_Dequeue(benchmark::State &state) {
-  std::vector<uint8_t> buffer(BUFFER_SIZE);
-  BatchedSPSCQueue queue(NB_SLOTS, ENQUEUE_BATCH_SIZE, DEQUEUE_BATCH_SIZE,
-                         ELEMENT_SIZE, buffer.data());
+// `state.range(0)` is the number of slots.
+template <typename Queue> static void BM_Dequeue(benchmark::State &state) {
+  const size_t nb_slots = static_cast<size_t>(state.range(0));
+  std::vector<uint8_t> buffer(nb_slots * ELEMENT_SIZE);
+  auto queue_ptr = make_queue<Queue>(nb_slots, ELEMENT_SIZE, buffer.data());
+  Queue &queue = *queue_ptr;
 
   std::array<uint8_t, DEQUEUE_BATCH_SIZE * ELEMENT_SIZE> dest = {0};
   queue.fill();
@@ -149,10 +181,120 @@ static void BM_Dequeue(benchmark::State &state) {
       benchmark::Counter::kIsRate, benchmark::Counter::kIs1024);
 }
 
+// Drains `queue` until the producer closes it.
+static void drain(BatchedSPSCQueue &queue) {
+  while (true) {
+    bool closed = queue.is_closed();
+    size_t count = 0;
+    uint8_t *batch = queue.read_ptr_partial(count);
+    if (!batch) {
+      if (closed)
+        return;
+      continue;
+    }
+
+    benchmark::DoNotOptimize(batch[0]);
+    queue.commit_read_partial(count);
+  }
+}
+
+// The benchmark thread produces elements of `state.range(0)` bytes in a queue
+// of `state.range(1)` slots. With `Shared`, the queue is in shared memory and
+// drained by another process, otherwise by another thread.
+template <bool Shared> static void BM_Transfer(benchmark::State &state) {
+  const size_t element_size = static_cast<size_t>(state.range(0));
+  const size_t nb_slots = static_cast<size_t>(state.range(1));
+  const std::string name = "/holoflow-bench-" + std::to_string(getpid());
+
+  std::vector<uint8_t> buffer;
+  std::unique_ptr<BatchedSPSCQueue> queue;
+  if constexpr (Shared) {
+    queue = BatchedSPSCQueue::create_shared(name, nb_slots, ENQUEUE_BATCH_SIZE,
+                                            DEQUEUE_BATCH_SIZE, element_size);
+  } else {
+    buffer.resize(nb_slots * element_size);
+    queue = std::make_unique<BatchedSPSCQueue>(
+        nb_slots, ENQUEUE_BATCH_SIZE, DEQUEUE_BATCH_SIZE, element_size,
+        buffer.data());
+  }
+
+  std::vector<uint8_t> source(ENQUEUE_BATCH_SIZE * element_size);
+  benchmark::DoNotOptimize(source.data());
+
+  pid_t pid = -1;
+  std::thread consumer;
+  if constexpr (Shared) {
+    pid = fork();
+    if (pid == 0) {
+      drain(*BatchedSPSCQueue::attach_shared(name));
+      _exit(0);
+    }
+  } else {
+    consumer = std::thread([&queue]() { drain(*queue); });
+  }
+
+  for (auto _ : state) {
+    uint8_t *batch = queue->write_ptr();
+    while (!batch)
+      batch = queue->write_ptr();
+
+    std::memcpy(batch, source.data(), source.size());
+    queue->commit_write();
+  }
+
+  queue->close();
+  if constexpr (Shared)
+    waitpid(pid, nullptr, 0);
+  else
+    consumer.join();
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          ENQUEUE_BATCH_SIZE);
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() *
+                                               source.size()));
+}
+
 // NOLINTBEGIN
-BENCHMARK(BM_SPSC)->MinTime(20.0);
-BENCHMARK(BM_Enqueue)->MinTime(20.0);
-BENCHMARK(BM_Dequeue)->MinTime(20.0);
+// The uncached queue is the previous implementation, kept to show the effect
+// of caching the opposite index: 1-byte elements and 512x512 frames.
+BENCHMARK(BM_SPSC<BatchedSPSCQueue>)
+    ->Args({ELEMENT_SIZE, NB_SLOTS})
+    ->Args({512 * 512, 64})
+    ->MinTime(20.0);
+BENCHMARK(BM_SPSC<UncachedBatchedSPSCQueue>)
+    ->Args({ELEMENT_SIZE, NB_SLOTS})
+    ->Args({512 * 512, 64})
+    ->MinTime(20.0);
+BENCHMARK(BM_SPSC<StaticQueue>)->Args({ELEMENT_SIZE, NB_SLOTS})->MinTime(20.0);
+BENCHMARK(BM_SPSC<StaticPow2Queue>)->Args({ELEMENT_SIZE, 1024})->MinTime(20.0);
+
+// Runtime geometry against compile-time geometry, with and without a
+// power-of-two slot count.
+BENCHMARK(BM_Enqueue<BatchedSPSCQueue>)
+    ->Arg(NB_SLOTS)
+    ->Arg(1024)
+    ->MinTime(20.0);
+BENCHMARK(BM_Enqueue<StaticQueue>)->Arg(NB_SLOTS)->MinTime(20.0);
+BENCHMARK(BM_Enqueue<StaticPow2Queue>)->Arg(1024)->MinTime(20.0);
+BENCHMARK(BM_Dequeue<BatchedSPSCQueue>)
+    ->Arg(NB_SLOTS)
+    ->Arg(1024)
+    ->MinTime(20.0);
+BENCHMARK(BM_Dequeue<StaticQueue>)->Arg(NB_SLOTS)->MinTime(20.0);
+BENCHMARK(BM_Dequeue<StaticPow2Queue>)->Arg(1024)->MinTime(20.0);
+
+// A consumer in another process, through shared memory, against a consumer
+// thread in the same process.
+BENCHMARK(BM_Transfer<false>)
+    ->Args({ELEMENT_SIZE, NB_SLOTS})
+    ->Args({512 * 512, 64})
+    ->UseRealTime()
+    ->MinTime(20.0);
+BENCHMARK(BM_Transfer<true>)
+    ->Args({ELEMENT_SIZE, NB_SLOTS})
+    ->Args({512 * 512, 64})
+    ->UseRealTime()
+    ->MinTime(20.0);
 // NOLINTEND
 
 } // namespace holoflow
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <fstream>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+
+namespace holoflow {
+/**
+ * @brief Where the consumer thread of a benchmark runs relative to the
+ * producer thread.
+ */
+enum class Placement {
+  /// Two hardware threads of the same physical core.
+  SameCore,
+
+  /// Two physical cores of the same socket, sharing the last level cache.
+  Sibling,
+
+  /// Two sockets.
+  CrossSocket,
+
+  /// No pinning, the scheduler decides.
+  Unpinned,
+};
+
+/// Returns a short name for `placement`, used as a benchmark label.
+inline const char *placement_name(Placement placement) {
+  switch (placement) {
+  case Placement::SameCore:
+    return "same-core";
+  case Placement::Sibling:
+    return "sibling";
+  case Placement::CrossSocket:
+    return "cross-socket";
+  default:
+    return "unpinned";
+  }
+}
+
+/// The position of a logical CPU in the machine.
+struct CpuLocation {
+  int cpu;
+  int core;
+  int package;
+};
+
+/// Reads the location of every CPU the process may run on from sysfs.
+inline std::vector<CpuLocation> allowed_cpus() {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(0, sizeof(set), &set) != 0)
+    return {};
+
+  auto read_id = [](int cpu, const char *name) {
+    std::ifstream file("/sys/devices/system/cpu/cpu" + std::to_string(cpu) +
+                       "/topology/" + name);
+    int id = -1;
+    file >> id;
+    return id;
+  };
+
+  std::vector<CpuLocation> cpus;
+  for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+    if (CPU_ISSET(cpu, &set))
+      cpus.push_back(
+          {cpu, read_id(cpu, "core_id"), read_id(cpu, "physical_package_id")});
+  }
+  return cpus;
+}
+
+/**
+ * @brief Finds a (producer, consumer) pair of CPUs with the given placement.
+ *
+ * @return The pair, or nothing if the machine or the affinity mask of the
+ * process has no such pair.
+ */
+inline std::optional<std::pair<int, int>> find_cpu_pair(Placement placement) {
+  std::vector<CpuLocation> cpus = allowed_cpus();
+
+  for (const CpuLocation &a : cpus) {
+    for (const CpuLocation &b : cpus) {
+      if (a.cpu == b.cpu)
+        continue;
+
+      bool same_package = a.package == b.package;
+      bool same_core = same_package && a.core == b.core;
+      if ((placement == Placement::SameCore && same_core) ||
+          (placement == Placement::Sibling && same_package && !same_core) ||
+          (placement == Placement::CrossSocket && !same_package))
+        return std::make_pair(a.cpu, b.cpu);
+    }
+  }
+  return std::nullopt;
+}
+
+/// Pins the calling thread to `cpu`. Returns whether it succeeded.
+inline bool pin_thread(int cpu) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+} // namespace holoflow
@@ -0,0 +1,99 @@
+#include "batched_spsc_queue/batched_spsc_queue.hh"
+#include "latency_histogram.hh"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace holoflow {
+
+constexpr size_t NB_SLOTS = 1024;
+constexpr size_t ELEMENT_SIZE = 64;
+
+/// Returns the current time in nanoseconds. `steady_clock` is read through the
+/// vDSO, which is cheap enough and, unlike the TSC, needs no calibration.
+static int64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// A producer thread enqueues one element every `state.range(2)` nanoseconds
+// and stamps it right before committing it. The benchmark thread is the
+// consumer: every iteration dequeues a batch of `state.range(0)` elements with
+// `WaitPolicy(state.range(1))`, and records the age of each element once
+// `wait_read_ptr()` returns. In a large batch, the first element also waits
+// for the last one to be produced, which shows in the percentiles.
+static void BM_Latency(benchmark::State &state) {
+  const size_t dequeue_batch_size = static_cast<size_t>(state.range(0));
+  const auto policy = static_cast<WaitPolicy>(state.range(1));
+  const auto period = std::chrono::nanoseconds(state.range(2));
+
+  std::vector<uint8_t> buffer(NB_SLOTS * ELEMENT_SIZE);
+  BatchedSPSCQueue queue(NB_SLOTS, 1, dequeue_batch_size, ELEMENT_SIZE,
+                         buffer.data());
+  queue.set_wait_strategy({policy});
+
+  std::atomic<bool> run = true;
+  std::thread producer([&queue, &run, period]() {
+    auto next = std::chrono::steady_clock::now();
+    while (run.load(std::memory_order_relaxed)) {
+      // Pace the production like a camera would.
+      while (std::chrono::steady_clock::now() < next) {
+      }
+      next += period;
+
+      uint8_t *element = queue.wait_write_ptr(std::chrono::milliseconds(1));
+      if (!element)
+        continue;
+
+      int64_t stamp = now_ns();
+      std::memcpy(element, &stamp, sizeof(stamp));
+      queue.commit_write();
+    }
+  });
+
+  LatencyHistogram histogram;
+  for (auto _ : state) {
+    uint8_t *batch = queue.wait_read_ptr();
+    int64_t now = now_ns();
+
+    for (size_t i = 0; i < dequeue_batch_size; i++) {
+      int64_t stamp;
+      std::memcpy(&stamp, batch + i * ELEMENT_SIZE, sizeof(stamp));
+      histogram.record(static_cast<uint64_t>(now - stamp));
+    }
+    queue.commit_read();
+  }
+
+  run = false;
+  producer.join();
+
+  state.SetItemsProcessed(static_cast<int64_t>(histogram.count()));
+  state.counters["p50_ns"] = static_cast<double>(histogram.percentile(50.0));
+  state.counters["p99_ns"] = static_cast<double>(histogram.percentile(99.0));
+  state.counters["p99.9_ns"] =
+      static_cast<double>(histogram.percentile(99.9));
+  state.counters["max_ns"] = static_cast<double>(histogram.max());
+}
+
+// NOLINTBEGIN
+BENCHMARK(BM_Latency)
+    ->ArgNames({"dequeue", "policy", "period_ns"})
+    ->ArgsProduct({{1, 8, 64},
+                   {static_cast<int64_t>(WaitPolicy::Spin),
+                    static_cast<int64_t>(WaitPolicy::SpinYield),
+                    static_cast<int64_t>(WaitPolicy::SpinPark)},
+                   {1000, 10000}})
+    ->UseRealTime()
+    ->MinTime(2.0);
+// NOLINTEND
+
+} // namespace holoflow
+
+BENCHMARK_MAIN();
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace holoflow {
+/**
+ * @brief A log-linear histogram of latencies, in the spirit of HdrHistogram.
+ *
+ * Values below `2^SUB_BUCKET_BITS` are counted exactly. Above, every power of
+ * two is split into `2^SUB_BUCKET_BITS` buckets, so a percentile is reported
+ * with a relative error below `2^-SUB_BUCKET_BITS`, whatever its magnitude.
+ * Recording is a few bit operations and an increment, cheap enough to be done
+ * for every element.
+ */
+class LatencyHistogram {
+public:
+  /// The number of bits of precision kept for every value.
+  static constexpr unsigned SUB_BUCKET_BITS = 7;
+
+  LatencyHistogram() : counts_((65 - SUB_BUCKET_BITS) << SUB_BUCKET_BITS) {}
+
+  /// Counts one occurrence of `value`.
+  void record(uint64_t value) {
+    counts_[index(value)]++;
+    count_++;
+    max_ = std::max(max_, value);
+  }
+
+  /// Returns the number of recorded values.
+  uint64_t count() const { return count_; }
+
+  /// Returns the largest recorded value.
+  uint64_t max() const { return max_; }
+
+  /**
+   * @brief Returns the value below which `percentile` percent of the recorded
+   * values are, rounded up to the end of its bucket.
+   */
+  uint64_t percentile(double percentile) const {
+    auto target = static_cast<uint64_t>(
+        std::ceil(percentile / 100.0 * static_cast<double>(count_)));
+    target = std::max<uint64_t>(target, 1);
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts_.size(); i++) {
+      seen += counts_[i];
+      if (seen >= target)
+        return std::min(highest_value(i), max_);
+    }
+    return max_;
+  }
+
+private:
+  static constexpr uint64_t SUB_BUCKETS = uint64_t{1} << SUB_BUCKET_BITS;
+
+  /// Returns the bucket of `value`.
+  static size_t index(uint64_t value) {
+    if (value < SUB_BUCKETS)
+      return value;
+
+    // Keep the `SUB_BUCKET_BITS + 1` most significant bits of the value.
+    unsigned shift =
+        static_cast<unsigned>(std::bit_width(value)) - SUB_BUCKET_BITS - 1;
+    uint64_t mantissa = value >> shift;
+    return (shift + 1) * SUB_BUCKETS + (mantissa - SUB_BUCKETS);
+  }
+
+  /// Returns the largest value that falls in bucket `index`.
+  static uint64_t highest_value(size_t index) {
+    if (index < SUB_BUCKETS)
+      return index;
+
+    uint64_t shift = index / SUB_BUCKETS - 1;
+    uint64_t mantissa = index % SUB_BUCKETS + SUB_BUCKETS;
+    return (mantissa << shift) + (uint64_t{1} << shift) - 1;
+  }
+
+private:
+  /// The number of values in each bucket.
+  std::vector<uint64_t> counts_;
+
+  /// The number of recorded values.
+  uint64_t count_ = 0;
+
+  /// The largest recorded value.
+  uint64_t max_ = 0;
+};
+
+} // namespace holoflow
@@ -0,0 +1,134 @@
+#include "batched_spsc_queue/batched_spsc_queue.hh"
+#include "batched_spsc_queue/queue_buffer.hh"
+#include "cpu_topology.hh"
+
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <pthread.h>
+#include <sched.h>
+
+namespace holoflow {
+
+/// Configurations whose buffer would be larger than this are not run.
+constexpr size_t MAX_BUFFER_SIZE = 256 << 20;
+
+// The benchmark thread produces into a queue drained by a consumer thread, and
+// both copy every batch they transfer. Every iteration enqueues one batch, so
+// the rates are the ones of the data actually going through the queue.
+//
+// Arguments: element size in bytes, enqueue batch size, dequeue batch size,
+// number of slots and `Placement` of the two threads.
+static void BM_Throughput(benchmark::State &state) {
+  const size_t element_size = static_cast<size_t>(state.range(0));
+  const size_t enqueue_batch_size = static_cast<size_t>(state.range(1));
+  const size_t dequeue_batch_size = static_cast<size_t>(state.range(2));
+  const size_t nb_slots = static_cast<size_t>(state.range(3));
+  const auto placement = static_cast<Placement>(state.range(4));
+  state.SetLabel(placement_name(placement));
+
+  std::optional<std::pair<int, int>> cpus;
+  if (placement != Placement::Unpinned) {
+    cpus = find_cpu_pair(placement);
+    if (!cpus) {
+      state.SkipWithError("No pair of CPUs with this placement");
+      return;
+    }
+  }
+
+  // Pre-fault the buffer so that page faults are not part of the measure.
+  BatchedSPSCQueue queue(
+      nb_slots, enqueue_batch_size, dequeue_batch_size, element_size,
+      QueueBuffer::allocate(nb_slots * element_size,
+                            {HugePages::Transparent, -1, true}));
+
+  std::vector<uint8_t> source(enqueue_batch_size * element_size, 1);
+  benchmark::DoNotOptimize(source.data());
+
+  cpu_set_t saved_affinity;
+  pthread_getaffinity_np(pthread_self(), sizeof(saved_affinity),
+                         &saved_affinity);
+  if (cpus)
+    pin_thread(cpus->first);
+
+  std::thread consumer([&queue, &cpus, element_size, dequeue_batch_size]() {
+    if (cpus)
+      pin_thread(cpus->second);
+
+    std::vector<uint8_t> dest(dequeue_batch_size * element_size);
+    benchmark::DoNotOptimize(dest.data());
+
+    while (!queue.is_closed()) {
+      uint8_t *batch = queue.read_ptr();
+      if (!batch)
+        continue;
+
+      std::memcpy(dest.data(), batch, dest.size());
+      queue.commit_read();
+    }
+
+    // Drain the tail left by the producer, outside of the timed region.
+    size_t count = 0;
+    while (uint8_t *batch = queue.read_ptr_partial(count)) {
+      std::memcpy(dest.data(), batch, count * element_size);
+      queue.commit_read_partial(count);
+    }
+  });
+
+  for (auto _ : state) {
+    uint8_t *batch = queue.write_ptr();
+    while (!batch)
+      batch = queue.write_ptr();
+
+    std::memcpy(batch, source.data(), source.size());
+    queue.commit_write();
+  }
+
+  queue.close();
+  consumer.join();
+  pthread_setaffinity_np(pthread_self(), sizeof(saved_affinity),
+                         &saved_affinity);
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(enqueue_batch_size));
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(source.size()));
+}
+
+// From single bytes to 1 MB frames, with balanced, fan-in-like and
+// fan-out-like batch ratios, for every thread placement.
+static void throughput_matrix(benchmark::internal::Benchmark *benchmark) {
+  const std::vector<int64_t> element_sizes = {1, 64, 4096, 64 << 10, 1 << 20};
+  const std::vector<std::pair<int64_t, int64_t>> batch_sizes = {
+      {1, 1}, {1, 16}, {16, 1}, {16, 16}};
+  const std::vector<int64_t> slot_counts = {64, 1024, 16384};
+
+  benchmark->ArgNames(
+      {"element_size", "enqueue", "dequeue", "slots", "placement"});
+  for (int64_t element_size : element_sizes) {
+    for (auto [enqueue_batch_size, dequeue_batch_size] : batch_sizes) {
+      for (int64_t nb_slots : slot_counts) {
+        if (static_cast<size_t>(nb_slots * element_size) > MAX_BUFFER_SIZE)
+          continue;
+        for (auto placement : {Placement::SameCore, Placement::Sibling,
+                               Placement::CrossSocket, Placement::Unpinned})
+          benchmark->Args({element_size, enqueue_batch_size,
+                           dequeue_batch_size, nb_slots,
+                           static_cast<int64_t>(placement)});
+      }
+    }
+  }
+}
+
+// NOLINTBEGIN
+BENCHMARK(BM_Throughput)->Apply(throughput_matrix)->UseRealTime()->MinTime(1.0);
+// NOLINTEND
+
+} // namespace holoflow
+
+BENCHMARK_MAIN();
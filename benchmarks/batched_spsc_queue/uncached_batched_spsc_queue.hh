@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#ifndef CACHE_LINE_SIZE
+#define CACHE_LINE_SIZE 64
+#endif
+
+namespace holoflow {
+/**
+ * @brief Reference copy of `BatchedSPSCQueue` that loads the opposite index on
+ * every `write_ptr()`/`read_ptr()` call.
+ *
+ * It only exists so the benchmarks can compare the cached-index queue against
+ * the previous behavior in the same binary.
+ */
+class UncachedBatchedSPSCQueue {
+public:
+  UncachedBatchedSPSCQueue(size_t nb_slots, size_t enqueue_batch_size,
+                           size_t dequeue_batch_size, size_t element_size,
+                           uint8_t *buffer)
+      : nb_slots_(nb_slots), enqueue_batch_size_(enqueue_batch_size),
+        dequeue_batch_size_(dequeue_batch_size), element_size_(element_size),
+        buffer_(buffer), write_idx_(0), read_idx_(0) {}
+
+  uint8_t *write_ptr() {
+    size_t write_idx = write_idx_.load(std::memory_order_relaxed);
+    size_t read_idx = read_idx_.load(std::memory_order_acquire);
+    if (nb_slots_ - distance(write_idx, read_idx) < enqueue_batch_size_ + 1)
+      return nullptr;
+
+    return buffer_ + write_idx * element_size_;
+  }
+
+  void commit_write() {
+    size_t next_write_idx =
+        write_idx_.load(std::memory_order_relaxed) + enqueue_batch_size_;
+    if (next_write_idx == nb_slots_)
+      next_write_idx = 0;
+
+    write_idx_.store(next_write_idx, std::memory_order_release);
+  }
+
+  uint8_t *read_ptr() {
+    size_t write_idx = write_idx_.load(std::memory_order_acquire);
+    size_t read_idx = read_idx_.load(std::memory_order_relaxed);
+    if (distance(write_idx, read_idx) < dequeue_batch_size_)
+      return nullptr;
+
+    return buffer_ + read_idx * element_size_;
+  }
+
+  void commit_read() {
+    size_t next_read_idx =
+        read_idx_.load(std::memory_order_relaxed) + dequeue_batch_size_;
+    if (next_read_idx == nb_slots_)
+      next_read_idx = 0;
+
+    read_idx_.store(next_read_idx, std::memory_order_release);
+  }
+
+private:
+  size_t distance(size_t write_idx, size_t read_idx) const {
+    size_t diff = write_idx - read_idx;
+    if (write_idx < read_idx)
+      diff += nb_slots_;
+    return diff;
+  }
+
+  size_t nb_slots_;
+  size_t enqueue_batch_size_;
+  size_t dequeue_batch_size_;
+  size_t element_size_;
+  uint8_t *buffer_;
+
+  alignas(CACHE_LINE_SIZE) std::atomic<size_t> write_idx_;
+  alignas(CACHE_LINE_SIZE) std::atomic<size_t> read_idx_;
+};
+} // namespace holoflow
@@ -0,0 +1,106 @@
+#include "holoflow/tensor/convert.hh"
+#include "holoflow/tensor/tensor.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace holoflow {
+
+constexpr size_t FRAME_SIZE = 512;
+
+/// Returns a dense 512x512 frame of `T` over `buffer`.
+template <typename T> static Tensor make_frame(std::vector<T> &buffer) {
+  buffer.assign(FRAME_SIZE * FRAME_SIZE, T{1});
+  return Tensor(TensorDescriptor(dtype_of<T>, {FRAME_SIZE, FRAME_SIZE},
+                                 {FRAME_SIZE * sizeof(T), sizeof(T)}),
+                reinterpret_cast<std::byte *>(buffer.data()));
+}
+
+static void set_items_processed(benchmark::State &state) {
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(FRAME_SIZE * FRAME_SIZE));
+}
+
+// Converts a u8 frame to f32 with a gain and an offset in a plain loop, as the
+// first compute step did.
+static void BM_NaiveU8ToF32(benchmark::State &state) {
+  std::vector<uint8_t> src_buffer;
+  std::vector<float> dst_buffer;
+  Tensor src = make_frame(src_buffer);
+  Tensor dst = make_frame(dst_buffer);
+
+  for (auto _ : state) {
+    const float gain = 0.5f;
+    const float offset = -16.0f;
+    for (size_t i = 0; i < FRAME_SIZE; i++) {
+      for (size_t j = 0; j < FRAME_SIZE; j++) {
+        const std::byte *in = src.raw_data() + i * src.desc().strides()[0] +
+                              j * src.desc().strides()[1];
+        std::byte *out = dst.raw_data() + i * dst.desc().strides()[0] +
+                         j * dst.desc().strides()[1];
+        *reinterpret_cast<float *>(out) =
+            static_cast<float>(*reinterpret_cast<const uint8_t *>(in)) *
+                gain +
+            offset;
+      }
+    }
+    benchmark::ClobberMemory();
+  }
+  set_items_processed(state);
+}
+
+// Converts a u8 frame to f32 with `convert()`, up to the `SimdLevel` given
+// by `state.range(0)`.
+static void BM_ConvertU8ToF32(benchmark::State &state) {
+  std::vector<uint8_t> src_buffer;
+  std::vector<float> dst_buffer;
+  Tensor src = make_frame(src_buffer);
+  Tensor dst = make_frame(dst_buffer);
+  ConvertOptions options{
+      .scale = 0.5,
+      .offset = -16,
+      .max_simd_level = static_cast<SimdLevel>(state.range(0))};
+  state.SetLabel(
+      std::string(simd_level_name(simd_level(options.max_simd_level))));
+
+  for (auto _ : state) {
+    convert(src, dst, options);
+    benchmark::ClobberMemory();
+  }
+  set_items_processed(state);
+}
+
+// Converts an f32 frame back to u16 with saturation, up to the `SimdLevel`
+// given by `state.range(0)`.
+static void BM_ConvertF32ToU16(benchmark::State &state) {
+  std::vector<float> src_buffer;
+  std::vector<uint16_t> dst_buffer;
+  Tensor src = make_frame(src_buffer);
+  Tensor dst = make_frame(dst_buffer);
+  ConvertOptions options{
+      .scale = 1000,
+      .offset = 0,
+      .max_simd_level = static_cast<SimdLevel>(state.range(0))};
+  state.SetLabel(
+      std::string(simd_level_name(simd_level(options.max_simd_level))));
+
+  for (auto _ : state) {
+    convert(src, dst, options);
+    benchmark::ClobberMemory();
+  }
+  set_items_processed(state);
+}
+
+// NOLINTBEGIN
+BENCHMARK(BM_NaiveU8ToF32);
+BENCHMARK(BM_ConvertU8ToF32)->DenseRange(0, 3);
+BENCHMARK(BM_ConvertF32ToU16)->DenseRange(0, 3);
+// NOLINTEND
+
+} // namespace holoflow
+
+BENCHMARK_MAIN();
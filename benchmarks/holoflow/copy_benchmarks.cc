@@ -0,0 +1,118 @@
+#include "holoflow/tensor/copy.hh"
+#include "holoflow/tensor/tensor.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace holoflow {
+
+/// The padding of the rows of the source frames, as cameras add to align them.
+constexpr size_t ROW_PADDING = 64;
+
+/// A padded `float` source frame and a dense destination frame of
+/// `size x size` elements, the source being read transposed if requested.
+struct Frames {
+  Frames(size_t size, bool transposed)
+      : src_buffer(size * (size + ROW_PADDING), 1.0f),
+        dst_buffer(size * size, 0.0f),
+        src(TensorDescriptor(DType::F32, {size, size},
+                             {(size + ROW_PADDING) * sizeof(float),
+                              sizeof(float)}),
+            reinterpret_cast<std::byte *>(src_buffer.data())),
+        dst(TensorDescriptor(DType::F32, {size, size},
+                             {size * sizeof(float), sizeof(float)}),
+            reinterpret_cast<std::byte *>(dst_buffer.data())) {
+    if (transposed)
+      src = src.transpose(0, 1);
+  }
+
+  std::vector<float> src_buffer;
+  std::vector<float> dst_buffer;
+  Tensor src;
+  Tensor dst;
+};
+
+/// Copies element by element, as each consumer did before `copy()`.
+static void naive_copy(const Tensor &src, const Tensor &dst) {
+  const TensorDescriptor &in = src.desc();
+  const TensorDescriptor &out = dst.desc();
+  for (size_t i = 0; i < in.shape()[0]; i++) {
+    for (size_t j = 0; j < in.shape()[1]; j++) {
+      *reinterpret_cast<float *>(dst.raw_data() + i * out.strides()[0] +
+                                 j * out.strides()[1]) =
+          *reinterpret_cast<const float *>(src.raw_data() +
+                                           i * in.strides()[0] +
+                                           j * in.strides()[1]);
+    }
+  }
+}
+
+static void set_bytes_processed(benchmark::State &state, size_t size) {
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(size * size * sizeof(float)));
+}
+
+// Repacks a padded frame into a dense one with nested loops.
+static void BM_NaiveRepack(benchmark::State &state) {
+  const size_t size = static_cast<size_t>(state.range(0));
+  Frames frames(size, false);
+
+  for (auto _ : state) {
+    naive_copy(frames.src, frames.dst);
+    benchmark::ClobberMemory();
+  }
+  set_bytes_processed(state, size);
+}
+
+// Repacks a padded frame into a dense one with `copy()`, with non-temporal
+// stores if `state.range(1)` is set.
+static void BM_Repack(benchmark::State &state) {
+  const size_t size = static_cast<size_t>(state.range(0));
+  Frames frames(size, false);
+  CopyOptions options{.non_temporal = state.range(1) ? NonTemporal::Always
+                                                     : NonTemporal::Never};
+
+  for (auto _ : state) {
+    copy(frames.src, frames.dst, options);
+    benchmark::ClobberMemory();
+  }
+  set_bytes_processed(state, size);
+}
+
+// Transposes a padded frame into a dense one with nested loops.
+static void BM_NaiveTranspose(benchmark::State &state) {
+  const size_t size = static_cast<size_t>(state.range(0));
+  Frames frames(size, true);
+
+  for (auto _ : state) {
+    naive_copy(frames.src, frames.dst);
+    benchmark::ClobberMemory();
+  }
+  set_bytes_processed(state, size);
+}
+
+// Transposes a padded frame into a dense one with the tiles of `copy()`.
+static void BM_Transpose(benchmark::State &state) {
+  const size_t size = static_cast<size_t>(state.range(0));
+  Frames frames(size, true);
+
+  for (auto _ : state) {
+    copy(frames.src, frames.dst);
+    benchmark::ClobberMemory();
+  }
+  set_bytes_processed(state, size);
+}
+
+// NOLINTBEGIN
+BENCHMARK(BM_NaiveRepack)->Arg(512)->Arg(2048);
+BENCHMARK(BM_Repack)->ArgsProduct({{512, 2048}, {0, 1}});
+BENCHMARK(BM_NaiveTranspose)->Arg(512)->Arg(2048);
+BENCHMARK(BM_Transpose)->Arg(512)->Arg(2048);
+// NOLINTEND
+
+} // namespace holoflow
+
+BENCHMARK_MAIN();
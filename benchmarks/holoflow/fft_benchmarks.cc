@@ -0,0 +1,134 @@
+#include "holoflow/tensor/fft.hh"
+#include "holoflow/tensor/tensor.hh"
+#include "holoflow/tensor/thread_pool.hh"
+
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <numbers>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace holoflow {
+
+/// Returns a dense square complex64 frame of `size` over `buffer`.
+static Tensor make_frame(std::vector<std::complex<float>> &buffer,
+                         size_t size) {
+  buffer.resize(size * size);
+  for (size_t i = 0; i < buffer.size(); i++)
+    buffer[i] = std::complex<float>(static_cast<float>(i % 255), 0);
+  return Tensor(TensorDescriptor(DType::Complex64, {size, size},
+                                 {size * sizeof(std::complex<float>),
+                                  sizeof(std::complex<float>)}),
+                reinterpret_cast<std::byte *>(buffer.data()));
+}
+
+static void set_items_processed(benchmark::State &state, size_t size) {
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(size * size));
+}
+
+/// Transforms a line of a power of 2 length in place with a textbook radix-2
+/// FFT, computing its twiddle factors on each call.
+static void naive_fft(std::complex<float> *x, size_t n) {
+  for (size_t i = 1, j = 0; i < n; i++) {
+    size_t bit = n >> 1;
+    for (; j & bit; bit >>= 1)
+      j ^= bit;
+    j ^= bit;
+    if (i < j)
+      std::swap(x[i], x[j]);
+  }
+  for (size_t len = 2; len <= n; len <<= 1) {
+    for (size_t i = 0; i < n; i += len) {
+      for (size_t k = 0; k < len / 2; k++) {
+        std::complex<float> w = std::polar(
+            1.0f, -2 * std::numbers::pi_v<float> * static_cast<float>(k) /
+                      static_cast<float>(len));
+        std::complex<float> a = x[i + k];
+        std::complex<float> b = x[i + k + len / 2] * w;
+        x[i + k] = a + b;
+        x[i + k + len / 2] = a - b;
+      }
+    }
+  }
+}
+
+// Transforms a frame in 2D with a textbook FFT on each row, then on a copy of
+// each column.
+static void BM_NaiveFft2(benchmark::State &state) {
+  const size_t size = static_cast<size_t>(state.range(0));
+  std::vector<std::complex<float>> buffer;
+  make_frame(buffer, size);
+  std::vector<std::complex<float>> column(size);
+
+  for (auto _ : state) {
+    for (size_t i = 0; i < size; i++)
+      naive_fft(buffer.data() + i * size, size);
+    for (size_t j = 0; j < size; j++) {
+      for (size_t i = 0; i < size; i++)
+        column[i] = buffer[i * size + j];
+      naive_fft(column.data(), size);
+      for (size_t i = 0; i < size; i++)
+        buffer[i * size + j] = column[i];
+    }
+    benchmark::ClobberMemory();
+  }
+  set_items_processed(state, size);
+}
+
+// Transforms a frame in 2D in place with `fft2()`, up to the `SimdLevel`
+// given by `state.range(1)`, on the number of threads given by
+// `state.range(2)`.
+static void BM_Fft2(benchmark::State &state) {
+  const size_t size = static_cast<size_t>(state.range(0));
+  std::vector<std::complex<float>> buffer;
+  Tensor frame = make_frame(buffer, size);
+  ThreadPool pool(static_cast<size_t>(state.range(2)));
+  FftOptions options{
+      .pool = &pool,
+      .max_simd_level = static_cast<SimdLevel>(state.range(1))};
+  state.SetLabel(std::string(simd_level_name(
+                     simd_level(options.max_simd_level))) +
+                 ", " + std::to_string(pool.size()) + " threads");
+
+  for (auto _ : state) {
+    fft2(frame, frame, options);
+    benchmark::ClobberMemory();
+  }
+  set_items_processed(state, size);
+}
+
+// Propagates a frame as the angular spectrum method does: a forward
+// transform, a product with a transfer function and an inverse transform.
+static void BM_AngularSpectrum(benchmark::State &state) {
+  const size_t size = static_cast<size_t>(state.range(0));
+  std::vector<std::complex<float>> buffer;
+  Tensor frame = make_frame(buffer, size);
+  std::vector<std::complex<float>> transfer(size * size);
+  for (size_t i = 0; i < transfer.size(); i++)
+    transfer[i] = std::polar(1.0f, static_cast<float>(i % 1000) * 1e-3f);
+
+  for (auto _ : state) {
+    fft2(frame, frame);
+    for (size_t i = 0; i < buffer.size(); i++)
+      buffer[i] *= transfer[i];
+    fft2(frame, frame, {.direction = FftDirection::Inverse});
+    benchmark::ClobberMemory();
+  }
+  set_items_processed(state, size);
+}
+
+// NOLINTBEGIN
+BENCHMARK(BM_NaiveFft2)->Arg(512)->Arg(1024)->Arg(2048);
+BENCHMARK(BM_Fft2)->ArgsProduct({{512, 1024, 2048}, {0, 2, 3}, {1, 4}});
+BENCHMARK(BM_AngularSpectrum)->Arg(512)->Arg(1024)->Arg(2048);
+// NOLINTEND
+
+} // namespace holoflow
+
+BENCHMARK_MAIN();
@@ -0,0 +1,157 @@
+#include "holoflow/tensor/reduce.hh"
+#include "holoflow/tensor/tensor.hh"
+#include "holoflow/tensor/thread_pool.hh"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace holoflow {
+
+constexpr size_t FRAME_SIZE = 512;
+constexpr size_t BATCH_SIZE = 64;
+
+/// Returns a dense batch of 64 512x512 f32 frames over `buffer`.
+static Tensor make_batch(std::vector<float> &buffer) {
+  buffer.resize(BATCH_SIZE * FRAME_SIZE * FRAME_SIZE);
+  for (size_t i = 0; i < buffer.size(); i++)
+    buffer[i] = static_cast<float>(i % 4096);
+  return Tensor(TensorDescriptor(DType::F32,
+                                 {BATCH_SIZE, FRAME_SIZE, FRAME_SIZE},
+                                 {FRAME_SIZE * FRAME_SIZE * sizeof(float),
+                                  FRAME_SIZE * sizeof(float), sizeof(float)}),
+                reinterpret_cast<std::byte *>(buffer.data()));
+}
+
+static void set_items_processed(benchmark::State &state) {
+  state.SetItemsProcessed(
+      static_cast<int64_t>(state.iterations()) *
+      static_cast<int64_t>(BATCH_SIZE * FRAME_SIZE * FRAME_SIZE));
+}
+
+/// Returns the options of `state`: the `SimdLevel` in `state.range(0)` and
+/// the number of threads in `state.range(1)`.
+static ReduceOptions make_options(benchmark::State &state, ThreadPool &pool) {
+  ReduceOptions options{
+      .pool = &pool,
+      .max_simd_level = static_cast<SimdLevel>(state.range(0))};
+  state.SetLabel(std::string(simd_level_name(
+                     simd_level(options.max_simd_level))) +
+                 ", " + std::to_string(pool.size()) + " threads");
+  return options;
+}
+
+// Computes the sum, min, max, mean and variance of a batch in a plain loop, as
+// the statistics step did.
+static void BM_NaiveStats(benchmark::State &state) {
+  std::vector<float> buffer;
+  Tensor batch = make_batch(buffer);
+
+  for (auto _ : state) {
+    const auto *values = reinterpret_cast<const float *>(batch.raw_data());
+    double sum = 0;
+    double sum_squares = 0;
+    float min = std::numeric_limits<float>::infinity();
+    float max = -std::numeric_limits<float>::infinity();
+    for (size_t i = 0; i < buffer.size(); i++) {
+      sum += values[i];
+      sum_squares += static_cast<double>(values[i]) * values[i];
+      min = std::min(min, values[i]);
+      max = std::max(max, values[i]);
+    }
+    double mean = sum / static_cast<double>(buffer.size());
+    double variance =
+        sum_squares / static_cast<double>(buffer.size()) - mean * mean;
+    benchmark::DoNotOptimize(variance);
+    benchmark::DoNotOptimize(min);
+    benchmark::DoNotOptimize(max);
+  }
+  set_items_processed(state);
+}
+
+// Computes the statistics of a batch with `stats()`.
+static void BM_Stats(benchmark::State &state) {
+  std::vector<float> buffer;
+  Tensor batch = make_batch(buffer);
+  ThreadPool pool(static_cast<size_t>(state.range(1)));
+  ReduceOptions options = make_options(state, pool);
+
+  for (auto _ : state) {
+    TensorStats result = stats(batch, options);
+    benchmark::DoNotOptimize(result);
+  }
+  set_items_processed(state);
+}
+
+// Averages a batch into one frame in a plain loop, frame after frame.
+static void BM_NaiveTemporalMean(benchmark::State &state) {
+  std::vector<float> buffer;
+  Tensor batch = make_batch(buffer);
+  std::vector<float> frame(FRAME_SIZE * FRAME_SIZE);
+
+  for (auto _ : state) {
+    const auto *values = reinterpret_cast<const float *>(batch.raw_data());
+    for (size_t i = 0; i < frame.size(); i++) {
+      double sum = 0;
+      for (size_t t = 0; t < BATCH_SIZE; t++)
+        sum += values[t * frame.size() + i];
+      frame[i] = static_cast<float>(sum / BATCH_SIZE);
+    }
+    benchmark::ClobberMemory();
+  }
+  set_items_processed(state);
+}
+
+// Averages a batch into one frame with `mean()`.
+static void BM_TemporalMean(benchmark::State &state) {
+  std::vector<float> buffer;
+  Tensor batch = make_batch(buffer);
+  std::vector<float> frame_buffer(FRAME_SIZE * FRAME_SIZE);
+  Tensor frame(TensorDescriptor(DType::F32, {FRAME_SIZE, FRAME_SIZE},
+                                {FRAME_SIZE * sizeof(float), sizeof(float)}),
+               reinterpret_cast<std::byte *>(frame_buffer.data()));
+  ThreadPool pool(static_cast<size_t>(state.range(1)));
+  ReduceOptions options = make_options(state, pool);
+
+  for (auto _ : state) {
+    mean(batch, 0, frame, options);
+    benchmark::ClobberMemory();
+  }
+  set_items_processed(state);
+}
+
+// Sums each row of each frame of a batch into a profile with `sum()`.
+static void BM_RowProfiles(benchmark::State &state) {
+  std::vector<float> buffer;
+  Tensor batch = make_batch(buffer);
+  std::vector<double> profile_buffer(BATCH_SIZE * FRAME_SIZE);
+  Tensor profiles(TensorDescriptor(DType::F64, {BATCH_SIZE, FRAME_SIZE},
+                                   {FRAME_SIZE * sizeof(double),
+                                    sizeof(double)}),
+                  reinterpret_cast<std::byte *>(profile_buffer.data()));
+  ThreadPool pool(static_cast<size_t>(state.range(1)));
+  ReduceOptions options = make_options(state, pool);
+
+  for (auto _ : state) {
+    sum(batch, 2, profiles, options);
+    benchmark::ClobberMemory();
+  }
+  set_items_processed(state);
+}
+
+// NOLINTBEGIN
+BENCHMARK(BM_NaiveStats);
+BENCHMARK(BM_Stats)->ArgsProduct({{0, 1, 2, 3}, {1, 4}});
+BENCHMARK(BM_NaiveTemporalMean);
+BENCHMARK(BM_TemporalMean)->ArgsProduct({{0, 2, 3}, {1, 4}});
+BENCHMARK(BM_RowProfiles)->ArgsProduct({{0, 2, 3}, {1, 4}});
+// NOLINTEND
+
+} // namespace holoflow
+
+BENCHMARK_MAIN();
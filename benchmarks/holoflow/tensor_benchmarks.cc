@@ -0,0 +1,122 @@
+#include "holoflow/tensor/descriptor.hh"
+#include "holoflow/tensor/tensor.hh"
+#include "holoflow/tensor/tensor_view.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace holoflow {
+
+// Builds the descriptor of a dense tensor of `state.range(0)` dimensions of 4
+// `float`, as every stage does for the batches it outputs.
+static void BM_DescriptorConstruction(benchmark::State &state) {
+  const size_t rank = static_cast<size_t>(state.range(0));
+
+  for (auto _ : state) {
+    Dims shape;
+    Dims strides;
+    for (size_t i = 0; i < rank; i++) {
+      shape.push_back(4);
+      strides.push_back(0);
+    }
+    size_t stride = sizeof(float);
+    for (size_t i = rank; i-- > 0;) {
+      strides[i] = stride;
+      stride *= shape[i];
+    }
+
+    TensorDescriptor desc(DType::F32, shape, strides);
+    benchmark::DoNotOptimize(desc);
+  }
+}
+
+// Copies a tensor, as passing one by value between stages does.
+static void BM_TensorCopy(benchmark::State &state) {
+  std::vector<std::byte> buffer(4 * 512 * 512 * sizeof(float));
+  Tensor tensor(TensorDescriptor(DType::F32, {4, 512, 512},
+                                 {512 * 512 * 4, 512 * 4, 4}),
+                buffer.data());
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(tensor);
+    Tensor copy = tensor;
+    benchmark::DoNotOptimize(copy);
+  }
+}
+
+constexpr size_t FRAME_SIZE = 512;
+
+/// Returns a dense 512x512 `float` frame over `buffer`.
+static Tensor make_frame(std::vector<float> &buffer) {
+  buffer.assign(FRAME_SIZE * FRAME_SIZE, 1.0f);
+  return Tensor(TensorDescriptor(DType::F32, {FRAME_SIZE, FRAME_SIZE},
+                                 {FRAME_SIZE * sizeof(float), sizeof(float)}),
+                reinterpret_cast<std::byte *>(buffer.data()));
+}
+
+// Sums a frame through `Tensor::data<T>()`, checked on every access.
+static void BM_SumChecked(benchmark::State &state) {
+  std::vector<float> buffer;
+  Tensor frame = make_frame(buffer);
+
+  for (auto _ : state) {
+    float sum = 0;
+    for (size_t i = 0; i < FRAME_SIZE; i++)
+      for (size_t j = 0; j < FRAME_SIZE; j++)
+        sum += frame.data<float>()[i * FRAME_SIZE + j];
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(buffer.size() * sizeof(float)));
+}
+
+// Sums a frame through a strided `TensorView`.
+static void BM_SumView(benchmark::State &state) {
+  std::vector<float> buffer;
+  Tensor frame = make_frame(buffer);
+  TensorView<const float, 2> view(frame);
+
+  for (auto _ : state) {
+    float sum = 0;
+    for (size_t i = 0; i < view.shape(0); i++)
+      for (size_t j = 0; j < view.shape(1); j++)
+        sum += view(i, j);
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(buffer.size() * sizeof(float)));
+}
+
+// Sums a frame row by row through a `ContiguousTensorView`.
+static void BM_SumContiguousView(benchmark::State &state) {
+  std::vector<float> buffer;
+  Tensor frame = make_frame(buffer);
+  ContiguousTensorView<const float, 2> view(frame);
+
+  for (auto _ : state) {
+    float sum = 0;
+    for (size_t i = 0; i < view.shape(0); i++) {
+      const float *row = view.row(i);
+      for (size_t j = 0; j < view.shape(1); j++)
+        sum += row[j];
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(buffer.size() * sizeof(float)));
+}
+
+// NOLINTBEGIN
+BENCHMARK(BM_DescriptorConstruction)->DenseRange(1, 4);
+BENCHMARK(BM_TensorCopy);
+BENCHMARK(BM_SumChecked);
+BENCHMARK(BM_SumView);
+BENCHMARK(BM_SumContiguousView);
+// NOLINTEND
+
+} // namespace holoflow
+
+BENCHMARK_MAIN();
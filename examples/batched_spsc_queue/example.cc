@@ -1,8 +1,9 @@
 #include "batched_spsc_queue/batched_spsc_queue.hh"
+#include "batched_spsc_queue/queue_buffer.hh"
 
 #include <cstdint>
 #include <thread>
-#include <vector>
+#include <utility>
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-variable"
@@ -14,20 +15,26 @@ int main() {
   constexpr size_t element_size = 512 * 512; // An image of 512x512 pixels.
   constexpr size_t buffer_size = nb_slots * element_size;
 
+  // The queue owns a page-aligned buffer backed by huge pages and faulted in
+  // up front. One can also pass a pointer to any pre-allocated memory block.
+  holoflow::QueueBuffer buffer = holoflow::QueueBuffer::allocate(
+      buffer_size, {holoflow::HugePages::Transparent, -1, true});
+
   // Note: The actual capacity of the queue is nb_slots - enqueue_batch_size.
   // In this example, the queue can hold 996 elements.
-  std::vector<uint8_t> buffer(buffer_size);
   holoflow::BatchedSPSCQueue queue(nb_slots, enqueue_batch_size,
                                    dequeue_batch_size, element_size,
-                                   buffer.data());
+                                   std::move(buffer));
+
+  // Both threads sleep instead of busy polling when there is nothing to do.
+  queue.set_wait_strategy({holoflow::WaitPolicy::SpinPark});
 
   // Enqueue thread.
   std::thread enqueue_thread([&queue]() {
     while (true) {
-      // Try to get a write pointer.
-      auto write_ptr = queue.write_ptr();
-      if (!write_ptr)
-        continue; // Queue is full.
+      // Wait for a write pointer. One can also poll `write_ptr()`, which
+      // returns `nullptr` if the queue is full.
+      auto write_ptr = queue.wait_write_ptr();
 
       // Write data to the buffer.
       write_ptr[0] = 0;
@@ -42,10 +49,9 @@ int main() {
   // Dequeue thread.
   std::thread dequeue_thread([&queue]() {
     while (true) {
-      // Try to get a read pointer.
-      auto read_ptr = queue.read_ptr();
-      if (!read_ptr)
-        continue; // Queue is empty.
+      // Wait for a read pointer. One can also poll `read_ptr()`, which
+      // returns `nullptr` if the queue is empty.
+      auto read_ptr = queue.wait_read_ptr();
 
       // Read the data from the buffer.
       uint8_t data0 = read_ptr[0];
@@ -1,4 +1,5 @@
 #include "holoflow/tensor/tensor.hh"
+#include "holoflow/tensor/tensor_view.hh"
 
 #include <cstdint>
 #include <iostream>
@@ -10,8 +11,7 @@
 
 int main() {
   // Define a tensor descriptor for a 4x4 matrix of uint16_t elements.
-  holoflow::TensorDescriptor desc{
-      "uint16_t", sizeof(uint16_t), {4, 4}, {16, 4}};
+  holoflow::TensorDescriptor desc{holoflow::DType::U16, {4, 4}, {16, 4}};
 
   // Allocate buffer.
   auto buffer = std::make_unique<std::byte[]>(desc.size_in_bytes());
@@ -19,22 +19,22 @@ int main() {
   // Create a tensor using the descriptor and the buffer.
   holoflow::Tensor tensor(desc, buffer.get());
 
-  // Access the raw data of the tensor as uint16_t.
-  uint16_t *tensor_data = tensor.data<uint16_t>();
+  // View the data as a 2D array of uint16_t. The type and rank are checked
+  // once here, and the indexing follows the padded strides.
+  holoflow::TensorView<uint16_t, 2> view(tensor);
 
   // Initialize the tensor data with some values.
-  for (std::size_t i = 0; i < desc.shape()[0]; ++i) {
-    for (std::size_t j = 0; j < desc.shape()[1]; ++j) {
-      tensor_data[i * desc.shape()[1] + j] =
-          static_cast<uint16_t>(i * desc.shape()[1] + j);
+  for (std::size_t i = 0; i < view.shape(0); ++i) {
+    for (std::size_t j = 0; j < view.shape(1); ++j) {
+      view(i, j) = static_cast<uint16_t>(i * view.shape(1) + j);
     }
   }
 
   // Print the tensor values.
   std::cout << "Tensor values:\n";
-  for (std::size_t i = 0; i < desc.shape()[0]; ++i) {
-    for (std::size_t j = 0; j < desc.shape()[1]; ++j) {
-      std::cout << tensor_data[i * desc.shape()[1] + j] << " ";
+  for (std::size_t i = 0; i < view.shape(0); ++i) {
+    for (std::size_t j = 0; j < view.shape(1); ++j) {
+      std::cout << view(i, j) << " ";
     }
     std::cout << "\n";
   }
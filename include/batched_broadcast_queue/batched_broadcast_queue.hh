@@ -0,0 +1,207 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#ifndef CACHE_LINE_SIZE
+#define CACHE_LINE_SIZE 64
+#endif
+
+namespace holoflow {
+/**
+ * @brief Describes one consumer of a `BatchedBroadcastQueue`.
+ */
+struct BroadcastConsumerOptions {
+  /// The number of elements dequeued in a single batch by this consumer.
+  size_t dequeue_batch_size;
+
+  /// Whether the producer may overrun this consumer instead of waiting for
+  /// it. A lossy consumer that falls behind skips to the latest batch.
+  bool lossy = false;
+};
+
+/**
+ * @class BatchedBroadcastQueue
+ * @brief A lock-free, single-producer multi-consumer broadcast queue designed
+ * for batched operations.
+ *
+ * Every element enqueued by the producer is seen by every consumer, without
+ * being copied: all consumers read the same circular buffer, each with its own
+ * read index and its own dequeue batch size. The acquire/commit pattern and
+ * the batch contiguity guarantee are the ones of `BatchedSPSCQueue`.
+ *
+ * The producer's free space is bounded by the slowest non-lossy consumer.
+ * Lossy consumers, such as a display, never throttle the producer: when one
+ * falls too far behind, `read_ptr()` skips it forward to the latest complete
+ * batch, and `commit_read()` tells whether the producer overwrote the batch
+ * while it was being read, in which case its content must be discarded.
+ *
+ * @note The capacity of the queue is `nb_slots`.
+ *
+ * @warning The queue is subject to the following constraints, if not respected,
+ * the behavior is undefined:
+ * - The number of slots must be a multiple of the enqueue batch size and of
+ * every dequeue batch size.
+ * - For every lossy consumer, the number of slots must be at least
+ * `enqueue_batch_size + 2 * dequeue_batch_size`.
+ * - The buffer must be pre-allocated with a size of at least
+ * `nb_slots * element_size`
+ * - A single thread must be used for enqueue operations.
+ * - A single thread must be used for the dequeue operations of each consumer.
+ * - Each call to commit_write() must be preceded by a call to write_ptr().
+ * - The whole batch must be written before committing the write operation.
+ * - Each call to commit_read() must be preceded by a call to read_ptr() for the
+ * same consumer.
+ * - The pointer returned by read_ptr() must not be used after commit_read() has
+ * been called.
+ */
+class BatchedBroadcastQueue {
+public:
+  /**
+   * @brief Constructs a new `BatchedBroadcastQueue` object.
+   *
+   * @param nb_slots The number of slots in the circular buffer. Must be a
+   * multiple of `enqueue_batch_size` and of every dequeue batch size.
+   *
+   * @param enqueue_batch_size The number of elements that are enqueued in a
+   * single batch.
+   *
+   * @param element_size The size of each element in bytes.
+   *
+   * @param buffer A pre-allocated memory block for storing elements. The buffer
+   * must be allocated with a size of at least `nb_slots * element_size` bytes.
+   *
+   * @param consumers One entry per consumer. Consumers are then designated by
+   * their index in this vector.
+   */
+  BatchedBroadcastQueue(size_t nb_slots, size_t enqueue_batch_size,
+                        size_t element_size, uint8_t *buffer,
+                        const std::vector<BroadcastConsumerOptions> &consumers);
+
+  /**
+   * @brief Returns a pointer to the next batch of elements to be written.
+   *
+   * @return A pointer to the next batch of elements to be written, if every
+   * non-lossy consumer has read enough. Otherwise, returns `nullptr`.
+   *
+   * @see BatchedSPSCQueue::write_ptr()
+   */
+  uint8_t *write_ptr();
+
+  /**
+   * @brief Commits the write operation.
+   *
+   * @see BatchedSPSCQueue::commit_write()
+   */
+  void commit_write();
+
+  /**
+   * @brief Returns a pointer to the next batch of elements to be read by a
+   * consumer.
+   *
+   * For a lossy consumer that was overrun, the skipped elements are counted in
+   * `skipped()`.
+   *
+   * @param consumer The index of the consumer.
+   * @return A pointer to the next batch of elements to be read, if the queue
+   * has enough elements for this consumer. Otherwise, returns `nullptr`.
+   *
+   * @see BatchedSPSCQueue::read_ptr()
+   */
+  uint8_t *read_ptr(size_t consumer);
+
+  /**
+   * @brief Commits the read operation of a consumer.
+   *
+   * @param consumer The index of the consumer.
+   * @return `true` if the batch was read intact. Always `true` for a non-lossy
+   * consumer. For a lossy consumer, `false` means the producer overwrote the
+   * batch while it was being read and what was read must be discarded.
+   *
+   * @see BatchedSPSCQueue::commit_read()
+   */
+  bool commit_read(size_t consumer);
+
+  /**
+   * @brief Returns the number of elements a consumer has not read yet.
+   *
+   * @param consumer The index of the consumer.
+   * @return The number of elements in the queue for this consumer.
+   */
+  size_t size(size_t consumer);
+
+  /**
+   * @brief Returns the number of elements a lossy consumer skipped because it
+   * was overrun.
+   *
+   * Can be called from any thread.
+   *
+   * @param consumer The index of the consumer.
+   */
+  size_t skipped(size_t consumer) const;
+
+  /// Returns the number of consumers.
+  size_t nb_consumers() const;
+
+private:
+  /// The state of a consumer, on its own cache lines.
+  struct alignas(CACHE_LINE_SIZE) Consumer {
+    /// The position of the next element to read, never wrapped.
+    std::atomic<size_t> read_pos;
+
+    /// The number of elements dequeued in a single batch.
+    size_t dequeue_batch_size;
+
+    /// Whether the producer may overrun this consumer.
+    bool lossy;
+
+    /// The consumer's private copy of `write_pos_`.
+    size_t cached_write_pos;
+
+    /// The number of elements skipped because of overruns.
+    std::atomic<size_t> skipped;
+  };
+
+  /**
+   * @brief Returns the smallest read position of the non-lossy consumers, or
+   * `write_pos` if there are none.
+   */
+  size_t min_read_pos(size_t write_pos) const;
+
+private:
+  /// The number of slots in the circular buffer.
+  size_t nb_slots_;
+
+  /// The number of elements to be enqueued in a single batch.
+  size_t enqueue_batch_size_;
+
+  /// The size of each element in bytes.
+  size_t element_size_;
+
+  /// A pre-allocated memory block for storing elements.
+  uint8_t *buffer_;
+
+  /// The number of consumers.
+  size_t nb_consumers_;
+
+  /// The consumers.
+  std::unique_ptr<Consumer[]> consumers_;
+
+  /// Whether at least one consumer is lossy.
+  bool has_lossy_;
+
+  /// The position of the next element to write, never wrapped.
+  alignas(CACHE_LINE_SIZE) std::atomic<size_t> write_pos_;
+
+  /// The end of the batch the producer may be writing. Lossy consumers check
+  /// it after reading to detect an overrun.
+  std::atomic<size_t> reserved_pos_;
+
+  /// The writer's private copy of the smallest non-lossy read position.
+  alignas(CACHE_LINE_SIZE) size_t cached_min_read_pos_;
+};
+
+} // namespace holoflow
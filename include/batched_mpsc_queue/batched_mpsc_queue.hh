@@ -0,0 +1,189 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#ifndef CACHE_LINE_SIZE
+#define CACHE_LINE_SIZE 64
+#endif
+
+namespace holoflow {
+/**
+ * @class BatchedMPSCQueue
+ * @brief A lock-free, multi-producer single-consumer (MPSC) queue designed for
+ * batched operations.
+ *
+ * This is the fan-in counterpart of `BatchedSPSCQueue`: several producer
+ * threads enqueue batches of elements and a single consumer thread dequeues
+ * batches of elements, with the same acquire/commit pattern and the same
+ * guarantee that a batch is always contiguous in memory.
+ *
+ * A producer reserves a whole enqueue batch with a single compare-and-swap on
+ * the shared reservation index, writes it, and then commits it. Producers may
+ * commit their batches in any order, but the consumer only sees a batch once
+ * it and every batch reserved before it are committed, so the consumer always
+ * reads batches in reservation order.
+ *
+ * Each enqueue batch has a sequence number on its own cache line, which tells
+ * whether it is free, reserved or committed for a given lap of the circular
+ * buffer. Producers committing neighbouring batches therefore never write to
+ * the same cache line.
+ *
+ * @note Unlike `BatchedSPSCQueue`, the capacity of the queue is `nb_slots`.
+ *
+ * @warning The queue is subject to the following constraints, if not respected,
+ * the behavior is undefined:
+ * - The buffer must be pre-allocated with a size of at least
+ * `nb_slots * element_size`
+ * - Any number of threads can enqueue, but each call to `commit_write()` must
+ * be made by the thread that got the pointer from `write_ptr()`.
+ * - A single thread must be used for dequeue operations.
+ * - The whole batch must be written before committing the write operation.
+ * - A pointer returned by write_ptr() must be committed exactly once. Unlike
+ * `BatchedSPSCQueue`, a write cannot be cancelled, because the consumer waits
+ * for every reserved batch in order.
+ * - Each call to commit_read() must be preceded by a call to read_ptr().
+ * - The pointer returned by read_ptr() must not be used after commit_read() has
+ * been called.
+ */
+class BatchedMPSCQueue {
+public:
+  /**
+   * @brief Constructs a new `BatchedMPSCQueue` object.
+   *
+   * @param nb_slots The number of slots in the circular buffer. Must be a
+   * multiple of `enqueue_batch_size` and `dequeue_batch_size`, and hold at
+   * least two enqueue batches.
+   *
+   * @param enqueue_batch_size The number of elements that are enqueued in a
+   * single batch. Must be non-zero.
+   *
+   * @param dequeue_batch_size The number of elements that are dequeued in a
+   * single batch. Must be non-zero.
+   *
+   * @param element_size The size of each element in bytes.
+   *
+   * @param buffer A pre-allocated memory block for storing elements. The buffer
+   * must be allocated with a size of at least `nb_slots * element_size` bytes.
+   *
+   * @throw std::invalid_argument If the batch sizes do not match the
+   * constraints above.
+   */
+  BatchedMPSCQueue(size_t nb_slots, size_t enqueue_batch_size,
+                   size_t dequeue_batch_size, size_t element_size,
+                   uint8_t *buffer);
+
+  /**
+   * @brief Reserves the next batch of elements to be written.
+   *
+   * Can be called concurrently by any number of producers.
+   *
+   * @return A pointer to the reserved batch, if the queue has enough capacity.
+   * Otherwise, returns `nullptr`.
+   *
+   * @warning A non-null pointer must be committed with `commit_write()`.
+   */
+  uint8_t *write_ptr();
+
+  /**
+   * @brief Commits a batch reserved with `write_ptr()`.
+   *
+   * @param write_ptr The pointer returned by `write_ptr()`.
+   *
+   * @warning This method will lead to undefined behavior if the following
+   * constraints are not respected:
+   * - `write_ptr` must have been returned by `write_ptr()` and not be committed
+   * yet.
+   * - The pointer must not be used after calling this method.
+   * - The whole batch must be written before committing the write operation.
+   */
+  void commit_write(uint8_t *write_ptr);
+
+  /**
+   * @brief Returns a pointer to the next batch of elements to be read.
+   *
+   * @return A pointer to the next batch of elements to be read, if every
+   * enqueue batch it overlaps is committed. Otherwise, returns `nullptr`.
+   *
+   * @note Not calling `commit_read()` after calling this method does not lead
+   * to undefined behavior. This can be leveraged to cancel the dequeue
+   * operation.
+   *
+   * @warning The pointer returned by this method must not be used after calling
+   * `commit_read()`.
+   */
+  uint8_t *read_ptr();
+
+  /**
+   * @brief Commits the read operation.
+   *
+   * @warning This method will lead to undefined behavior if the following
+   * constraints are not respected:
+   * - Each call to this method must be preceded by a successful call to
+   * `read_ptr()`.
+   * - The pointer returned by `read_ptr()` must not be used after calling this
+   * method.
+   */
+  void commit_read();
+
+  /**
+   * @brief Returns the number of elements reserved by producers and not read
+   * yet, whether they are committed or not.
+   *
+   * @return The number of elements in the queue.
+   */
+  size_t size();
+
+private:
+  /**
+   * @brief Checks the batch sizes of a queue.
+   *
+   * @return The number of enqueue batches in the circular buffer.
+   *
+   * @throw std::invalid_argument If they do not fit `nb_slots`.
+   */
+  static size_t check_geometry(size_t nb_slots, size_t enqueue_batch_size,
+                               size_t dequeue_batch_size);
+
+  /// The sequence number of an enqueue batch, on its own cache line.
+  struct alignas(CACHE_LINE_SIZE) Slot {
+    /// Equals the batch position when free, position + 1 when committed.
+    std::atomic<size_t> seq;
+  };
+
+  /// The number of slots in the circular buffer.
+  size_t nb_slots_;
+
+  /// The number of elements to be enqueued in a single batch.
+  size_t enqueue_batch_size_;
+
+  /// The number of elements to be dequeued in a single batch.
+  size_t dequeue_batch_size_;
+
+  /// The size of each element in bytes.
+  size_t element_size_;
+
+  /// The number of enqueue batches in the circular buffer.
+  size_t nb_batches_;
+
+  /// A pre-allocated memory block for storing elements.
+  uint8_t *buffer_;
+
+  /// One sequence number per enqueue batch.
+  std::unique_ptr<Slot[]> slots_;
+
+  /// The position of the next enqueue batch to reserve. Positions are never
+  /// wrapped, the slot of position `p` is `p % nb_batches_`.
+  alignas(CACHE_LINE_SIZE) std::atomic<size_t> write_pos_;
+
+  /// The position of the next element to read, never wrapped.
+  alignas(CACHE_LINE_SIZE) std::atomic<size_t> read_pos_;
+
+  /// The reader's count of enqueue batches known to be committed, so that each
+  /// sequence number is only checked once.
+  size_t committed_batches_;
+};
+
+} // namespace holoflow
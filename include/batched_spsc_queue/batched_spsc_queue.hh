@@ -1,16 +1,92 @@
 #pragma once
 
+#include "batched_spsc_queue/queue_buffer.hh"
+
+#include <array>
 #include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <optional>
 #include <span>
+#include <string>
 
 #ifndef CACHE_LINE_SIZE
 #define CACHE_LINE_SIZE 64
 #endif
 
 namespace holoflow {
+/**
+ * @brief How a blocking call waits for the queue to become ready.
+ */
+enum class WaitPolicy {
+  /// Busy-poll the queue. Lowest latency, keeps a full core busy.
+  Spin,
+
+  /// Busy-poll the queue for a while, then yield the CPU between polls.
+  SpinYield,
+
+  /// Busy-poll, then yield, then put the thread to sleep until the other side
+  /// commits.
+  SpinPark,
+};
+
+/**
+ * @brief Configures how the blocking calls of `BatchedSPSCQueue` wait.
+ */
+struct WaitStrategy {
+  /// The waiting policy.
+  WaitPolicy policy = WaitPolicy::Spin;
+
+  /// The number of busy polls before yielding or parking.
+  size_t spin_iterations = 1024;
+
+  /// The number of yielding polls before parking. Only used by
+  /// `WaitPolicy::SpinPark`.
+  size_t yield_iterations = 64;
+};
+
+/// The number of buckets of `QueueTelemetry::occupancy_histogram`.
+constexpr size_t QUEUE_OCCUPANCY_BUCKETS = 8;
+
+/// The number of committed batches between two occupancy samples.
+constexpr size_t QUEUE_OCCUPANCY_SAMPLE_PERIOD = 64;
+
+/**
+ * @brief A snapshot of the counters of a `BatchedSPSCQueue`.
+ *
+ * The counters are only maintained when the library is built with
+ * `HOLOFLOW_QUEUE_TELEMETRY` defined (CMake option `ENABLE_QUEUE_TELEMETRY`).
+ * Otherwise, every counter is zero.
+ */
+struct QueueTelemetry {
+  /// Whether the counters are maintained.
+  bool enabled = false;
+
+  /// The number of calls to `write_ptr()` or `write_span()` that found the
+  /// queue full, including the polls of `wait_write_ptr()`.
+  uint64_t write_stalls = 0;
+
+  /// The number of calls to `read_ptr()` or `read_span()` that found the
+  /// queue empty, including the polls of `wait_read_ptr()`.
+  uint64_t read_stalls = 0;
+
+  /// The number of committed enqueue batches.
+  uint64_t write_batches = 0;
+
+  /// The number of committed dequeue batches.
+  uint64_t read_batches = 0;
+
+  /// The largest number of elements the producer has seen in the queue.
+  size_t high_water_mark = 0;
+
+  /// Occupancy sampled by the producer every
+  /// `QUEUE_OCCUPANCY_SAMPLE_PERIOD` enqueue batches. Bucket `i` counts the
+  /// samples with an occupancy in `[i, i + 1) * nb_slots / buckets`.
+  std::array<uint64_t, QUEUE_OCCUPANCY_BUCKETS> occupancy_histogram = {};
+};
+
 /**
  * @class BatchedSPSCQueue
  * @brief A high-performance, lock-free, single-producer single-consumer (SPSC)
@@ -41,7 +117,7 @@ namespace holoflow {
  * @warning The queue is subject to the following constraints, if not respected,
  * the behavior is undefined:
  * - The number of slots must be a multiple of the enqueue and dequeue batch
- * sizes.
+ * sizes, unless the buffer is mirrored.
  * - The buffer must be pre-allocated with a size of at least
  * `nb_slots * element_size`
  * - A single thread must be used for enqueue operations.
@@ -54,6 +130,33 @@ namespace holoflow {
  * - The pointer returned by read_ptr() must not be used after commit_read() has
  * been called.
  *
+ * The queue can also own a mirrored `QueueBuffer`, whose pages are mapped
+ * twice back to back. Batches may then straddle the end of the circular buffer
+ * and still be contiguous, so the divisibility constraints below do not apply
+ * and the capacity is `nb_slots - 1` rounded down to a whole number of enqueue
+ * batches. The two batch sizes must then add up to at most `nb_slots`, so that
+ * the reader can always get a batch from a queue the writer sees as full.
+ *
+ * Both sides can either poll `write_ptr()`/`read_ptr()` until they return a
+ * non-null pointer, or call `wait_write_ptr()`/`wait_read_ptr()` which wait
+ * according to the queue's `WaitStrategy`. With `WaitPolicy::SpinPark`, a
+ * side that has nothing to do sleeps in the kernel and is woken up by the
+ * other side's next commit. The wake-up system call is only made when the
+ * other side is actually parked.
+ *
+ * A queue can also live in a named shared memory segment, created by one
+ * process with `create_shared()` and attached by another with
+ * `attach_shared()`. The control block and the elements are both in the
+ * segment, so elements cross the process boundary without being copied.
+ *
+ * When acquisition stops, the producer can `flush()` or `close()` the queue,
+ * and the consumer can then get a tail smaller than a dequeue batch with
+ * `read_ptr_partial()`.
+ *
+ * When built with `HOLOFLOW_QUEUE_TELEMETRY`, each side also counts its stalls
+ * and commits on its own cache line, and `telemetry()` reads them from any
+ * thread. See `QueueTelemetry`.
+ *
  * @warning The methods `reset()` and `fill()` are not thread-safe and should
  * not be called in production code. They are provided for testing and
  * benchmarking purposes only.
@@ -93,6 +196,83 @@ public:
                    size_t dequeue_batch_size, size_t element_size,
                    uint8_t *buffer);
 
+  /**
+   * @brief Constructs a new `BatchedSPSCQueue` object that owns its buffer.
+   *
+   * @param nb_slots The number of slots in the circular buffer.
+   *
+   * @param enqueue_batch_size The number of elements that are enqueued in a
+   * single batch. Must be lower than `nb_slots`.
+   *
+   * @param dequeue_batch_size The number of elements that are dequeued in a
+   * single batch. Must be lower than `nb_slots`.
+   *
+   * @param element_size The size of each element in bytes.
+   *
+   * @param buffer The buffer for storing elements. If it is mirrored, its size
+   * must be exactly `nb_slots * element_size` bytes and the batch sizes must
+   * add up to at most `nb_slots`. Otherwise, its size must be at least
+   * `nb_slots * element_size` bytes and `nb_slots` must be a multiple of both
+   * batch sizes.
+   *
+   * @throw std::invalid_argument If the buffer or the batch sizes do not match
+   * the constraints above.
+   */
+  BatchedSPSCQueue(size_t nb_slots, size_t enqueue_batch_size,
+                   size_t dequeue_batch_size, size_t element_size,
+                   QueueBuffer buffer);
+
+  /**
+   * @brief Creates a queue in a named shared memory segment, so that another
+   * process can attach to it with `attach_shared()`.
+   *
+   * The segment holds the control block of the queue (indexes and geometry)
+   * followed by the elements. The name is removed when the returned queue is
+   * destroyed, a process already attached keeps working.
+   *
+   * @param name The name of the segment, e.g. `/camera0`. See `shm_open(3)`.
+   * @param nb_slots The number of slots in the circular buffer. Must be a
+   * multiple of both batch sizes.
+   * @param enqueue_batch_size The number of elements that are enqueued in a
+   * single batch. Must be lower than `nb_slots`.
+   * @param dequeue_batch_size The number of elements that are dequeued in a
+   * single batch. Must be lower than `nb_slots`.
+   * @param element_size The size of each element in bytes.
+   * @return The queue.
+   *
+   * @throw std::invalid_argument If the batch sizes do not match the
+   * constraints above.
+   * @throw std::system_error If the segment already exists or could not be
+   * created.
+   *
+   * @warning Both processes must use the same build of the library and the
+   * same `WaitStrategy`, because each side only wakes the other side up if its
+   * own strategy parks.
+   */
+  static std::unique_ptr<BatchedSPSCQueue>
+  create_shared(const std::string &name, size_t nb_slots,
+                size_t enqueue_batch_size, size_t dequeue_batch_size,
+                size_t element_size);
+
+  /**
+   * @brief Attaches to a queue created by another process with
+   * `create_shared()`.
+   *
+   * The geometry is read from the segment. The attached queue resumes from the
+   * indexes found in the segment, so a consumer process can be restarted
+   * without disturbing the producer.
+   *
+   * @param name The name passed to `create_shared()`.
+   * @return The queue.
+   *
+   * @throw std::invalid_argument If the segment does not hold an initialized
+   * queue.
+   * @throw std::system_error If the segment does not exist or could not be
+   * mapped.
+   */
+  static std::unique_ptr<BatchedSPSCQueue>
+  attach_shared(const std::string &name);
+
   /**
    * @brief Returns a pointer to the next batch of elements to be written.
    *
@@ -153,6 +333,254 @@ public:
    */
   void commit_read();
 
+  /**
+   * @brief Returns the largest contiguous run of whole batches that can be
+   * written, up to `max_batches`.
+   *
+   * Unless the buffer is mirrored, the run never goes past the end of the
+   * circular buffer, so a producer that wants to fill every free slot may have
+   * to call this method twice around the wrap point.
+   *
+   * @param max_batches The maximum number of batches to acquire.
+   * @return The bytes of the acquired batches. The number of batches is
+   * `size() / (enqueue_batch_size * element_size)`. The span is empty if not
+   * even one batch can be written.
+   *
+   * @warning Same constraints as `write_ptr()`, with `commit_write(n)` instead
+   * of `commit_write()`.
+   */
+  std::span<uint8_t> write_span(size_t max_batches);
+
+  /**
+   * @brief Commits the write operation of `nb_batches` batches at once.
+   *
+   * @param nb_batches The number of batches to commit.
+   *
+   * @warning This method will lead to undefined behavior if the following
+   * constraints are not respected:
+   * - Each call to this method must be preceded by a call to `write_span()`
+   * that returned at least `nb_batches` batches, or to `write_ptr()` if
+   * `nb_batches` is 1.
+   * - The span returned by `write_span()` must not be used after calling this
+   * method.
+   * - The whole batches must be written before committing the write operation.
+   */
+  void commit_write(size_t nb_batches);
+
+  /**
+   * @brief Returns the largest contiguous run of whole batches that can be
+   * read, up to `max_batches`.
+   *
+   * This lets a consumer that fell behind drain its backlog with a single
+   * index update. Unless the buffer is mirrored, the run never goes past the
+   * end of the circular buffer.
+   *
+   * @param max_batches The maximum number of batches to acquire.
+   * @return The bytes of the acquired batches. The number of batches is
+   * `size() / (dequeue_batch_size * element_size)`. The span is empty if not
+   * even one batch can be read.
+   *
+   * @warning Same constraints as `read_ptr()`, with `commit_read(n)` instead of
+   * `commit_read()`.
+   */
+  std::span<uint8_t> read_span(size_t max_batches);
+
+  /**
+   * @brief Commits the read operation of `nb_batches` batches at once.
+   *
+   * @param nb_batches The number of batches to commit.
+   *
+   * @warning This method will lead to undefined behavior if the following
+   * constraints are not respected:
+   * - Each call to this method must be preceded by a call to `read_span()`
+   * that returned at least `nb_batches` batches, or to `read_ptr()` if
+   * `nb_batches` is 1.
+   * - The span returned by `read_span()` must not be used after calling this
+   * method.
+   */
+  void commit_read(size_t nb_batches);
+
+  /**
+   * @brief Makes every element committed so far readable by
+   * `read_ptr_partial()`, even if it does not complete a dequeue batch.
+   *
+   * The flush lasts until the next commit of the producer, so a tail is never
+   * split by elements written after the flush.
+   *
+   * @warning This method must be called by the producer thread.
+   */
+  void flush();
+
+  /**
+   * @brief Marks the end of the stream and flushes the queue.
+   *
+   * @warning This method must be called by the producer thread, which must not
+   * write to the queue afterwards.
+   */
+  void close();
+
+  /**
+   * @brief Returns whether the producer has called `close()`.
+   *
+   * A consumer that sees the queue closed, and then gets `nullptr` from
+   * `read_ptr_partial()`, has read the whole stream. `wait_read_ptr()` returns
+   * `nullptr` once the queue is closed and holds less than a batch.
+   */
+  bool is_closed() const;
+
+  /**
+   * @brief Returns a pointer to the next elements to be read, possibly fewer
+   * than a dequeue batch.
+   *
+   * If a whole batch is available, behaves like `read_ptr()`. Otherwise, the
+   * elements up to the next batch boundary are returned if they are all
+   * available, and the available elements are returned if the producer
+   * flushed them. The elements are contiguous and never cross a batch
+   * boundary, so the consumer gets back to whole batches after completing the
+   * current one.
+   *
+   * @param count Set to the number of elements that can be read, at most
+   * `dequeue_batch_size`.
+   * @return A pointer to the next elements to be read, or `nullptr` if there
+   * is nothing to read yet.
+   *
+   * @warning Same constraints as `read_ptr()`, with
+   * `commit_read_partial(count)` instead of `commit_read()`.
+   */
+  uint8_t *read_ptr_partial(size_t &count);
+
+  /**
+   * @brief Commits the read operation of `count` elements returned by
+   * `read_ptr_partial()`.
+   *
+   * As long as the read index is not back on a batch boundary, `read_ptr()`
+   * and `read_span()` find nothing to read, and the consumer must complete the
+   * batch with `read_ptr_partial()`.
+   *
+   * @param count The number of elements to commit, at most the count returned
+   * by `read_ptr_partial()`.
+   */
+  void commit_read_partial(size_t count);
+
+  /**
+   * @brief Waits until a batch can be written and returns a pointer to it.
+   *
+   * Waits according to the queue's `WaitStrategy`.
+   *
+   * @return A pointer to the next batch of elements to be written.
+   *
+   * @warning Same constraints as `write_ptr()`.
+   */
+  uint8_t *wait_write_ptr();
+
+  /**
+   * @brief Waits at most `timeout` until a batch can be written and returns a
+   * pointer to it.
+   *
+   * @param timeout The maximum duration to wait.
+   * @return A pointer to the next batch of elements to be written, or
+   * `nullptr` if the queue is still full after `timeout`.
+   *
+   * @warning Same constraints as `write_ptr()`.
+   */
+  uint8_t *wait_write_ptr(std::chrono::nanoseconds timeout);
+
+  /**
+   * @brief Waits until a batch can be read and returns a pointer to it.
+   *
+   * Waits according to the queue's `WaitStrategy`. Returns early if the queue
+   * is closed without a whole batch left, or if a batch was partially read,
+   * since only `read_ptr_partial()` can then read the next elements.
+   *
+   * @return A pointer to the next batch of elements to be read, or `nullptr`
+   * if the remaining elements must be read with `read_ptr_partial()`.
+   *
+   * @warning Same constraints as `read_ptr()`.
+   */
+  uint8_t *wait_read_ptr();
+
+  /**
+   * @brief Waits at most `timeout` until a batch can be read and returns a
+   * pointer to it.
+   *
+   * @param timeout The maximum duration to wait.
+   * @return A pointer to the next batch of elements to be read, or `nullptr`
+   * if the queue still does not hold a batch after `timeout`, or in the cases
+   * of `wait_read_ptr()`.
+   *
+   * @warning Same constraints as `read_ptr()`.
+   */
+  uint8_t *wait_read_ptr(std::chrono::nanoseconds timeout);
+
+  /**
+   * @brief Sets how `wait_write_ptr()` and `wait_read_ptr()` wait.
+   *
+   * With `WaitPolicy::SpinPark`, every commit also checks whether the other
+   * side is parked, which costs a full memory fence. The other policies leave
+   * the commit path untouched.
+   *
+   * @param strategy The wait strategy. Defaults to busy polling.
+   *
+   * @warning This method is not thread-safe. It must be called before the
+   * producer and consumer threads start using the queue.
+   */
+  void set_wait_strategy(const WaitStrategy &strategy);
+
+  /**
+   * @brief Requests a new enqueue batch size, without reallocating the buffer
+   * nor losing elements.
+   *
+   * The producer switches to the new size at the first commit that leaves the
+   * write index on a multiple of it, which happens at the latest when the
+   * index wraps around. Until then, `write_ptr()` keeps returning batches of
+   * the current size. A later request replaces a pending one.
+   *
+   * Can be called from any thread, or from the other process of a shared
+   * queue.
+   *
+   * @param enqueue_batch_size The new enqueue batch size. Must be non-zero,
+   * lower than `nb_slots` and 2^32 and, unless the buffer is mirrored, a
+   * divisor of `nb_slots`. If the buffer is mirrored, it must add up to at
+   * most `nb_slots` with both the current and the pending dequeue batch sizes,
+   * even when the dequeue size is requested concurrently.
+   *
+   * @throw std::invalid_argument If the size does not match the constraints
+   * above.
+   */
+  void request_enqueue_batch_size(size_t enqueue_batch_size);
+
+  /**
+   * @brief Requests a new dequeue batch size, without reallocating the buffer
+   * nor losing elements.
+   *
+   * The consumer switches to the new size at the first commit that leaves the
+   * read index on a multiple of it. Same rules as
+   * `request_enqueue_batch_size()`.
+   *
+   * @param dequeue_batch_size The new dequeue batch size.
+   *
+   * @throw std::invalid_argument If the size does not match the constraints of
+   * `request_enqueue_batch_size()`.
+   */
+  void request_dequeue_batch_size(size_t dequeue_batch_size);
+
+  /// Returns the size of each element in bytes.
+  size_t element_size() const;
+
+  /**
+   * @brief Returns the enqueue batch size currently used by the producer.
+   *
+   * @warning Must be called by the producer thread.
+   */
+  size_t enqueue_batch_size() const;
+
+  /**
+   * @brief Returns the dequeue batch size currently used by the consumer.
+   *
+   * @warning Must be called by the consumer thread.
+   */
+  size_t dequeue_batch_size() const;
+
   /**
    * @brief Returns the number of elements in the queue.
    *
@@ -160,6 +588,17 @@ public:
    */
   size_t size();
 
+  /**
+   * @brief Returns a snapshot of the queue's counters.
+   *
+   * Can be called from any thread. The counters are read one by one, so they
+   * may be slightly inconsistent with each other while the queue is in use.
+   *
+   * @return The counters, all zero unless the library is built with
+   * `HOLOFLOW_QUEUE_TELEMETRY`.
+   */
+  QueueTelemetry telemetry() const;
+
   /**
    * @brief Resets the queue.
    *
@@ -170,7 +609,10 @@ public:
   void reset();
 
   /**
-   * @brief Fills the queue.
+   * @brief Fills the queue with as many elements as the writer can ever
+   * enqueue, starting from the first slot. Like the fill of
+   * `StaticBatchedSPSCQueue`, this leaves `nb_slots - enqueue_batch_size`
+   * elements unless the buffer is mirrored.
    *
    * @warning This method is not thread-safe and should not be called in
    * production code. It is provided for testing and benchmarking purposes
@@ -180,22 +622,165 @@ public:
 
 private:
   /**
-   * @brief Returns the number of elements in the queue.
+   * @brief The state shared by the producer and the consumer.
+   *
+   * It only holds indexes and lock-free atomics, nothing that depends on the
+   * address it is mapped at, so that two processes can map it at different
+   * addresses. Each index is on its own cache line.
+   */
+  struct ControlBlock {
+    /// Identifies an initialized control block. Written last by the creator.
+    std::atomic<uint64_t> magic{0};
+
+    /// The geometry of the queue, read by the process that attaches. The
+    /// batch sizes are updated by their side when it switches to a new size.
+    size_t nb_slots = 0;
+    std::atomic<size_t> enqueue_batch_size{0};
+    std::atomic<size_t> dequeue_batch_size{0};
+    size_t element_size = 0;
+
+    /// The requested batch sizes, or 0 if there is no pending request: the
+    /// enqueue one in the low 32 bits, the dequeue one in the high 32 bits.
+    /// Sharing a word lets a request check the other side's and store its own
+    /// in a single compare-and-swap. Only checked by their side after a
+    /// commit, on a line that is rarely written.
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> pending_batch_sizes{0};
+
+    /// The current write index.
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> write_idx{0};
+
+    /// Whether the producer flushed and has not committed since. Shares the
+    /// cache line of `write_idx`, which the reader loads anyway.
+    std::atomic<bool> flushed{false};
+
+    /// Whether the producer closed the queue.
+    std::atomic<bool> closed{false};
+
+    /// The current read index.
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> read_idx{0};
+
+    /// Non-zero while the writer is parked in `wait_write_ptr()`. The writer
+    /// sleeps on this word and the reader clears it to wake it up.
+    alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> writer_parked{0};
+
+    /// Non-zero while the reader is parked in `wait_read_ptr()`. The reader
+    /// sleeps on this word and the writer clears it to wake it up.
+    alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> reader_parked{0};
+  };
+
+  /**
+   * @brief Returns the size of the control block at the start of a shared
+   * segment, rounded up so that the elements start on a page boundary.
+   */
+  static size_t control_size();
+
+  /**
+   * @brief Checks the batch sizes of a queue that owns its buffer.
    *
-   * @warning This method is only thread-safe for the writer thread.
+   * @throw std::invalid_argument If they do not fit `nb_slots`.
+   */
+  static void check_geometry(size_t nb_slots, size_t enqueue_batch_size,
+                             size_t dequeue_batch_size, bool mirrored);
+
+  /**
+   * @brief Checks a batch size requested for one side.
    *
-   * @return The number of elements in the queue.
+   * @param batch_size The requested batch size.
+   * @param other_batch_size The batch size of the other side.
+   * @param other_pending_batch_size The pending batch size of the other side,
+   * or 0.
+   *
+   * @throw std::invalid_argument If it does not fit the queue.
    */
-  size_t writer_size();
+  void check_batch_size(size_t batch_size, size_t other_batch_size,
+                        size_t other_pending_batch_size) const;
 
   /**
-   * @brief Returns the number of elements in the queue.
+   * @brief Stores the pending batch size of one side, checked against the
+   * other side's sizes as they are when it is stored.
+   *
+   * @param batch_size The requested batch size.
+   * @param shift The position of the side in `pending_batch_sizes`.
+   * @param other_batch_size The batch size of the other side.
+   *
+   * @throw std::invalid_argument If it does not fit the queue.
+   */
+  void request_batch_size(size_t batch_size, unsigned shift,
+                          const std::atomic<size_t> &other_batch_size);
+
+  /**
+   * @brief Switches to the pending batch size of one side if `idx` is a
+   * multiple of it.
    *
-   * @warning This method is only thread-safe for the reader thread.
+   * @param shift The position of the side in `pending_batch_sizes`.
+   * @param batch_size The batch size of the side.
+   * @param shared_batch_size The copy of the batch size in the control block.
+   * @param idx The index of the side after its last commit.
+   * @return Whether the batch size was switched.
+   */
+  bool apply_batch_size(unsigned shift, size_t &batch_size,
+                        std::atomic<size_t> &shared_batch_size, size_t idx);
+
+  /**
+   * @brief Returns the number of elements between two indexes of the circular
+   * buffer.
    *
+   * @param write_idx The write index.
+   * @param read_idx The read index.
    * @return The number of elements in the queue.
    */
-  size_t reader_size();
+  size_t distance(size_t write_idx, size_t read_idx) const;
+
+  /**
+   * @brief Returns the index `nb_elements` after `idx`, wrapped around the
+   * circular buffer.
+   */
+  size_t advance(size_t idx, size_t nb_elements) const;
+
+  /**
+   * @brief Waits until `acquire` returns a non-null pointer or `deadline` is
+   * reached.
+   *
+   * @param acquire Either `write_ptr()` or `read_ptr()`.
+   * @param parked The flag the waiting side raises when it parks.
+   * @param deadline The deadline, or `nullptr` to wait forever.
+   * @param drain Whether to stop waiting once `read_ptr()` cannot return a
+   * batch anymore, because the queue is closed or a batch was partially read.
+   * @return The pointer returned by `acquire`, or `nullptr` on timeout or when
+   * draining.
+   */
+  uint8_t *wait(uint8_t *(BatchedSPSCQueue::*acquire)(),
+                std::atomic<uint32_t> &parked,
+                const std::chrono::steady_clock::time_point *deadline,
+                bool drain);
+
+  /**
+   * @brief Wakes up the other side if it is parked on `parked`.
+   *
+   * Must be called after the index store of a commit.
+   */
+  void notify(std::atomic<uint32_t> &parked);
+
+#ifdef HOLOFLOW_QUEUE_TELEMETRY
+  /**
+   * @brief Counts `nb_batches` enqueue batches committed up to `write_idx` and
+   * samples the occupancy when a sample period is crossed.
+   */
+  void record_write(size_t write_idx, size_t nb_batches);
+
+  /// The counters of one side. Only that side writes them, with plain
+  /// load/store pairs, so that counting costs no read-modify-write.
+  struct alignas(CACHE_LINE_SIZE) SideCounters {
+    std::atomic<uint64_t> stalls{0};
+    std::atomic<uint64_t> batches{0};
+  };
+
+  /// The occupancy counters, only written by the producer.
+  struct alignas(CACHE_LINE_SIZE) OccupancyCounters {
+    std::atomic<size_t> high_water_mark{0};
+    std::array<std::atomic<uint64_t>, QUEUE_OCCUPANCY_BUCKETS> histogram{};
+  };
+#endif
 
 private:
   /// The number of slots in the circular buffer.
@@ -213,11 +798,51 @@ private:
   /// A pre-allocated memory block for storing elements.
   uint8_t *buffer_;
 
-  /// The current write index.
-  alignas(CACHE_LINE_SIZE) std::atomic<size_t> write_idx_;
+  /// The buffer owned by the queue, if any.
+  QueueBuffer owned_buffer_;
+
+  /// Whether batches may straddle the end of the circular buffer.
+  bool mirrored_;
+
+  /// How the blocking calls wait.
+  WaitStrategy wait_strategy_;
+
+  /// Whether commits have to check for a parked peer.
+  bool parking_;
+
+  /// The state shared by both sides. Points to `local_control_`, or into a
+  /// shared memory segment.
+  ControlBlock *control_;
+
+  /// Whether the control block is shared with another process.
+  bool shared_;
 
-  /// The current read index.
-  alignas(CACHE_LINE_SIZE) std::atomic<size_t> read_idx_;
+  /// The writer's private copy of the read index. It is only refreshed when it
+  /// says the queue is full, so the writer does not pull the reader's cache
+  /// line on every call.
+  alignas(CACHE_LINE_SIZE) size_t cached_read_idx_;
+
+  /// The reader's private copy of the write index. It is only refreshed when
+  /// it says the queue is empty, so the reader does not pull the writer's
+  /// cache line on every call.
+  alignas(CACHE_LINE_SIZE) size_t cached_write_idx_;
+
+  /// Whether a partial read left the read index between two batch boundaries.
+  bool misaligned_;
+
+  /// The control block of a queue that is not shared.
+  ControlBlock local_control_;
+
+#ifdef HOLOFLOW_QUEUE_TELEMETRY
+  /// The producer's counters.
+  SideCounters writer_counters_;
+
+  /// The consumer's counters.
+  SideCounters reader_counters_;
+
+  /// The occupancy sampled by the producer.
+  OccupancyCounters occupancy_;
+#endif
 };
 
 } // namespace holoflow
@@ -0,0 +1,212 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace holoflow {
+/**
+ * @brief Which pages to request for a `QueueBuffer`.
+ */
+enum class HugePages {
+  /// Regular pages.
+  None,
+
+  /// Transparent huge pages, requested with `madvise(MADV_HUGEPAGE)`.
+  Transparent,
+
+  /// Pages from the explicit huge page pool (`MAP_HUGETLB`). Falls back to
+  /// transparent huge pages if the pool cannot satisfy the request.
+  Explicit,
+};
+
+/**
+ * @brief The pages a `QueueBuffer` actually got.
+ */
+enum class BufferBacking {
+  /// The buffer owns no memory.
+  None,
+
+  /// Regular pages.
+  Pages,
+
+  /// Regular pages with transparent huge pages enabled on the range. The
+  /// kernel may still back parts of it with regular pages.
+  TransparentHugePages,
+
+  /// Pages from the explicit huge page pool.
+  HugeTLB,
+};
+
+/**
+ * @brief Options of `QueueBuffer::allocate()`.
+ */
+struct BufferOptions {
+  /// Which pages to request.
+  HugePages huge_pages = HugePages::None;
+
+  /// The NUMA node to bind the memory to, or -1 to let the first touch decide.
+  int numa_node = -1;
+
+  /// Whether to fault every page in at allocation time, so that neither the
+  /// producer nor the consumer pays for it on the hot path.
+  bool prefault = false;
+};
+
+/**
+ * @class QueueBuffer
+ * @brief An owning memory block for the elements of a `BatchedSPSCQueue`.
+ *
+ * A `QueueBuffer` is created through one of its factories and then moved into
+ * the queue, which keeps it alive for as long as the queue exists.
+ *
+ * A mirrored buffer maps the same physical pages twice, back to back, so that
+ * `data()[i]` and `data()[size() + i]` are the same byte. A batch that starts
+ * before the end of the circular buffer and ends after it is therefore
+ * virtually contiguous, which lifts the batch-size divisibility constraints of
+ * the queue.
+ *
+ * An allocated buffer is a private anonymous mapping that can be backed by huge
+ * pages, bound to a NUMA node and pre-faulted. The options that cannot be
+ * honored fall back silently, and `backing()` and `numa_node()` report what
+ * was actually obtained.
+ *
+ * A shared buffer is a named POSIX shared memory segment, mapped by several
+ * processes. The process that creates it also removes its name when the buffer
+ * is destroyed, the memory itself lives until every process unmapped it.
+ *
+ * Every buffer is at least page-aligned.
+ */
+class QueueBuffer {
+public:
+  /**
+   * @brief Creates a mirrored buffer.
+   *
+   * The pages come from an anonymous memory file (`memfd_create`) mapped twice
+   * into a single reserved address range.
+   *
+   * @param size The size in bytes of the buffer, i.e. `nb_slots *
+   * element_size`. Must be a non-zero multiple of `page_size()`.
+   * @return The mirrored buffer. `data()` is valid for `2 * size` bytes.
+   *
+   * @throw std::invalid_argument If `size` is not a non-zero multiple of
+   * `page_size()`.
+   * @throw std::system_error If the memory could not be mapped.
+   */
+  static QueueBuffer mirrored(size_t size);
+
+  /**
+   * @brief Allocates a buffer.
+   *
+   * @param size The size in bytes of the buffer. It is rounded up to the page
+   * size internally, `size()` still returns `size`.
+   * @param options Huge pages, NUMA binding and pre-faulting.
+   * @return The buffer.
+   *
+   * @throw std::invalid_argument If `size` is zero.
+   * @throw std::system_error If the memory could not be mapped at all.
+   */
+  static QueueBuffer allocate(size_t size, const BufferOptions &options = {});
+
+  /**
+   * @brief Creates a named shared memory buffer.
+   *
+   * @param name The name of the segment, e.g. `/camera0`. See `shm_open(3)`.
+   * @param size The size in bytes of the buffer. The memory is zero-filled.
+   * @return The buffer. The name is removed when it is destroyed.
+   *
+   * @throw std::invalid_argument If `size` is zero.
+   * @throw std::system_error If the segment already exists or could not be
+   * created or mapped.
+   */
+  static QueueBuffer create_shared(const std::string &name, size_t size);
+
+  /**
+   * @brief Opens a named shared memory buffer created by another process.
+   *
+   * @param name The name passed to `create_shared()`.
+   * @return The buffer, whose `size()` is the size of the segment.
+   *
+   * @throw std::system_error If the segment does not exist or could not be
+   * mapped.
+   */
+  static QueueBuffer open_shared(const std::string &name);
+
+  /**
+   * @brief Returns the size of a memory page, which is the granularity of
+   * mirrored buffers.
+   */
+  static size_t page_size();
+
+  /**
+   * @brief Returns the size of a huge page.
+   */
+  static size_t huge_page_size();
+
+  /// Constructs an empty buffer that owns nothing.
+  QueueBuffer();
+
+  QueueBuffer(QueueBuffer &&other) noexcept;
+  QueueBuffer &operator=(QueueBuffer &&other) noexcept;
+  QueueBuffer(const QueueBuffer &) = delete;
+  QueueBuffer &operator=(const QueueBuffer &) = delete;
+
+  /// Unmaps the memory.
+  ~QueueBuffer();
+
+  /// Returns the first byte of the buffer.
+  uint8_t *data() const;
+
+  /// Returns the size in bytes of the buffer, not counting the mirror.
+  size_t size() const;
+
+  /// Returns whether the buffer is mirrored.
+  bool is_mirrored() const;
+
+  /// Returns the pages the buffer actually got.
+  BufferBacking backing() const;
+
+  /// Returns the NUMA node the buffer is bound to, or -1 if it is not bound.
+  int numa_node() const;
+
+  /// Returns whether every page of the buffer was faulted in.
+  bool is_prefaulted() const;
+
+  /// Returns whether the buffer is a shared memory segment.
+  bool is_shared() const;
+
+private:
+  /// Releases the mapping, if any.
+  void release();
+
+private:
+  /// The first byte of the buffer.
+  uint8_t *data_;
+
+  /// The size in bytes of the buffer, not counting the mirror.
+  size_t size_;
+
+  /// The size in bytes of the whole mapping.
+  size_t mapping_size_;
+
+  /// Whether the buffer is mapped twice.
+  bool mirrored_;
+
+  /// The pages the buffer actually got.
+  BufferBacking backing_;
+
+  /// The NUMA node the buffer is bound to, or -1.
+  int numa_node_;
+
+  /// Whether every page was faulted in.
+  bool prefaulted_;
+
+  /// Whether the buffer is a shared memory segment.
+  bool shared_;
+
+  /// The name of the shared memory segment to remove on release, if the
+  /// buffer created it.
+  std::string shm_name_;
+};
+
+} // namespace holoflow
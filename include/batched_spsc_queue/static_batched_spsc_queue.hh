@@ -0,0 +1,231 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#ifndef CACHE_LINE_SIZE
+#define CACHE_LINE_SIZE 64
+#endif
+
+namespace holoflow {
+/**
+ * @class StaticBatchedSPSCQueue
+ * @brief A `BatchedSPSCQueue` whose geometry is fixed at compile time.
+ *
+ * This queue has the same acquire/commit API and the same semantics as
+ * `BatchedSPSCQueue`, down to the state `reset()` and `fill()` leave, so it
+ * can be swapped in wherever the slot count, the batch sizes and the element
+ * size are known at build time. The constraints
+ * that are only documented for `BatchedSPSCQueue` are checked with
+ * `static_assert` here.
+ *
+ * Knowing the geometry lets the compiler turn every pointer computation into a
+ * multiplication by a constant (a shift when `ElementSize` is a power of two).
+ * When `NbSlots` is a power of two, index wrapping and occupancy computations
+ * are done with a mask instead of a compare-and-branch.
+ *
+ * @tparam ElementSize The size of each element in bytes.
+ * @tparam EnqueueBatchSize The number of elements enqueued in a single batch.
+ * @tparam DequeueBatchSize The number of elements dequeued in a single batch.
+ * @tparam NbSlots The number of slots in the circular buffer.
+ *
+ * @note The actual capacity of the queue is `NbSlots - EnqueueBatchSize`.
+ *
+ * @warning The threading and acquire/commit constraints of `BatchedSPSCQueue`
+ * apply to this queue as well.
+ */
+template <size_t ElementSize, size_t EnqueueBatchSize, size_t DequeueBatchSize,
+          size_t NbSlots>
+class StaticBatchedSPSCQueue {
+  static_assert(ElementSize > 0, "ElementSize must not be zero");
+  static_assert(EnqueueBatchSize > 0, "EnqueueBatchSize must not be zero");
+  static_assert(DequeueBatchSize > 0, "DequeueBatchSize must not be zero");
+  static_assert(NbSlots % EnqueueBatchSize == 0,
+                "NbSlots must be a multiple of EnqueueBatchSize");
+  static_assert(NbSlots % DequeueBatchSize == 0,
+                "NbSlots must be a multiple of DequeueBatchSize");
+  static_assert(NbSlots > EnqueueBatchSize,
+                "NbSlots must be greater than EnqueueBatchSize");
+  static_assert(NbSlots > DequeueBatchSize,
+                "NbSlots must be greater than DequeueBatchSize");
+
+  /// Whether index arithmetic can be done with a mask.
+  static constexpr bool kPowerOfTwo = (NbSlots & (NbSlots - 1)) == 0;
+
+public:
+  /**
+   * @brief Constructs a new `StaticBatchedSPSCQueue` object.
+   *
+   * @param buffer A pre-allocated memory block for storing elements. The buffer
+   * must be allocated with a size of at least `buffer_size()` bytes.
+   */
+  explicit StaticBatchedSPSCQueue(uint8_t *buffer)
+      : buffer_(buffer), write_idx_(0), cached_read_idx_(0), read_idx_(0),
+        cached_write_idx_(0) {}
+
+  /**
+   * @brief Returns a pointer to the next batch of elements to be written.
+   *
+   * @return A pointer to the next batch of elements to be written, if the
+   * queue has enough capacity. Otherwise, returns `nullptr`.
+   *
+   * @see BatchedSPSCQueue::write_ptr()
+   */
+  uint8_t *write_ptr() {
+    size_t write_idx = write_idx_.load(std::memory_order_relaxed);
+
+    if (NbSlots - distance(write_idx, cached_read_idx_) <
+        EnqueueBatchSize + 1) {
+      cached_read_idx_ = read_idx_.load(std::memory_order_acquire);
+      if (NbSlots - distance(write_idx, cached_read_idx_) <
+          EnqueueBatchSize + 1)
+        return nullptr;
+    }
+
+    return buffer_ + write_idx * ElementSize;
+  }
+
+  /**
+   * @brief Commits the write operation.
+   *
+   * @see BatchedSPSCQueue::commit_write()
+   */
+  void commit_write() {
+    size_t write_idx = write_idx_.load(std::memory_order_relaxed);
+    write_idx_.store(wrap(write_idx + EnqueueBatchSize),
+                     std::memory_order_release);
+  }
+
+  /**
+   * @brief Returns a pointer to the next batch of elements to be read.
+   *
+   * @return A pointer to the next batch of elements to be read, if the queue
+   * has enough elements. Otherwise, returns `nullptr`.
+   *
+   * @see BatchedSPSCQueue::read_ptr()
+   */
+  uint8_t *read_ptr() {
+    size_t read_idx = read_idx_.load(std::memory_order_relaxed);
+
+    if (distance(cached_write_idx_, read_idx) < DequeueBatchSize) {
+      cached_write_idx_ = write_idx_.load(std::memory_order_acquire);
+      if (distance(cached_write_idx_, read_idx) < DequeueBatchSize)
+        return nullptr;
+    }
+
+    return buffer_ + read_idx * ElementSize;
+  }
+
+  /**
+   * @brief Commits the read operation.
+   *
+   * @see BatchedSPSCQueue::commit_read()
+   */
+  void commit_read() {
+    size_t read_idx = read_idx_.load(std::memory_order_relaxed);
+    read_idx_.store(wrap(read_idx + DequeueBatchSize),
+                    std::memory_order_release);
+  }
+
+  /**
+   * @brief Returns the number of elements in the queue.
+   *
+   * @return The number of elements in the queue.
+   */
+  size_t size() {
+    size_t write_idx = write_idx_.load(std::memory_order_acquire);
+    size_t read_idx = read_idx_.load(std::memory_order_acquire);
+
+    return distance(write_idx, read_idx);
+  }
+
+  /**
+   * @brief Resets the queue.
+   *
+   * @warning This method is not thread-safe and should not be called in
+   * production code. It is provided for testing and benchmarking purposes
+   * only.
+   */
+  void reset() {
+    write_idx_.store(0, std::memory_order_release);
+    read_idx_.store(0, std::memory_order_release);
+    cached_read_idx_ = 0;
+    cached_write_idx_ = 0;
+  }
+
+  /**
+   * @brief Fills the queue with `NbSlots - EnqueueBatchSize` elements, which
+   * is the most the writer can ever enqueue.
+   *
+   * @warning This method is not thread-safe and should not be called in
+   * production code. It is provided for testing and benchmarking purposes
+   * only.
+   */
+  void fill() {
+    write_idx_.store(NbSlots - EnqueueBatchSize, std::memory_order_release);
+    read_idx_.store(0, std::memory_order_release);
+    cached_read_idx_ = 0;
+    cached_write_idx_ = NbSlots - EnqueueBatchSize;
+  }
+
+  /// The number of slots in the circular buffer.
+  static constexpr size_t nb_slots() { return NbSlots; }
+
+  /// The number of elements enqueued in a single batch.
+  static constexpr size_t enqueue_batch_size() { return EnqueueBatchSize; }
+
+  /// The number of elements dequeued in a single batch.
+  static constexpr size_t dequeue_batch_size() { return DequeueBatchSize; }
+
+  /// The size of each element in bytes.
+  static constexpr size_t element_size() { return ElementSize; }
+
+  /// The minimum size in bytes of the buffer given to the constructor.
+  static constexpr size_t buffer_size() { return NbSlots * ElementSize; }
+
+private:
+  /**
+   * @brief Wraps an index that went at most one lap past the end of the
+   * circular buffer.
+   */
+  static constexpr size_t wrap(size_t idx) {
+    if constexpr (kPowerOfTwo)
+      return idx & (NbSlots - 1);
+    else
+      return idx == NbSlots ? 0 : idx;
+  }
+
+  /**
+   * @brief Returns the number of elements between two indexes of the circular
+   * buffer.
+   */
+  static constexpr size_t distance(size_t write_idx, size_t read_idx) {
+    if constexpr (kPowerOfTwo) {
+      return (write_idx - read_idx) & (NbSlots - 1);
+    } else {
+      size_t diff = write_idx - read_idx;
+      if (write_idx < read_idx)
+        diff += NbSlots;
+      return diff;
+    }
+  }
+
+private:
+  /// A pre-allocated memory block for storing elements.
+  uint8_t *buffer_;
+
+  /// The current write index.
+  alignas(CACHE_LINE_SIZE) std::atomic<size_t> write_idx_;
+
+  /// The writer's private copy of `read_idx_`.
+  alignas(CACHE_LINE_SIZE) size_t cached_read_idx_;
+
+  /// The current read index.
+  alignas(CACHE_LINE_SIZE) std::atomic<size_t> read_idx_;
+
+  /// The reader's private copy of `write_idx_`.
+  alignas(CACHE_LINE_SIZE) size_t cached_write_idx_;
+};
+
+} // namespace holoflow
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "holoflow/tensor/simd.hh"
+#include "holoflow/tensor/tensor.hh"
+
+namespace holoflow {
+
+/**
+ * @brief Options of `convert()`.
+ */
+struct ConvertOptions {
+  /// The factor applied to each source element, e.g. the gain of a camera.
+  double scale = 1;
+
+  /// The value added after scaling, e.g. minus the black level of a camera
+  /// times the gain.
+  double offset = 0;
+
+  /// The highest instruction set to use, for tests and benchmarks. The best one
+  /// the CPU supports is used when it is lower.
+  SimdLevel max_simd_level = SimdLevel::AVX512;
+};
+
+/**
+ * @brief Converts the elements of a tensor into another one of the same shape
+ * and a different data type, as `dst = src * scale + offset`.
+ *
+ * The supported conversions are from `U8`, `U16` and `I16` to `F32` and `F64`,
+ * and back. The computation is done in the precision of the floating-point
+ * side, with the scale and offset rounded to it. Integer results are rounded to
+ * nearest, ties to even, and saturated to the range of their type, NaN giving
+ * the lowest value.
+ *
+ * The kernel is picked at runtime for the instruction set of the CPU, see
+ * `SimdLevel`. AVX2 and AVX-512 fuse the multiply-add, so their results can
+ * differ from the other levels by one rounding. Inner runs that are contiguous
+ * in both tensors are converted in place, strided ones through small dense
+ * blocks.
+ *
+ * @param src The tensor to read.
+ * @param dst The tensor to write. Must not overlap `src`.
+ * @param options See `ConvertOptions`.
+ *
+ * @warning Exits the program if the shapes differ or if the conversion is not
+ * supported.
+ */
+void convert(const Tensor &src, const Tensor &dst,
+             const ConvertOptions &options = {});
+
+} // namespace holoflow
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "holoflow/tensor/tensor.hh"
+
+#include <cstddef>
+
+namespace holoflow {
+
+/// Outputs from this size on are written with non-temporal stores by
+/// `NonTemporal::Auto`, since they would evict most of the cache anyway.
+constexpr std::size_t NON_TEMPORAL_THRESHOLD = 8 << 20;
+
+/**
+ * @brief Whether `copy()` writes with non-temporal stores, which bypass the
+ * cache.
+ */
+enum class NonTemporal {
+  /// Regular stores.
+  Never,
+
+  /// Non-temporal stores for outputs of `NON_TEMPORAL_THRESHOLD` bytes or
+  /// more.
+  Auto,
+
+  /// Non-temporal stores whenever the inner runs are contiguous.
+  Always,
+};
+
+/**
+ * @brief Options of `copy()`.
+ */
+struct CopyOptions {
+  /// Whether to write with non-temporal stores.
+  NonTemporal non_temporal = NonTemporal::Auto;
+};
+
+/**
+ * @brief Copies the elements of a tensor into another one of the same data
+ * type and shape, whatever their strides, e.g. to repack padded frames into a
+ * dense tensor.
+ *
+ * The dimensions of size 1 are dropped and the dimensions that are contiguous
+ * in both tensors are merged first. Then:
+ * - if the inner dimension is contiguous in both, each inner run is one
+ *   `memcpy`, or non-temporal stores, and a dense copy is a single one;
+ * - if the inner dimension of `dst` is another dimension of `src` (a
+ *   transpose), the copy goes through tiles that fit in the cache;
+ * - otherwise, the elements are copied one by one.
+ *
+ * @param src The tensor to read.
+ * @param dst The tensor to write. Must not overlap `src`.
+ * @param options See `CopyOptions`.
+ *
+ * @warning Exits the program if the data types or the shapes differ.
+ */
+void copy(const Tensor &src, const Tensor &dst,
+          const CopyOptions &options = {});
+
+} // namespace holoflow
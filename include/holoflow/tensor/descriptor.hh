@@ -1,14 +1,19 @@
 #pragma once
 
+#include "holoflow/tensor/dims.hh"
+#include "holoflow/tensor/dtype.hh"
+
 #include <cstddef>
-#include <string>
-#include <vector>
+#include <string_view>
 
 namespace holoflow {
 
 /**
  * @brief Describes the metadata of a tensor, including type, shape, and
  * strides.
+ *
+ * Everything is stored inline, so constructing or copying a descriptor never
+ * allocates.
  */
 class TensorDescriptor {
 public:
@@ -16,15 +21,13 @@ public:
    * @brief Constructs a TensorDescriptor object with the specified type, shape,
    * and strides.
    *
-   * @param type_name A string representing the name of the tensor's data type
-   * (e.g., "float", "int").
-   * @param type_size The size of the tensor's data type in bytes (e.g., 4 for a
-   * 32-bit float).
-   * @param shape A vector specifying the dimensions of the tensor. Each element
-   * represents the size of the tensor in the corresponding dimension.
-   * @param strides A vector specifying the strides of the tensor in bytes. Each
-   * element represents the step size in memory to move to the next element
-   * along the corresponding dimension.
+   * @param dtype The data type of the elements (e.g., `DType::F32`, or
+   * `dtype_of<float>`).
+   * @param shape The dimensions of the tensor, at most `MAX_TENSOR_RANK`. Each
+   * element represents the size of the tensor in the corresponding dimension.
+   * @param strides The strides of the tensor in bytes. Each element represents
+   * the step size in memory to move to the next element along the
+   * corresponding dimension.
    *
    * @warning Exits the program if the provided strides are incompatible with
    * the shape and type size. This ensures that the tensor layout is valid and
@@ -35,25 +38,51 @@ public:
    * shape and type size. If the strides are invalid, the program will terminate
    * to prevent misuse of an improperly defined tensor descriptor.
    */
-  TensorDescriptor(const std::string &type_name, std::size_t type_size,
-                   const std::vector<std::size_t> &shape,
-                   const std::vector<std::size_t> &strides);
+  TensorDescriptor(DType dtype, const Dims &shape, const Dims &strides);
 
   /**
    * @brief Calculates the total size in bytes of the tensor.
    *
-   * Takes into account the shape, strides, and type size to compute the memory
-   * required to store the tensor, including any padding bytes.
+   * This is the largest `shape[i] * strides[i]`, the span of a dimension as
+   * the constructor checks it, so it includes the padding after the last row.
+   * For views whose dimensions are reordered, this is the span of the widest
+   * dimension.
+   *
+   * @note For a crop of a larger frame, this overestimates the bytes the view
+   * touches, which end `(row pitch - row size)` bytes earlier. A tensor of
+   * frames spaced by this size is still a valid descriptor, which is what
+   * `TensorQueue` relies on for its slots.
    *
    * @return The total size in bytes of the tensor.
    */
   std::size_t size_in_bytes() const;
 
+  /**
+   * @brief Gets the number of elements of the tensor.
+   * @return The product of the dimensions, 0 for an empty shape.
+   */
+  std::size_t nb_elements() const;
+
+  /**
+   * @brief Checks whether the elements are dense and in row-major order.
+   *
+   * Dimensions of size 1 are ignored, their stride does not matter.
+   *
+   * @return True if the elements are contiguous, otherwise false.
+   */
+  bool is_contiguous() const;
+
+  /**
+   * @brief Gets the tensor's data type.
+   * @return The data type of the elements.
+   */
+  DType dtype() const;
+
   /**
    * @brief Gets the name of the tensor's data type.
-   * @return The type name as a string (e.g., "float", "int").
+   * @return The type name as a string (e.g., "f32", "u16").
    */
-  const std::string &type_name() const;
+  std::string_view type_name() const;
 
   /**
    * @brief Gets the size of the tensor's data type in bytes.
@@ -63,15 +92,15 @@ public:
 
   /**
    * @brief Gets the dimensions of the tensor.
-   * @return A vector representing the size of the tensor in each dimension.
+   * @return The size of the tensor in each dimension.
    */
-  const std::vector<std::size_t> &shape() const;
+  const Dims &shape() const;
 
   /**
    * @brief Gets the strides of the tensor in bytes.
-   * @return A vector representing the step size in memory for each dimension.
+   * @return The step size in memory for each dimension.
    */
-  const std::vector<std::size_t> &strides() const;
+  const Dims &strides() const;
 
   /**
    * @brief Checks for equality between two tensor descriptors.
@@ -92,9 +121,18 @@ public:
   bool operator!=(const TensorDescriptor &other) const;
 
 private:
-  std::string type_name_;
-  std::size_t type_size_;
-  std::vector<std::size_t> shape_;
-  std::vector<std::size_t> strides_;
+  friend class Tensor;
+
+  /// Constructs a descriptor without checking the strides, for the views of
+  /// `Tensor`, whose strides may be reordered or zero.
+  static TensorDescriptor unchecked(DType dtype, const Dims &shape,
+                                    const Dims &strides);
+
+  TensorDescriptor() = default;
+
+private:
+  DType dtype_;
+  Dims shape_;
+  Dims strides_;
 };
 } // namespace holoflow
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <initializer_list>
+#include <vector>
+
+#include <glog/logging.h>
+
+namespace holoflow {
+
+/// The maximum number of dimensions of a tensor.
+constexpr std::size_t MAX_TENSOR_RANK = 8;
+
+/**
+ * @brief The shape or strides of a tensor: up to `MAX_TENSOR_RANK` sizes,
+ * stored inline.
+ *
+ * `Dims` behaves like a `std::vector<std::size_t>` that never allocates, so
+ * that descriptors and tensors are copied without touching the heap. It
+ * converts from and compares with `std::vector<std::size_t>`.
+ */
+class Dims {
+public:
+  using value_type = std::size_t;
+  using iterator = std::size_t *;
+  using const_iterator = const std::size_t *;
+
+  /// Constructs empty dimensions.
+  Dims() = default;
+
+  /**
+   * @brief Constructs dimensions from a list of sizes.
+   *
+   * @warning Exits the program if there are more than `MAX_TENSOR_RANK` sizes.
+   */
+  Dims(std::initializer_list<std::size_t> sizes)
+      : Dims(sizes.begin(), sizes.end()) {}
+
+  /**
+   * @brief Constructs dimensions from a vector of sizes.
+   *
+   * @warning Exits the program if there are more than `MAX_TENSOR_RANK` sizes.
+   */
+  Dims(const std::vector<std::size_t> &sizes)
+      : Dims(sizes.data(), sizes.data() + sizes.size()) {}
+
+  /**
+   * @brief Constructs dimensions from the sizes in `[first, last)`.
+   *
+   * @warning Exits the program if there are more than `MAX_TENSOR_RANK` sizes.
+   */
+  Dims(const std::size_t *first, const std::size_t *last)
+      : size_(static_cast<std::size_t>(last - first)) {
+    CHECK_LE(size_, MAX_TENSOR_RANK)
+        << ": A tensor cannot have more than " << MAX_TENSOR_RANK
+        << " dimensions!";
+    std::copy(first, last, sizes_.begin());
+  }
+
+  /// Returns the number of dimensions.
+  std::size_t size() const { return size_; }
+
+  /// Returns whether there are no dimensions.
+  bool empty() const { return size_ == 0; }
+
+  std::size_t &operator[](std::size_t i) { return sizes_[i]; }
+  std::size_t operator[](std::size_t i) const { return sizes_[i]; }
+
+  std::size_t front() const { return sizes_[0]; }
+  std::size_t back() const { return sizes_[size_ - 1]; }
+
+  iterator begin() { return sizes_.data(); }
+  iterator end() { return sizes_.data() + size_; }
+  const_iterator begin() const { return sizes_.data(); }
+  const_iterator end() const { return sizes_.data() + size_; }
+
+  /**
+   * @brief Appends a size.
+   *
+   * @warning Exits the program if there are already `MAX_TENSOR_RANK` sizes.
+   */
+  void push_back(std::size_t size) {
+    CHECK_LT(size_, MAX_TENSOR_RANK)
+        << ": A tensor cannot have more than " << MAX_TENSOR_RANK
+        << " dimensions!";
+    sizes_[size_++] = size;
+  }
+
+  /// Returns the sizes as a vector.
+  std::vector<std::size_t> to_vector() const { return {begin(), end()}; }
+
+  friend bool operator==(const Dims &a, const Dims &b) {
+    return std::equal(a.begin(), a.end(), b.begin(), b.end());
+  }
+
+  friend bool operator==(const Dims &a, const std::vector<std::size_t> &b) {
+    return std::equal(a.begin(), a.end(), b.begin(), b.end());
+  }
+
+private:
+  /// The sizes, of which only the first `size_` are meaningful.
+  std::array<std::size_t, MAX_TENSOR_RANK> sizes_{};
+
+  /// The number of dimensions.
+  std::size_t size_ = 0;
+};
+
+} // namespace holoflow
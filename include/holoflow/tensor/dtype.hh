@@ -0,0 +1,136 @@
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+
+namespace holoflow {
+
+/**
+ * @brief The data type of the elements of a tensor.
+ *
+ * Comparing two data types is an integer comparison, and kernels dispatch on
+ * it with a `switch`.
+ */
+enum class DType : uint8_t {
+  U8,
+  U16,
+  U32,
+  U64,
+  I8,
+  I16,
+  I32,
+  I64,
+  F32,
+  F64,
+  /// `std::complex<float>`.
+  Complex64,
+  /// `std::complex<double>`.
+  Complex128,
+};
+
+/// Maps a C++ type to its `DType`. Only the types listed in `DType` have one.
+template <typename T> struct DTypeOf;
+
+template <> struct DTypeOf<uint8_t> {
+  static constexpr DType value = DType::U8;
+};
+template <> struct DTypeOf<uint16_t> {
+  static constexpr DType value = DType::U16;
+};
+template <> struct DTypeOf<uint32_t> {
+  static constexpr DType value = DType::U32;
+};
+template <> struct DTypeOf<uint64_t> {
+  static constexpr DType value = DType::U64;
+};
+template <> struct DTypeOf<int8_t> {
+  static constexpr DType value = DType::I8;
+};
+template <> struct DTypeOf<int16_t> {
+  static constexpr DType value = DType::I16;
+};
+template <> struct DTypeOf<int32_t> {
+  static constexpr DType value = DType::I32;
+};
+template <> struct DTypeOf<int64_t> {
+  static constexpr DType value = DType::I64;
+};
+template <> struct DTypeOf<float> {
+  static constexpr DType value = DType::F32;
+};
+template <> struct DTypeOf<double> {
+  static constexpr DType value = DType::F64;
+};
+template <> struct DTypeOf<std::complex<float>> {
+  static constexpr DType value = DType::Complex64;
+};
+template <> struct DTypeOf<std::complex<double>> {
+  static constexpr DType value = DType::Complex128;
+};
+
+/// The `DType` of `T`, e.g. `dtype_of<float> == DType::F32`.
+template <typename T> constexpr DType dtype_of = DTypeOf<T>::value;
+
+/// Returns the size in bytes of an element of type `dtype`.
+constexpr std::size_t dtype_size(DType dtype) {
+  switch (dtype) {
+  case DType::U8:
+  case DType::I8:
+    return 1;
+  case DType::U16:
+  case DType::I16:
+    return 2;
+  case DType::U32:
+  case DType::I32:
+  case DType::F32:
+    return 4;
+  case DType::U64:
+  case DType::I64:
+  case DType::F64:
+  case DType::Complex64:
+    return 8;
+  case DType::Complex128:
+    return 16;
+  }
+  return 0;
+}
+
+/// Returns the name of `dtype`, e.g. "f32".
+constexpr std::string_view dtype_name(DType dtype) {
+  switch (dtype) {
+  case DType::U8:
+    return "u8";
+  case DType::U16:
+    return "u16";
+  case DType::U32:
+    return "u32";
+  case DType::U64:
+    return "u64";
+  case DType::I8:
+    return "i8";
+  case DType::I16:
+    return "i16";
+  case DType::I32:
+    return "i32";
+  case DType::I64:
+    return "i64";
+  case DType::F32:
+    return "f32";
+  case DType::F64:
+    return "f64";
+  case DType::Complex64:
+    return "complex64";
+  case DType::Complex128:
+    return "complex128";
+  }
+  return "unknown";
+}
+
+inline std::ostream &operator<<(std::ostream &os, DType dtype) {
+  return os << dtype_name(dtype);
+}
+
+} // namespace holoflow
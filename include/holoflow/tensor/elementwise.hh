@@ -0,0 +1,96 @@
+#pragma once
+
+#include "holoflow/tensor/descriptor.hh"
+
+#include <array>
+#include <cstddef>
+
+namespace holoflow {
+
+/**
+ * @brief The shape and strides of an elementwise kernel from a source tensor to
+ * a destination tensor of the same shape, simplified so that the kernel loops
+ * over as few dimensions as possible.
+ *
+ * The dimensions of size 1 are dropped, and each dimension is merged into the
+ * previous one when both are contiguous in the two tensors. Dense tensors end
+ * up with a single dimension, padded frames with two.
+ */
+struct ElementwiseLayout {
+  /// Simplifies the layout of `src` and `dst`, which must have the same shape.
+  ElementwiseLayout(const TensorDescriptor &src, const TensorDescriptor &dst)
+      : ElementwiseLayout(src.shape(), src.strides(), dst.strides()) {}
+
+  /// Simplifies a layout given by its shape and the strides in bytes of the
+  /// source and the destination.
+  ElementwiseLayout(const Dims &shape, const Dims &src_strides,
+                    const Dims &dst_strides) {
+    for (std::size_t i = 0; i < shape.size(); ++i) {
+      std::size_t size = shape[i];
+      if (size == 1)
+        continue;
+
+      std::size_t last = rank - 1;
+      if (rank > 0 && this->src_strides[last] == size * src_strides[i] &&
+          this->dst_strides[last] == size * dst_strides[i]) {
+        this->shape[last] *= size;
+        this->src_strides[last] = src_strides[i];
+        this->dst_strides[last] = dst_strides[i];
+      } else {
+        this->shape[rank] = size;
+        this->src_strides[rank] = src_strides[i];
+        this->dst_strides[rank] = dst_strides[i];
+        ++rank;
+      }
+    }
+  }
+
+  /**
+   * @brief Calls `f(src_offset, dst_offset)`, with byte offsets, for every
+   * index of the dimensions that are not skipped.
+   *
+   * @param skip0 A dimension to leave out, or `MAX_TENSOR_RANK`.
+   * @param skip1 Another dimension to leave out, or `MAX_TENSOR_RANK`.
+   */
+  template <typename F>
+  void for_each_outer(std::size_t skip0, std::size_t skip1, F f) const {
+    std::array<std::size_t, MAX_TENSOR_RANK> index{};
+    std::size_t src_offset = 0;
+    std::size_t dst_offset = 0;
+
+    while (true) {
+      f(src_offset, dst_offset);
+
+      // Increment the index like an odometer, innermost dimension first.
+      std::size_t dim = rank;
+      while (dim-- > 0) {
+        if (dim == skip0 || dim == skip1)
+          continue;
+        if (++index[dim] < shape[dim]) {
+          src_offset += src_strides[dim];
+          dst_offset += dst_strides[dim];
+          break;
+        }
+        src_offset -= (shape[dim] - 1) * src_strides[dim];
+        dst_offset -= (shape[dim] - 1) * dst_strides[dim];
+        index[dim] = 0;
+      }
+      if (dim == static_cast<std::size_t>(-1))
+        return;
+    }
+  }
+
+  /// The number of dimensions left, 0 for a single element.
+  std::size_t rank = 0;
+
+  /// The size of each dimension.
+  std::array<std::size_t, MAX_TENSOR_RANK> shape{};
+
+  /// The stride in bytes of each dimension in the source.
+  std::array<std::size_t, MAX_TENSOR_RANK> src_strides{};
+
+  /// The stride in bytes of each dimension in the destination.
+  std::array<std::size_t, MAX_TENSOR_RANK> dst_strides{};
+};
+
+} // namespace holoflow
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "holoflow/tensor/simd.hh"
+#include "holoflow/tensor/tensor.hh"
+#include "holoflow/tensor/thread_pool.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace holoflow {
+
+/**
+ * @brief The direction of a Fourier transform.
+ */
+enum class FftDirection : uint8_t {
+  /// `X[k] = sum(x[j] * exp(-2i * pi * j * k / n))`.
+  Forward,
+  /// `x[j] = sum(X[k] * exp(2i * pi * j * k / n)) / n`, so that it undoes
+  /// `Forward`.
+  Inverse,
+};
+
+/**
+ * @brief Options of the Fourier transforms.
+ */
+struct FftOptions {
+  /// The direction of the transform.
+  FftDirection direction = FftDirection::Forward;
+
+  /// The pool to split the lines of large tensors across, or `nullptr` to
+  /// transform on the calling thread only.
+  ThreadPool *pool = nullptr;
+
+  /// The highest instruction set to use, for tests and benchmarks. The best one
+  /// the CPU supports is used when it is lower.
+  SimdLevel max_simd_level = SimdLevel::AVX512;
+};
+
+/// The number of plans `FftPlan::cached()` keeps, the least recently used one
+/// being dropped first.
+constexpr std::size_t FFT_PLAN_CACHE_SIZE = 16;
+
+/// The transform of a plan along one dimension, defined in the implementation.
+struct FftPass;
+
+/**
+ * @brief The precomputed transform of complex tensors of a given layout along
+ * their last one or two dimensions.
+ *
+ * A plan holds, for each transformed dimension, its factorization into radix 4,
+ * 2 and 3 stages, plus generic ones for the other prime factors, the twiddle
+ * factors of each stage, and the offsets of the lines to transform. Plans only
+ * depend on the data type, shape and strides of the tensors, so `cached()`
+ * shares them between the calls on tensors of the same layout.
+ *
+ * The transforms are Stockham autosort FFTs, which need no bit reversal. They
+ * run on blocks of lines gathered into SIMD lanes, one line per lane, so that
+ * the butterflies of all the lanes are computed at once whatever the length.
+ * The inverse transform reuses the forward one by swapping the real and
+ * imaginary parts on the way in and out.
+ */
+class FftPlan {
+public:
+  /**
+   * @brief Plans the transforms from tensors of the layout of `src` to tensors
+   * of the layout of `dst`.
+   *
+   * @param src The layout of the tensors to read, of type `Complex64` or
+   * `Complex128`.
+   * @param dst The layout of the tensors to write, of the data type and shape
+   * of `src`. It may be the layout of `src` for in-place transforms.
+   * @param nb_axes The number of trailing dimensions to transform, 1 or 2.
+   *
+   * @warning Exits the program if the layouts do not fit.
+   */
+  FftPlan(const TensorDescriptor &src, const TensorDescriptor &dst,
+          std::size_t nb_axes);
+
+  ~FftPlan();
+
+  FftPlan(const FftPlan &) = delete;
+  FftPlan &operator=(const FftPlan &) = delete;
+
+  /**
+   * @brief Returns the plan of these layouts, made on the first call and shared
+   * by the next ones, from any thread.
+   *
+   * Only the `FFT_PLAN_CACHE_SIZE` most recently used plans are kept, since a
+   * plan holds the offsets of every line it transforms. A dropped plan lives
+   * on while a caller holds it, and is made again when next needed.
+   */
+  static std::shared_ptr<const FftPlan> cached(const TensorDescriptor &src,
+                                               const TensorDescriptor &dst,
+                                               std::size_t nb_axes);
+
+  /**
+   * @brief Transforms `src` into `dst`.
+   *
+   * @param src The tensor to read, of the source layout of the plan.
+   * @param dst The tensor to write, of the destination layout of the plan. It
+   * may be `src` itself, but must not overlap it otherwise.
+   * @param options See `FftOptions`.
+   *
+   * @warning Exits the program if the tensors do not have the layouts of the
+   * plan.
+   */
+  void execute(const Tensor &src, const Tensor &dst,
+               const FftOptions &options = {}) const;
+
+private:
+  /// The layout of the tensors to read.
+  TensorDescriptor src_;
+
+  /// The layout of the tensors to write.
+  TensorDescriptor dst_;
+
+  /// The transforms along each dimension, the last one first.
+  std::vector<FftPass> passes_;
+};
+
+/**
+ * @brief Computes the Fourier transforms of a complex tensor along its last
+ * dimension, e.g. of each row of a frame, with a cached `FftPlan`.
+ *
+ * @param src The tensor to read, of type `Complex64` or `Complex128`.
+ * @param dst The tensor to write, of the data type and shape of `src`. It may
+ * be `src` itself, but must not overlap it otherwise.
+ * @param options See `FftOptions`.
+ *
+ * @warning Exits the program if the data types or shapes do not fit.
+ */
+void fft(const Tensor &src, const Tensor &dst, const FftOptions &options = {});
+
+/**
+ * @brief Computes the 2D Fourier transforms of a complex tensor along its last
+ * two dimensions, e.g. of each frame of a batch, see `fft()`.
+ */
+void fft2(const Tensor &src, const Tensor &dst,
+          const FftOptions &options = {});
+
+} // namespace holoflow
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "holoflow/tensor/simd.hh"
+#include "holoflow/tensor/tensor.hh"
+#include "holoflow/tensor/thread_pool.hh"
+
+#include <cstddef>
+
+namespace holoflow {
+
+/**
+ * @brief Options of the reductions.
+ */
+struct ReduceOptions {
+  /// The pool to split large tensors across, or `nullptr` to reduce on the
+  /// calling thread only.
+  ThreadPool *pool = nullptr;
+
+  /// The number of elements below which a task is not worth its overhead.
+  /// Tensors are split into at most one task per this many elements.
+  std::size_t min_task_size = 1 << 18;
+
+  /// The highest instruction set to use, for tests and benchmarks. The best one
+  /// the CPU supports is used when it is lower.
+  SimdLevel max_simd_level = SimdLevel::AVX512;
+};
+
+/**
+ * @brief The statistics of all the elements of a tensor, see `stats()`.
+ */
+struct TensorStats {
+  /// The number of elements.
+  std::size_t count = 0;
+
+  /// The sum of the elements.
+  double sum = 0;
+
+  /// The smallest element, +infinity if there are none.
+  double min = 0;
+
+  /// The largest element, -infinity if there are none.
+  double max = 0;
+
+  /// The mean of the elements, NaN if there are none.
+  double mean = 0;
+
+  /// The population variance of the elements, NaN if there are none.
+  double variance = 0;
+};
+
+/**
+ * @brief Computes the sum, min, max, mean and variance of all the elements of
+ * a tensor, of any real data type.
+ *
+ * The elements are reduced by blocks of 1024 in SIMD lanes, in `float` for
+ * `F32` tensors and `double` for the others. Whatever the instruction set, a
+ * lane adds at most 32 values before its sums are widened to `double`. The
+ * blocks are then merged in `double`, the sums with Kahan compensation and the
+ * variances with Chan's pairwise update, whose error does not grow with the
+ * number of elements. Integer sums are exact as long as they fit in the 53
+ * bits of a `double`.
+ *
+ * With a pool, the blocks are split into contiguous ranges reduced in parallel
+ * and merged in order, so the result only depends on the number of tasks.
+ *
+ * @warning Exits the program if the tensor is complex.
+ */
+TensorStats stats(const Tensor &src, const ReduceOptions &options = {});
+
+/**
+ * @brief Computes the sum of all the elements of a tensor, as `stats()` does
+ * but without its second pass for the variance.
+ */
+double sum(const Tensor &src, const ReduceOptions &options = {});
+
+/**
+ * @brief Sums a tensor along one dimension, e.g. the rows of a frame into a
+ * profile or a batch of frames into one.
+ *
+ * The sums are accumulated in `double`: with Kahan compensation when the
+ * reduced dimension is strided, which sums whole slices at a time, and by
+ * blocks as in `stats()` when it is contiguous.
+ *
+ * @param src The tensor to reduce, of any real data type.
+ * @param axis The dimension to sum along.
+ * @param dst The tensor to write, of type `F32` or `F64` and of the shape of
+ * `src` without `axis`.
+ * @param options See `ReduceOptions`.
+ *
+ * @warning Exits the program if the axis is out of range, or if the data types
+ * or shapes do not fit.
+ */
+void sum(const Tensor &src, std::size_t axis, const Tensor &dst,
+         const ReduceOptions &options = {});
+
+/**
+ * @brief Averages a tensor along one dimension, e.g. a batch of frames into a
+ * temporal mean, see `sum()`. The means along an empty dimension are NaN.
+ */
+void mean(const Tensor &src, std::size_t axis, const Tensor &dst,
+          const ReduceOptions &options = {});
+
+} // namespace holoflow
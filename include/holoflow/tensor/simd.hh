@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+
+namespace holoflow {
+
+/**
+ * @brief The instruction sets kernels dispatch on at runtime, from the least
+ * to the most capable.
+ *
+ * The library is built for the baseline of the target, and the kernels compile
+ * each level with `__attribute__((target))`. A level implies the previous
+ * ones.
+ */
+enum class SimdLevel : uint8_t {
+  /// Plain C++, for any CPU.
+  Scalar,
+
+  /// SSE4.1.
+  SSE4,
+
+  /// AVX2 and FMA.
+  AVX2,
+
+  /// AVX-512F, with AVX2 and FMA.
+  AVX512,
+};
+
+/// Returns the best level supported by the CPU running the program. It is
+/// detected on the first call.
+SimdLevel cpu_simd_level();
+
+/// Returns the best level supported by the CPU that is not above `max_level`.
+SimdLevel simd_level(SimdLevel max_level);
+
+/// Returns the name of `level`, e.g. "avx2".
+constexpr std::string_view simd_level_name(SimdLevel level) {
+  switch (level) {
+  case SimdLevel::Scalar:
+    return "scalar";
+  case SimdLevel::SSE4:
+    return "sse4";
+  case SimdLevel::AVX2:
+    return "avx2";
+  case SimdLevel::AVX512:
+    return "avx512";
+  }
+  return "unknown";
+}
+
+inline std::ostream &operator<<(std::ostream &os, SimdLevel level) {
+  return os << simd_level_name(level);
+}
+
+} // namespace holoflow
@@ -1,6 +1,9 @@
+#pragma once
+
 #include "holoflow/tensor/descriptor.hh"
 
 #include <cstddef>
+#include <optional>
 
 #include <glog/logging.h>
 
@@ -11,6 +14,12 @@ namespace holoflow {
  * Provides access to tensor metadata via its descriptor and raw data via
  * type-safe accessors.
  *
+ * A tensor does not own its data. The view operations (`slice()`, `crop()`,
+ * `permute()`, `transpose()`, `reshape()` and `broadcast()`) return tensors
+ * sharing the same data, whose descriptor and data pointer are adjusted, and
+ * never copy any element. Their descriptors may have reordered or zero
+ * strides, `is_contiguous()` tells whether the elements are still dense.
+ *
  * The following example demonstrates how to use the `Tensor` class:
  * @include examples/holoflow/tensor/example.cc
  */
@@ -31,16 +40,113 @@ public:
    */
   const TensorDescriptor &desc() const;
 
+  /**
+   * @brief Points the tensor to other data with the same layout.
+   *
+   * Unlike constructing a new tensor, does not copy the descriptor, and
+   * therefore never allocates.
+   *
+   * @param data A pointer to the new raw data of the tensor.
+   */
+  void rebind(std::byte *data);
+
+  /**
+   * @brief Gets the first byte of the tensor data, whatever its type.
+   *
+   * @return A pointer to the raw data of the tensor.
+   */
+  std::byte *raw_data() const;
+
+  /**
+   * @brief Checks whether the elements are dense and in row-major order.
+   *
+   * @return True if the elements are contiguous, otherwise false.
+   */
+  bool is_contiguous() const;
+
+  /**
+   * @brief Selects a range of a dimension.
+   *
+   * @param dim The dimension to slice.
+   * @param begin The first index kept.
+   * @param end The index after the last one kept.
+   * @param step The distance between two indices kept.
+   * @return The view of indices `begin, begin + step, ...` below `end`.
+   *
+   * @warning Exits the program if the range is not within the dimension or
+   * `step` is zero.
+   */
+  Tensor slice(std::size_t dim, std::size_t begin, std::size_t end,
+               std::size_t step = 1) const;
+
+  /**
+   * @brief Selects a region of interest.
+   *
+   * @param begin The first index kept in each dimension.
+   * @param shape The shape of the region.
+   * @return The view of the region.
+   *
+   * @warning Exits the program if the region is not within the tensor.
+   */
+  Tensor crop(const Dims &begin, const Dims &shape) const;
+
+  /**
+   * @brief Reorders the dimensions.
+   *
+   * @param axes Dimension `i` of the result is dimension `axes[i]` of the
+   * tensor.
+   * @return The view with the dimensions reordered.
+   *
+   * @warning Exits the program if `axes` is not a permutation of the
+   * dimensions.
+   */
+  Tensor permute(const Dims &axes) const;
+
+  /**
+   * @brief Swaps two dimensions.
+   *
+   * @return The view with dimensions `dim0` and `dim1` swapped.
+   */
+  Tensor transpose(std::size_t dim0, std::size_t dim1) const;
+
+  /**
+   * @brief Gives the elements another shape, in the same row-major order.
+   *
+   * A copy is needed when the elements cannot be reached with strides in the
+   * new shape, e.g. to merge two transposed dimensions. A contiguous tensor
+   * can always be reshaped.
+   *
+   * @param shape The new shape, with the same number of elements.
+   * @return The reshaped view, or nothing if it needs a copy.
+   *
+   * @warning Exits the program if the number of elements differs.
+   */
+  std::optional<Tensor> reshape(const Dims &shape) const;
+
+  /**
+   * @brief Repeats the tensor to a larger shape, without copying.
+   *
+   * As in NumPy, the shapes are aligned on their last dimension. Missing
+   * leading dimensions and dimensions of size 1 are repeated with a zero
+   * stride.
+   *
+   * @param shape The shape of the result.
+   * @return The broadcast view.
+   *
+   * @warning Exits the program if the tensor cannot be broadcast to `shape`.
+   */
+  Tensor broadcast(const Dims &shape) const;
+
   /**
    * @brief Accesses the tensor data as a specific type.
    *
-   * @tparam T The type to cast the tensor data to. This type must match the
-   *           type described by the tensor descriptor.
+   * @tparam T The type to cast the tensor data to. `dtype_of<T>` must be the
+   *           data type of the tensor descriptor.
    *
    * @return A constant pointer to the tensor data casted to the specified type.
    *
-   * @warning Exits the program if the size of T does not match the
-   * type_size in the tensor descriptor.
+   * @warning Exits the program if T does not match the data type of the
+   * tensor descriptor.
    */
   template <typename T> T *data();
   template <typename T> const T *data() const;
@@ -55,15 +161,15 @@ private:
 };
 
 template <typename T> const T *Tensor::data() const {
-  CHECK_EQ(sizeof(T), desc_.type_size())
-      << ": The type provided did not match the expected type size!";
+  CHECK_EQ(dtype_of<T>, desc_.dtype())
+      << ": The type provided did not match the expected type!";
 
   return reinterpret_cast<const T *>(data_);
 }
 
 template <typename T> T *Tensor::data() {
-  CHECK_EQ(sizeof(T), desc_.type_size())
-      << ": The type provided did not match the expected type size!";
+  CHECK_EQ(dtype_of<T>, desc_.dtype())
+      << ": The type provided did not match the expected type!";
 
   return reinterpret_cast<T *>(data_);
 }
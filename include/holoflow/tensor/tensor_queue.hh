@@ -0,0 +1,117 @@
+#pragma once
+
+#include "batched_spsc_queue/batched_spsc_queue.hh"
+#include "batched_spsc_queue/queue_buffer.hh"
+#include "holoflow/tensor/descriptor.hh"
+#include "holoflow/tensor/tensor.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace holoflow {
+/**
+ * @class TensorQueue
+ * @brief A `BatchedSPSCQueue` whose elements are frames described by a
+ * `TensorDescriptor`, and whose batches are seen as tensors.
+ *
+ * Each slot of the queue holds one frame of `frame.size_in_bytes()` bytes,
+ * padding included, even after the last row of a cropped frame. The producer
+ * fills a tensor of shape `{enqueue_batch_size, frame.shape()...}` and the
+ * consumer reads a tensor of shape `{dequeue_batch_size, frame.shape()...}`,
+ * whose leading stride is the size of a frame. Since a batch is contiguous in
+ * the queue, both are plain views on the queue buffer.
+ *
+ * The two tensors are built once and only rebound to the next batch, so that
+ * the per-batch path does not allocate. They are rebuilt if the batch sizes
+ * of the queue are changed.
+ */
+class TensorQueue {
+public:
+  /**
+   * @brief Constructs a tensor queue over an external buffer.
+   *
+   * @param frame The descriptor of a frame.
+   * @param nb_slots The number of frames the queue can hold.
+   * @param enqueue_batch_size The number of frames in an enqueue batch.
+   * @param dequeue_batch_size The number of frames in a dequeue batch.
+   * @param buffer The buffer, of at least `nb_slots * frame.size_in_bytes()`
+   * bytes.
+   *
+   * @throw std::invalid_argument If the geometry is not valid, see
+   * `BatchedSPSCQueue`.
+   */
+  TensorQueue(const TensorDescriptor &frame, size_t nb_slots,
+              size_t enqueue_batch_size, size_t dequeue_batch_size,
+              uint8_t *buffer);
+
+  /**
+   * @brief Constructs a tensor queue owning its buffer.
+   *
+   * @param buffer A buffer of at least `nb_slots * frame.size_in_bytes()`
+   * bytes, see `QueueBuffer`.
+   */
+  TensorQueue(const TensorDescriptor &frame, size_t nb_slots,
+              size_t enqueue_batch_size, size_t dequeue_batch_size,
+              QueueBuffer buffer);
+
+  TensorQueue(const TensorQueue &) = delete;
+  TensorQueue &operator=(const TensorQueue &) = delete;
+
+  /**
+   * @brief Returns the tensor of the next batch to fill.
+   *
+   * @return The tensor, valid until the next call, or `nullptr` if the queue
+   * is full.
+   */
+  Tensor *write_tensor();
+
+  /// Like `write_tensor()`, but waits for room, see
+  /// `BatchedSPSCQueue::wait_write_ptr()`.
+  Tensor *wait_write_tensor();
+  Tensor *wait_write_tensor(std::chrono::nanoseconds timeout);
+
+  /// Commits the batch returned by `write_tensor()`.
+  void commit_write();
+
+  /**
+   * @brief Returns the tensor of the next batch to read.
+   *
+   * @return The tensor, valid until the next call, or `nullptr` if no whole
+   * batch is available.
+   */
+  const Tensor *read_tensor();
+
+  /// Like `read_tensor()`, but waits for a batch, see
+  /// `BatchedSPSCQueue::wait_read_ptr()`.
+  const Tensor *wait_read_tensor();
+  const Tensor *wait_read_tensor(std::chrono::nanoseconds timeout);
+
+  /// Commits the batch returned by `read_tensor()`.
+  void commit_read();
+
+  /// Returns the descriptor of a frame.
+  const TensorDescriptor &frame() const;
+
+  /// Returns the underlying queue, e.g. to flush, close or reconfigure it.
+  BatchedSPSCQueue &queue();
+
+private:
+  /// Returns `tensor` bound to `data`, rebuilt if the batch size changed.
+  Tensor *bind(Tensor &tensor, size_t batch_size, uint8_t *data);
+
+private:
+  /// The descriptor of a frame.
+  TensorDescriptor frame_;
+
+  /// The queue of frames.
+  BatchedSPSCQueue queue_;
+
+  /// The tensor of the batch being written.
+  Tensor write_tensor_;
+
+  /// The tensor of the batch being read.
+  Tensor read_tensor_;
+};
+
+} // namespace holoflow
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "holoflow/tensor/dtype.hh"
+#include "holoflow/tensor/tensor.hh"
+
+#include <array>
+#include <cstddef>
+#include <type_traits>
+
+#include <glog/logging.h>
+
+namespace holoflow {
+/**
+ * @brief A typed view of fixed rank on the data of a `Tensor`.
+ *
+ * The data type and rank are checked once, when the view is created. Indexing
+ * is then unchecked and follows the byte strides of the tensor, which makes
+ * `operator()` plain pointer arithmetic.
+ *
+ * When `InnerContiguous` is set, the view also checks that the elements of the
+ * last dimension are contiguous. The last index is then an element offset
+ * rather than a byte offset, and `row()` gives a pointer to a whole inner run,
+ * so that the loops over it vectorize.
+ *
+ * @tparam T The type of the elements, `const` for a read-only view.
+ * @tparam Rank The number of dimensions of the tensor.
+ * @tparam InnerContiguous Whether the last dimension is contiguous.
+ */
+template <typename T, std::size_t Rank, bool InnerContiguous = false>
+class TensorView {
+  static_assert(Rank > 0 && Rank <= MAX_TENSOR_RANK,
+                "The rank of a view must be between 1 and MAX_TENSOR_RANK");
+
+  /// `std::byte` with the constness of `T`.
+  using Byte =
+      std::conditional_t<std::is_const_v<T>, const std::byte, std::byte>;
+
+public:
+  /**
+   * @brief Creates a view on a tensor.
+   *
+   * @warning Exits the program if `T` is not the data type of the tensor, if
+   * the tensor is not of rank `Rank`, or if `InnerContiguous` is set and its
+   * last dimension is not contiguous.
+   */
+  explicit TensorView(Tensor &tensor)
+      : TensorView(tensor.desc(), reinterpret_cast<Byte *>(
+                                      tensor.data<std::remove_const_t<T>>())) {
+  }
+
+  /// Creates a read-only view on a tensor, see `TensorView(Tensor &)`.
+  explicit TensorView(const Tensor &tensor)
+    requires std::is_const_v<T>
+      : TensorView(tensor.desc(), reinterpret_cast<Byte *>(
+                                      tensor.data<std::remove_const_t<T>>())) {
+  }
+
+  /// Returns the number of dimensions.
+  static constexpr std::size_t rank() { return Rank; }
+
+  /// Returns the size of dimension `dim`.
+  std::size_t shape(std::size_t dim) const { return shape_[dim]; }
+
+  /// Returns the stride in bytes of dimension `dim`.
+  std::size_t stride(std::size_t dim) const { return strides_[dim]; }
+
+  /// Returns the first element.
+  T *data() const { return reinterpret_cast<T *>(data_); }
+
+  /**
+   * @brief Returns the element at the given indices, without any check.
+   *
+   * @param indices One index per dimension.
+   */
+  template <typename... Indices> T &operator()(Indices... indices) const {
+    static_assert(sizeof...(Indices) == Rank,
+                  "A view is indexed with one index per dimension");
+    const std::size_t index[] = {static_cast<std::size_t>(indices)...};
+
+    if constexpr (InnerContiguous) {
+      Byte *row = data_;
+      for (std::size_t dim = 0; dim + 1 < Rank; dim++)
+        row += index[dim] * strides_[dim];
+      return reinterpret_cast<T *>(row)[index[Rank - 1]];
+    } else {
+      Byte *element = data_;
+      for (std::size_t dim = 0; dim < Rank; dim++)
+        element += index[dim] * strides_[dim];
+      return *reinterpret_cast<T *>(element);
+    }
+  }
+
+  /**
+   * @brief Returns the first element of an inner run, whose `shape(Rank - 1)`
+   * elements are contiguous.
+   *
+   * @param indices One index per dimension but the last.
+   */
+  template <typename... Indices>
+  T *row(Indices... indices) const
+    requires InnerContiguous
+  {
+    static_assert(sizeof...(Indices) == Rank - 1,
+                  "A row is indexed with one index per outer dimension");
+    const std::size_t index[] = {static_cast<std::size_t>(indices)..., 0};
+
+    Byte *row = data_;
+    for (std::size_t dim = 0; dim + 1 < Rank; dim++)
+      row += index[dim] * strides_[dim];
+    return reinterpret_cast<T *>(row);
+  }
+
+private:
+  TensorView(const TensorDescriptor &desc, Byte *data) : data_(data) {
+    CHECK_EQ(desc.shape().size(), Rank)
+        << ": The tensor does not have the rank of the view!";
+    for (std::size_t dim = 0; dim < Rank; dim++) {
+      shape_[dim] = desc.shape()[dim];
+      strides_[dim] = desc.strides()[dim];
+    }
+    if constexpr (InnerContiguous) {
+      CHECK_EQ(strides_[Rank - 1], sizeof(T))
+          << ": The last dimension of the tensor is not contiguous!";
+    }
+  }
+
+private:
+  /// The first element.
+  Byte *data_;
+
+  /// The size of each dimension.
+  std::array<std::size_t, Rank> shape_;
+
+  /// The stride in bytes of each dimension.
+  std::array<std::size_t, Rank> strides_;
+};
+
+/// A view whose last dimension is contiguous.
+template <typename T, std::size_t Rank>
+using ContiguousTensorView = TensorView<T, Rank, true>;
+
+} // namespace holoflow
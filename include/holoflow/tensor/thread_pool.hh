@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace holoflow {
+
+/**
+ * @brief A fixed set of threads that the tensor kernels split large tensors
+ * across.
+ *
+ * `parallel_for()` runs a batch of tasks on the workers and on the calling
+ * thread, and returns once they are all done. The tasks are claimed from a
+ * shared counter, so uneven tasks balance themselves. Batches from different
+ * threads run one after the other.
+ */
+class ThreadPool {
+public:
+  /**
+   * @brief Starts the workers.
+   *
+   * @param nb_threads The number of threads tasks run on, including the one
+   * calling `parallel_for()`. 0 means one per hardware thread.
+   */
+  explicit ThreadPool(std::size_t nb_threads = 0);
+
+  /// Stops and joins the workers.
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  /// Returns the number of threads tasks run on, including the calling one.
+  std::size_t size() const;
+
+  /**
+   * @brief Calls `task(i)` for each `i` in `[0, nb_tasks)`, and waits for all
+   * the calls to return.
+   *
+   * @warning Must not be called from a task of the same pool.
+   */
+  void parallel_for(std::size_t nb_tasks,
+                    const std::function<void(std::size_t)> &task);
+
+private:
+  /// The loop of the workers.
+  void work();
+
+  /// Runs tasks of the current batch until there are none left to claim.
+  void run_tasks();
+
+private:
+  /// The worker threads.
+  std::vector<std::thread> workers_;
+
+  /// Serializes the batches of concurrent callers.
+  std::mutex batch_mutex_;
+
+  /// Protects the fields below it, and goes with the condition variables.
+  std::mutex mutex_;
+
+  /// Notified when a batch starts or the pool stops.
+  std::condition_variable batch_started_;
+
+  /// Notified when the last task of a batch returns or a worker leaves it.
+  std::condition_variable batch_done_;
+
+  /// Incremented for each batch, so that workers wake up once per batch.
+  std::size_t generation_ = 0;
+
+  /// Whether the workers must stop.
+  bool stopping_ = false;
+
+  /// The number of workers that joined the current batch and did not leave
+  /// it yet. The caller waits for it to be 0 before ending the batch.
+  std::size_t busy_workers_ = 0;
+
+  /// The tasks of the current batch.
+  const std::function<void(std::size_t)> *task_ = nullptr;
+
+  /// The number of tasks of the current batch.
+  std::size_t nb_tasks_ = 0;
+
+  /// The next task of the current batch to claim.
+  std::atomic<std::size_t> next_task_ = 0;
+
+  /// The number of tasks of the current batch that returned.
+  std::atomic<std::size_t> done_tasks_ = 0;
+};
+
+} // namespace holoflow
@@ -0,0 +1,246 @@
+#pragma once
+
+#include "batched_spsc_queue/batched_spsc_queue.hh"
+#include "batched_spsc_queue/queue_buffer.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <linux/aio_abi.h>
+
+namespace holoflow {
+/**
+ * @brief Options of a `DiskRecorder`.
+ */
+struct RecorderOptions {
+  /// Whether to bypass the page cache with `O_DIRECT`. Falls back to buffered
+  /// writes if the file system does not support it, e.g. tmpfs.
+  bool direct_io = true;
+
+  /// The size in bytes of each write. Large writes keep the file made of long
+  /// sequential extents.
+  size_t write_size = 8 << 20;
+
+  /// The number of writes in flight. Two is double buffering.
+  size_t max_in_flight = 2;
+
+  /// The number of bytes to allocate on disk up front, or 0 to let the file
+  /// grow with the writes.
+  size_t preallocate = 0;
+};
+
+/**
+ * @brief What a `DiskRecorder` did so far.
+ */
+struct RecorderStats {
+  /// The number of bytes of the stream that reached the file.
+  uint64_t bytes_written = 0;
+
+  /// The time between the first write and the last completed one.
+  std::chrono::duration<double> elapsed{0};
+
+  /// Whether the file is written with `O_DIRECT`.
+  bool direct_io = false;
+
+  /// Whether the batches are written straight from the queue buffer.
+  bool zero_copy = false;
+
+  /// Returns the sustained write rate, in MB/s.
+  double megabytes_per_second() const {
+    return elapsed.count() > 0 ? bytes_written / elapsed.count() / 1e6 : 0;
+  }
+};
+
+/**
+ * @class DiskRecorder
+ * @brief The consumer of a `BatchedSPSCQueue` that writes every element it
+ * dequeues to a file, back to back.
+ *
+ * Writes are asynchronous (Linux native AIO), so that the next batches are
+ * dequeued while the previous ones are on their way to the disk, and
+ * `max_in_flight` of them are submitted at any time.
+ *
+ * When the dequeue batches are a multiple of `DIRECT_IO_ALIGNMENT` bytes and
+ * the queue buffer is aligned, as a `QueueBuffer` is, the recorder is
+ * zero-copy: it writes whole batches straight from the `read_span()` memory,
+ * and only commits them once their write completed. Otherwise, the batches are
+ * copied into aligned staging buffers of `write_size` bytes, which are written
+ * once full.
+ *
+ * The recorder is the consumer of the queue, and the dequeue batch size must
+ * not be changed while it records.
+ */
+class DiskRecorder {
+public:
+  /// The alignment of the memory, offsets and sizes of `O_DIRECT` writes.
+  static constexpr size_t DIRECT_IO_ALIGNMENT = 4096;
+
+  /**
+   * @brief Creates the file, or truncates it, and prepares the writes.
+   *
+   * @param queue The queue to consume from. Must outlive the recorder.
+   * @param path The path of the file.
+   * @param options See `RecorderOptions`.
+   *
+   * @throw std::invalid_argument If `write_size` or `max_in_flight` is zero.
+   * @throw std::system_error If the file could not be created or the AIO
+   * context could not be set up.
+   */
+  DiskRecorder(BatchedSPSCQueue &queue, const std::string &path,
+               const RecorderOptions &options = {});
+
+  DiskRecorder(const DiskRecorder &) = delete;
+  DiskRecorder &operator=(const DiskRecorder &) = delete;
+
+  /// Calls `finish()`, ignoring its errors, and closes the file.
+  ~DiskRecorder();
+
+  /**
+   * @brief Reaps the completed writes and submits the batches available.
+   *
+   * Once the queue is closed and every whole batch is written, writes the
+   * partial batch left, if any, and calls `finish()`.
+   *
+   * @return Whether the recording goes on, i.e. false once `finish()` was
+   * called.
+   *
+   * @throw std::system_error If a write failed.
+   */
+  bool poll();
+
+  /**
+   * @brief Calls `poll()` until the queue is closed and drained.
+   *
+   * @throw std::system_error If a write failed.
+   */
+  void run();
+
+  /**
+   * @brief Writes the bytes staged so far, waits for every write and sets the
+   * size of the file to the number of bytes recorded.
+   *
+   * Does nothing after the first call.
+   *
+   * @throw std::system_error If a write failed.
+   */
+  void finish();
+
+  /// Returns what the recorder did so far.
+  RecorderStats stats() const;
+
+private:
+  /// A write submitted to the kernel.
+  struct Write {
+    /// The identifier of the write, carried by its completion event.
+    uint64_t id;
+
+    /// The number of bytes submitted, padding included.
+    size_t size;
+
+    /// The number of bytes of the stream in the write.
+    size_t payload;
+
+    /// The number of batches to commit once written, in zero-copy mode.
+    size_t nb_batches;
+
+    /// The staging buffer written, or -1 in zero-copy mode.
+    int staging;
+
+    /// Whether the write completed.
+    bool done;
+  };
+
+  /// Submits the batches that follow the ones in flight, straight from the
+  /// queue buffer. Returns whether there were any.
+  bool submit_batches();
+
+  /// Copies the next batch into the staging buffers. Returns whether there
+  /// was one.
+  bool stage_batch();
+
+  /// Copies `size` bytes into the staging buffers, submitting every buffer
+  /// that gets full.
+  void stage(const uint8_t *data, size_t size);
+
+  /// Submits the current staging buffer, padded to the alignment.
+  void submit_staging();
+
+  /// Submits a write of `size` bytes at the end of the file.
+  void submit(const uint8_t *data, size_t size, size_t payload,
+              size_t nb_batches, int staging);
+
+  /// Reaps the completed writes, waiting for one if `wait` is set, and
+  /// releases the batches or staging buffers of the oldest ones.
+  void reap(bool wait);
+
+private:
+  /// The queue consumed.
+  BatchedSPSCQueue &queue_;
+
+  /// The options of the recorder.
+  RecorderOptions options_;
+
+  /// The file descriptor of the file.
+  int fd_;
+
+  /// Whether `fd_` was opened with `O_DIRECT`.
+  bool direct_io_;
+
+  /// The native AIO context.
+  aio_context_t context_;
+
+  /// The size in bytes of a dequeue batch.
+  size_t batch_bytes_;
+
+  /// Whether the batches are written straight from the queue buffer.
+  bool zero_copy_;
+
+  /// The writes in flight, oldest first.
+  std::deque<Write> in_flight_;
+
+  /// The completion events reaped at once.
+  std::vector<io_event> events_;
+
+  /// The identifier of the next write.
+  uint64_t next_id_ = 0;
+
+  /// The number of batches written from the queue buffer but not committed.
+  size_t pending_batches_ = 0;
+
+  /// `max_in_flight` buffers of `write_size` bytes, rounded up to the
+  /// alignment.
+  QueueBuffer staging_;
+
+  /// The size in bytes of each staging buffer.
+  size_t staging_size_;
+
+  /// Whether each staging buffer is being written.
+  std::vector<bool> staging_busy_;
+
+  /// The staging buffer being filled, or -1.
+  int staging_current_ = -1;
+
+  /// The number of bytes in the current staging buffer.
+  size_t staging_fill_ = 0;
+
+  /// The offset of the next write in the file.
+  uint64_t file_offset_ = 0;
+
+  /// The number of bytes of the stream submitted.
+  uint64_t bytes_submitted_ = 0;
+
+  /// The number of bytes of the stream written.
+  uint64_t bytes_written_ = 0;
+
+  /// When the first write was submitted and the last one completed.
+  std::chrono::steady_clock::time_point first_write_, last_completion_;
+
+  /// Whether `finish()` was called.
+  bool finished_ = false;
+};
+
+} // namespace holoflow
@@ -0,0 +1,167 @@
+#pragma once
+
+#include "batched_spsc_queue/batched_spsc_queue.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace holoflow {
+/**
+ * @brief How a `ReplaySource` spaces the frames it enqueues.
+ */
+enum class ReplayPacing {
+  /// As fast as the consumer dequeues them.
+  AsFastAsPossible,
+
+  /// `fps` frames per second.
+  FixedRate,
+
+  /// As they were captured, according to their `timestamp`.
+  Timestamps,
+};
+
+/**
+ * @brief Options of a `ReplaySource`.
+ */
+struct ReplayOptions {
+  /// How the frames are spaced. A batch is enqueued when its last frame is
+  /// due.
+  ReplayPacing pacing = ReplayPacing::AsFastAsPossible;
+
+  /// The frame rate of `ReplayPacing::FixedRate`.
+  double fps = 0;
+
+  /// Returns the capture time of a frame, for `ReplayPacing::Timestamps`.
+  /// Only the differences between frames matter.
+  std::function<std::chrono::nanoseconds(const uint8_t *frame)> timestamp;
+
+  /// Whether to enqueue pointers to the frames in the mapping rather than the
+  /// frames themselves. The elements of the queue are then `const uint8_t *`,
+  /// see `ReplaySource::frame()`.
+  bool zero_copy = false;
+
+  /// The size in bytes of a frame in zero-copy mode. In copy mode, a frame is
+  /// an element of the queue.
+  size_t frame_size = 0;
+
+  /// The number of bytes ahead of the producer whose pages are read ahead.
+  size_t prefetch = 64 << 20;
+};
+
+/**
+ * @class ReplaySource
+ * @brief The producer of a `BatchedSPSCQueue` that plays a recording back,
+ * e.g. a file written by `DiskRecorder`.
+ *
+ * The file is mapped read-only with sequential access advice, and the pages
+ * `prefetch` bytes ahead of the producer are requested with
+ * `madvise(MADV_WILLNEED)`, so that the page faults of the replay are mostly
+ * minor ones.
+ *
+ * In copy mode, each batch is copied from the mapping into the queue. In
+ * zero-copy mode, the queue carries pointers to the frames in the mapping,
+ * which stay valid until the source is destroyed.
+ *
+ * The file is made of frames back to back. A trailing partial frame, and the
+ * frames of a trailing partial enqueue batch, are not replayed. The queue is
+ * closed after the last batch.
+ *
+ * Each batch has the enqueue batch size of the queue at the time, so the
+ * queue can be reconfigured with `request_enqueue_batch_size()` during the
+ * replay.
+ */
+class ReplaySource {
+public:
+  /**
+   * @brief Maps the file.
+   *
+   * @param queue The queue to produce into. Must outlive the source.
+   * @param path The path of the recording.
+   * @param options See `ReplayOptions`.
+   *
+   * @throw std::invalid_argument If `fps` is not positive with
+   * `ReplayPacing::FixedRate`, `timestamp` is not set with
+   * `ReplayPacing::Timestamps`, or the elements of the queue do not match the
+   * zero-copy mode.
+   * @throw std::system_error If the file could not be opened or mapped.
+   */
+  ReplaySource(BatchedSPSCQueue &queue, const std::string &path,
+               const ReplayOptions &options = {});
+
+  ReplaySource(const ReplaySource &) = delete;
+  ReplaySource &operator=(const ReplaySource &) = delete;
+
+  /// Unmaps the file.
+  ~ReplaySource();
+
+  /**
+   * @brief Enqueues the next batch if it is due and the queue has room for it.
+   *
+   * The clock of the replay starts at the first call to `poll()` or `run()`.
+   *
+   * @return Whether the replay goes on, i.e. false once the queue is closed.
+   */
+  bool poll();
+
+  /// Enqueues every batch when due, waiting for room in the queue, then closes
+  /// the queue.
+  void run();
+
+  /// Returns the number of frames in the file.
+  size_t nb_frames() const;
+
+  /// Returns the number of frames enqueued so far.
+  size_t frames_replayed() const;
+
+  /// Returns the frame pointed to by an element of a zero-copy queue.
+  static const uint8_t *frame(const uint8_t *element);
+
+private:
+  /// Returns when the batch starting at `next_frame_` is due.
+  std::chrono::steady_clock::time_point deadline() const;
+
+  /// Fills `write_ptr` with the next batch and commits it.
+  void enqueue(uint8_t *write_ptr);
+
+  /// Reads ahead the pages that follow the producer.
+  void prefetch();
+
+private:
+  /// The queue fed.
+  BatchedSPSCQueue &queue_;
+
+  /// The options of the source.
+  ReplayOptions options_;
+
+  /// The mapping of the file, or `nullptr` if it is empty.
+  const uint8_t *data_;
+
+  /// The size in bytes of the file.
+  size_t size_;
+
+  /// The size in bytes of a frame.
+  size_t frame_size_;
+
+  /// The number of frames in the file.
+  size_t nb_frames_;
+
+  /// The first frame not enqueued yet.
+  size_t next_frame_ = 0;
+
+  /// The end of the range read ahead so far.
+  size_t prefetched_ = 0;
+
+  /// When the replay started, if it did.
+  std::chrono::steady_clock::time_point start_;
+
+  /// Whether the replay started.
+  bool started_ = false;
+
+  /// Whether the queue was closed.
+  bool done_ = false;
+};
+
+} // namespace holoflow
@@ -0,0 +1,129 @@
+#include "batched_broadcast_queue/batched_broadcast_queue.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+namespace holoflow {
+BatchedBroadcastQueue::BatchedBroadcastQueue(
+    size_t nb_slots, size_t enqueue_batch_size, size_t element_size,
+    uint8_t *buffer, const std::vector<BroadcastConsumerOptions> &consumers)
+    : nb_slots_(nb_slots), enqueue_batch_size_(enqueue_batch_size),
+      element_size_(element_size), buffer_(buffer),
+      nb_consumers_(consumers.size()),
+      consumers_(new Consumer[consumers.size()]), has_lossy_(false),
+      write_pos_(0), reserved_pos_(0), cached_min_read_pos_(0) {
+  for (size_t i = 0; i < nb_consumers_; i++) {
+    Consumer &consumer = consumers_[i];
+    consumer.read_pos.store(0, std::memory_order_relaxed);
+    consumer.dequeue_batch_size = consumers[i].dequeue_batch_size;
+    consumer.lossy = consumers[i].lossy;
+    consumer.cached_write_pos = 0;
+    consumer.skipped.store(0, std::memory_order_relaxed);
+    has_lossy_ |= consumer.lossy;
+  }
+}
+
+uint8_t *BatchedBroadcastQueue::write_ptr() {
+  size_t write_pos = write_pos_.load(std::memory_order_relaxed);
+
+  // Only go over the consumers when the cached position says the queue is
+  // full.
+  if (write_pos + enqueue_batch_size_ - cached_min_read_pos_ > nb_slots_) {
+    cached_min_read_pos_ = min_read_pos(write_pos);
+    if (write_pos + enqueue_batch_size_ - cached_min_read_pos_ > nb_slots_)
+      return nullptr;
+  }
+
+  if (has_lossy_) {
+    // Announce the batch before writing it. The fence pairs with the one in
+    // commit_read(): a lossy consumer that reads anything written from now on
+    // also sees the new reserved position.
+    reserved_pos_.store(write_pos + enqueue_batch_size_,
+                        std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  return buffer_ + (write_pos % nb_slots_) * element_size_;
+}
+
+void BatchedBroadcastQueue::commit_write() {
+  size_t write_pos = write_pos_.load(std::memory_order_relaxed);
+  write_pos_.store(write_pos + enqueue_batch_size_, std::memory_order_release);
+}
+
+uint8_t *BatchedBroadcastQueue::read_ptr(size_t consumer) {
+  Consumer &self = consumers_[consumer];
+  size_t read_pos = self.read_pos.load(std::memory_order_relaxed);
+  size_t dequeue_batch_size = self.dequeue_batch_size;
+
+  // The producer never waits for a lossy consumer, so a cached position may
+  // be laps behind: the overrun check below needs the latest one.
+  if (self.lossy || self.cached_write_pos - read_pos < dequeue_batch_size) {
+    self.cached_write_pos = write_pos_.load(std::memory_order_acquire);
+    if (self.cached_write_pos - read_pos < dequeue_batch_size)
+      return nullptr;
+  }
+
+  // A lossy consumer whose batch may already be overwritten by the batch the
+  // producer is writing skips to the latest complete batch.
+  if (self.lossy &&
+      self.cached_write_pos + enqueue_batch_size_ > read_pos + nb_slots_) {
+    size_t latest = self.cached_write_pos -
+                    self.cached_write_pos % dequeue_batch_size -
+                    dequeue_batch_size;
+    self.skipped.store(self.skipped.load(std::memory_order_relaxed) + latest -
+                           read_pos,
+                       std::memory_order_relaxed);
+    read_pos = latest;
+    self.read_pos.store(read_pos, std::memory_order_relaxed);
+  }
+
+  return buffer_ + (read_pos % nb_slots_) * element_size_;
+}
+
+bool BatchedBroadcastQueue::commit_read(size_t consumer) {
+  Consumer &self = consumers_[consumer];
+  size_t read_pos = self.read_pos.load(std::memory_order_relaxed);
+
+  bool intact = true;
+  if (self.lossy) {
+    // Every read of the batch happens before this fence. If one of them saw a
+    // write of the producer made after it announced a batch, the announced
+    // position is visible below.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    intact = reserved_pos_.load(std::memory_order_relaxed) <=
+             read_pos + nb_slots_;
+  }
+
+  self.read_pos.store(read_pos + self.dequeue_batch_size,
+                      std::memory_order_release);
+  return intact;
+}
+
+size_t BatchedBroadcastQueue::size(size_t consumer) {
+  size_t read_pos =
+      consumers_[consumer].read_pos.load(std::memory_order_acquire);
+  size_t write_pos = write_pos_.load(std::memory_order_acquire);
+
+  return write_pos - std::min(read_pos, write_pos);
+}
+
+size_t BatchedBroadcastQueue::skipped(size_t consumer) const {
+  return consumers_[consumer].skipped.load(std::memory_order_relaxed);
+}
+
+size_t BatchedBroadcastQueue::nb_consumers() const { return nb_consumers_; }
+
+size_t BatchedBroadcastQueue::min_read_pos(size_t write_pos) const {
+  size_t min_pos = write_pos;
+  for (size_t i = 0; i < nb_consumers_; i++) {
+    const Consumer &consumer = consumers_[i];
+    if (!consumer.lossy)
+      min_pos = std::min(min_pos,
+                         consumer.read_pos.load(std::memory_order_acquire));
+  }
+
+  return min_pos;
+}
+} // namespace holoflow
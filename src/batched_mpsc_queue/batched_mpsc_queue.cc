@@ -0,0 +1,112 @@
+#include "batched_mpsc_queue/batched_mpsc_queue.hh"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+namespace holoflow {
+BatchedMPSCQueue::BatchedMPSCQueue(size_t nb_slots, size_t enqueue_batch_size,
+                                   size_t dequeue_batch_size,
+                                   size_t element_size, uint8_t *buffer)
+    : nb_slots_(nb_slots), enqueue_batch_size_(enqueue_batch_size),
+      dequeue_batch_size_(dequeue_batch_size), element_size_(element_size),
+      nb_batches_(
+          check_geometry(nb_slots, enqueue_batch_size, dequeue_batch_size)),
+      buffer_(buffer), slots_(new Slot[nb_batches_]), write_pos_(0),
+      read_pos_(0), committed_batches_(0) {
+  for (size_t i = 0; i < nb_batches_; i++)
+    slots_[i].seq.store(i, std::memory_order_relaxed);
+}
+
+uint8_t *BatchedMPSCQueue::write_ptr() {
+  size_t pos = write_pos_.load(std::memory_order_relaxed);
+
+  while (true) {
+    Slot &slot = slots_[pos % nb_batches_];
+    size_t seq = slot.seq.load(std::memory_order_acquire);
+    auto diff = static_cast<ptrdiff_t>(seq - pos);
+
+    if (diff == 0) {
+      // The slot is free for this lap, try to reserve it. On failure, `pos`
+      // is updated with the position another producer left.
+      if (write_pos_.compare_exchange_weak(pos, pos + 1,
+                                           std::memory_order_relaxed))
+        return buffer_ + (pos % nb_batches_) * enqueue_batch_size_ *
+                             element_size_;
+    } else if (diff < 0) {
+      // The slot still holds the batch of the previous lap: the queue is full.
+      return nullptr;
+    } else {
+      // Another producer reserved this position in the meantime.
+      pos = write_pos_.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+void BatchedMPSCQueue::commit_write(uint8_t *write_ptr) {
+  size_t idx = static_cast<size_t>(write_ptr - buffer_) /
+               (enqueue_batch_size_ * element_size_);
+
+  // The slot is reserved by the calling thread, nobody else writes its
+  // sequence number until it is committed.
+  Slot &slot = slots_[idx];
+  size_t seq = slot.seq.load(std::memory_order_relaxed);
+  slot.seq.store(seq + 1, std::memory_order_release);
+}
+
+uint8_t *BatchedMPSCQueue::read_ptr() {
+  size_t read_pos = read_pos_.load(std::memory_order_relaxed);
+  size_t needed_batches =
+      (read_pos + dequeue_batch_size_ + enqueue_batch_size_ - 1) /
+      enqueue_batch_size_;
+
+  // Check the enqueue batches the dequeue batch overlaps, in order.
+  while (committed_batches_ < needed_batches) {
+    const Slot &slot = slots_[committed_batches_ % nb_batches_];
+    if (slot.seq.load(std::memory_order_acquire) != committed_batches_ + 1)
+      return nullptr;
+    committed_batches_++;
+  }
+
+  return buffer_ + (read_pos % nb_slots_) * element_size_;
+}
+
+void BatchedMPSCQueue::commit_read() {
+  size_t read_pos = read_pos_.load(std::memory_order_relaxed);
+  size_t next_read_pos = read_pos + dequeue_batch_size_;
+
+  // Release the enqueue batches that are now entirely read for the next lap.
+  for (size_t batch = read_pos / enqueue_batch_size_;
+       batch < next_read_pos / enqueue_batch_size_; batch++)
+    slots_[batch % nb_batches_].seq.store(batch + nb_batches_,
+                                          std::memory_order_release);
+
+  read_pos_.store(next_read_pos, std::memory_order_release);
+}
+
+size_t BatchedMPSCQueue::check_geometry(size_t nb_slots,
+                                        size_t enqueue_batch_size,
+                                        size_t dequeue_batch_size) {
+  if (enqueue_batch_size == 0 || dequeue_batch_size == 0 ||
+      nb_slots % enqueue_batch_size != 0 || nb_slots % dequeue_batch_size != 0)
+    throw std::invalid_argument(
+        "nb_slots must be a non-zero multiple of both batch sizes");
+
+  // With a single enqueue batch, the sequence number of a committed batch
+  // equals the one of the free slot of the next lap, and producers would
+  // overwrite it before it is read.
+  if (nb_slots / enqueue_batch_size < 2)
+    throw std::invalid_argument(
+        "nb_slots must hold at least two enqueue batches");
+
+  return nb_slots / enqueue_batch_size;
+}
+
+size_t BatchedMPSCQueue::size() {
+  size_t read_pos = read_pos_.load(std::memory_order_acquire);
+  size_t write_pos = write_pos_.load(std::memory_order_acquire);
+
+  return write_pos * enqueue_batch_size_ - read_pos;
+}
+} // namespace holoflow
@@ -1,89 +1,708 @@
 #include "batched_spsc_queue/batched_spsc_queue.hh"
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <cstdint>
+#include <ctime>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 namespace holoflow {
+namespace {
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) &&
+                  std::atomic<uint32_t>::is_always_lock_free,
+              "Parking words must be usable as futexes");
+static_assert(std::atomic<size_t>::is_always_lock_free &&
+                  std::atomic<uint64_t>::is_always_lock_free &&
+                  std::atomic<bool>::is_always_lock_free,
+              "Indexes must be lock-free to be shared between processes");
+
+/// Identifies the control block of a shared queue and its layout version.
+constexpr uint64_t SHARED_QUEUE_MAGIC = 0x686f6c6f666c0002;
+
+/// The positions of the enqueue and dequeue sizes in `pending_batch_sizes`.
+constexpr unsigned ENQUEUE_SHIFT = 0;
+constexpr unsigned DEQUEUE_SHIFT = 32;
+constexpr uint64_t PENDING_MASK = 0xffffffff;
+
+/// Returns the pending batch size at `shift` in `pending`, or 0.
+inline size_t pending_batch_size(uint64_t pending, unsigned shift) {
+  return static_cast<size_t>((pending >> shift) & PENDING_MASK);
+}
+
+/// Tells the CPU we are in a spin loop.
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+  _mm_pause();
+#endif
+}
+
+/// Sleeps while `*word == expected`, at most `timeout` if not null.
+/// `std::atomic::wait` has no timed variant, hence the raw futex. A word in
+/// memory shared with another process needs the non-private operations.
+inline void futex_wait(std::atomic<uint32_t> &word, uint32_t expected,
+                       const timespec *timeout, bool shared) {
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word),
+          shared ? FUTEX_WAIT : FUTEX_WAIT_PRIVATE, expected, timeout, nullptr,
+          0);
+}
+
+/// Wakes up one thread sleeping on `word`.
+inline void futex_wake(std::atomic<uint32_t> &word, bool shared) {
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word),
+          shared ? FUTEX_WAKE : FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+}
+
+#ifdef HOLOFLOW_QUEUE_TELEMETRY
+/// Adds `n` to a counter that only the calling thread writes. A plain
+/// load/store pair is enough and avoids a locked instruction.
+template <typename T> inline void bump(std::atomic<T> &counter, T n) {
+  counter.store(counter.load(std::memory_order_relaxed) + n,
+                std::memory_order_relaxed);
+}
+
+/// Raises `mark` to `value` if it is lower. Only the calling thread writes it.
+inline void raise(std::atomic<size_t> &mark, size_t value) {
+  if (value > mark.load(std::memory_order_relaxed))
+    mark.store(value, std::memory_order_relaxed);
+}
+#endif
+} // namespace
+
 BatchedSPSCQueue::BatchedSPSCQueue(size_t nb_slots, size_t enqueue_batch_size,
                                    size_t dequeue_batch_size,
                                    size_t element_size, uint8_t *buffer)
     : nb_slots_(nb_slots), enqueue_batch_size_(enqueue_batch_size),
       dequeue_batch_size_(dequeue_batch_size), element_size_(element_size),
-      buffer_(buffer), write_idx_(0), read_idx_(0) {}
+      buffer_(buffer), owned_buffer_(), mirrored_(false), wait_strategy_(),
+      parking_(false), control_(&local_control_), shared_(false),
+      cached_read_idx_(0), cached_write_idx_(0), misaligned_(false),
+      local_control_() {
+  // `request_*_batch_size()` checks a new size against the other side's.
+  local_control_.enqueue_batch_size.store(enqueue_batch_size,
+                                          std::memory_order_relaxed);
+  local_control_.dequeue_batch_size.store(dequeue_batch_size,
+                                          std::memory_order_relaxed);
+}
 
-uint8_t *BatchedSPSCQueue::write_ptr() {
-  if (nb_slots_ - writer_size() < enqueue_batch_size_ + 1) {
-    return nullptr;
+BatchedSPSCQueue::BatchedSPSCQueue(size_t nb_slots, size_t enqueue_batch_size,
+                                   size_t dequeue_batch_size,
+                                   size_t element_size, QueueBuffer buffer)
+    : BatchedSPSCQueue(nb_slots, enqueue_batch_size, dequeue_batch_size,
+                       element_size, buffer.data()) {
+  check_geometry(nb_slots, enqueue_batch_size, dequeue_batch_size,
+                 buffer.is_mirrored());
+
+  if (buffer.is_mirrored()) {
+    if (buffer.size() != nb_slots * element_size)
+      throw std::invalid_argument(
+          "Mirrored buffer size must be nb_slots * element_size");
+  } else if (buffer.size() < nb_slots * element_size) {
+    throw std::invalid_argument(
+        "Buffer size must be at least nb_slots * element_size");
   }
 
-  size_t write_idx = write_idx_.load(std::memory_order_relaxed);
-  return buffer_ + write_idx * element_size_;
+  mirrored_ = buffer.is_mirrored();
+  owned_buffer_ = std::move(buffer);
 }
 
-void BatchedSPSCQueue::commit_write() {
-  size_t write_idx = write_idx_.load(std::memory_order_relaxed);
-  size_t next_write_idx = write_idx + enqueue_batch_size_;
-  if (next_write_idx == nb_slots_)
-    next_write_idx = 0;
+std::unique_ptr<BatchedSPSCQueue>
+BatchedSPSCQueue::create_shared(const std::string &name, size_t nb_slots,
+                                size_t enqueue_batch_size,
+                                size_t dequeue_batch_size,
+                                size_t element_size) {
+  check_geometry(nb_slots, enqueue_batch_size, dequeue_batch_size, false);
+
+  QueueBuffer segment = QueueBuffer::create_shared(
+      name, control_size() + nb_slots * element_size);
+  auto queue = std::make_unique<BatchedSPSCQueue>(
+      nb_slots, enqueue_batch_size, dequeue_batch_size, element_size,
+      segment.data() + control_size());
 
-  write_idx_.store(next_write_idx, std::memory_order_release);
+  ControlBlock *control = new (segment.data()) ControlBlock();
+  control->nb_slots = nb_slots;
+  control->enqueue_batch_size.store(enqueue_batch_size,
+                                    std::memory_order_relaxed);
+  control->dequeue_batch_size.store(dequeue_batch_size,
+                                    std::memory_order_relaxed);
+  control->element_size = element_size;
+
+  // Publish the geometry last, an attaching process checks the magic first.
+  control->magic.store(SHARED_QUEUE_MAGIC, std::memory_order_release);
+
+  queue->control_ = control;
+  queue->shared_ = true;
+  queue->owned_buffer_ = std::move(segment);
+  return queue;
 }
 
+std::unique_ptr<BatchedSPSCQueue>
+BatchedSPSCQueue::attach_shared(const std::string &name) {
+  QueueBuffer segment = QueueBuffer::open_shared(name);
+  if (segment.size() < control_size())
+    throw std::invalid_argument("Shared memory segment is not a queue");
+
+  auto *control = reinterpret_cast<ControlBlock *>(segment.data());
+  if (control->magic.load(std::memory_order_acquire) != SHARED_QUEUE_MAGIC)
+    throw std::invalid_argument("Shared memory segment is not a queue");
+  if (segment.size() <
+      control_size() + control->nb_slots * control->element_size)
+    throw std::invalid_argument("Shared memory segment is too small");
+
+  size_t dequeue_batch_size =
+      control->dequeue_batch_size.load(std::memory_order_relaxed);
+  auto queue = std::make_unique<BatchedSPSCQueue>(
+      control->nb_slots,
+      control->enqueue_batch_size.load(std::memory_order_relaxed),
+      dequeue_batch_size, control->element_size,
+      segment.data() + control_size());
+
+  // Resume from where the previous process left the queue.
+  size_t write_idx = control->write_idx.load(std::memory_order_acquire);
+  size_t read_idx = control->read_idx.load(std::memory_order_acquire);
+  queue->cached_read_idx_ = read_idx;
+  queue->cached_write_idx_ = write_idx;
+  queue->misaligned_ = read_idx % dequeue_batch_size != 0;
+
+  queue->control_ = control;
+  queue->shared_ = true;
+  queue->owned_buffer_ = std::move(segment);
+  return queue;
+}
+
+uint8_t *BatchedSPSCQueue::write_ptr() {
+  size_t write_idx = control_->write_idx.load(std::memory_order_relaxed);
+
+  // Only go fetch the reader's index when the cached one says the queue is
+  // full.
+  if (nb_slots_ - distance(write_idx, cached_read_idx_) <
+      enqueue_batch_size_ + 1) {
+    cached_read_idx_ = control_->read_idx.load(std::memory_order_acquire);
+    if (nb_slots_ - distance(write_idx, cached_read_idx_) <
+        enqueue_batch_size_ + 1) {
+#ifdef HOLOFLOW_QUEUE_TELEMETRY
+      bump<uint64_t>(writer_counters_.stalls, 1);
+      raise(occupancy_.high_water_mark, distance(write_idx, cached_read_idx_));
+#endif
+      return nullptr;
+    }
+  }
+
+  return buffer_ + write_idx * element_size_;
+}
+
+void BatchedSPSCQueue::commit_write() { commit_write(1); }
+
 uint8_t *BatchedSPSCQueue::read_ptr() {
-  if (reader_size() < dequeue_batch_size_)
+  // After a partial read, only read_ptr_partial() may complete the batch.
+  if (misaligned_)
     return nullptr;
 
-  size_t read_idx = read_idx_.load(std::memory_order_relaxed);
+  size_t read_idx = control_->read_idx.load(std::memory_order_relaxed);
+
+  // Only go fetch the writer's index when the cached one says the queue is
+  // empty.
+  if (distance(cached_write_idx_, read_idx) < dequeue_batch_size_) {
+    cached_write_idx_ = control_->write_idx.load(std::memory_order_acquire);
+    if (distance(cached_write_idx_, read_idx) < dequeue_batch_size_) {
+#ifdef HOLOFLOW_QUEUE_TELEMETRY
+      bump<uint64_t>(reader_counters_.stalls, 1);
+#endif
+      return nullptr;
+    }
+  }
+
   return buffer_ + read_idx * element_size_;
 }
 
-void BatchedSPSCQueue::commit_read() {
-  size_t read_idx = read_idx_.load(std::memory_order_relaxed);
-  size_t next_read_idx = read_idx + dequeue_batch_size_;
-  if (next_read_idx == nb_slots_)
-    next_read_idx = 0;
+void BatchedSPSCQueue::commit_read() { commit_read(1); }
 
-  read_idx_.store(next_read_idx, std::memory_order_release);
+std::span<uint8_t> BatchedSPSCQueue::write_span(size_t max_batches) {
+  size_t write_idx = control_->write_idx.load(std::memory_order_relaxed);
+
+  // At least one slot has to stay empty, see write_ptr(). A mirrored buffer
+  // has no wrap point.
+  size_t until_wrap = mirrored_ ? std::numeric_limits<size_t>::max()
+                                : (nb_slots_ - write_idx) / enqueue_batch_size_;
+  size_t wanted = std::min(max_batches, until_wrap);
+  size_t nb_batches =
+      (nb_slots_ - 1 - distance(write_idx, cached_read_idx_)) /
+      enqueue_batch_size_;
+
+  if (nb_batches < wanted) {
+    cached_read_idx_ = control_->read_idx.load(std::memory_order_acquire);
+    nb_batches = (nb_slots_ - 1 - distance(write_idx, cached_read_idx_)) /
+                 enqueue_batch_size_;
+  }
+
+  nb_batches = std::min(nb_batches, wanted);
+#ifdef HOLOFLOW_QUEUE_TELEMETRY
+  if (nb_batches == 0 && wanted > 0) {
+    bump<uint64_t>(writer_counters_.stalls, 1);
+    raise(occupancy_.high_water_mark, distance(write_idx, cached_read_idx_));
+  }
+#endif
+  return {buffer_ + write_idx * element_size_,
+          nb_batches * enqueue_batch_size_ * element_size_};
 }
 
-[[maybe_unused]] size_t BatchedSPSCQueue::size() {
-  size_t write_idx = write_idx_.load(std::memory_order_acquire);
-  size_t read_idx = read_idx_.load(std::memory_order_acquire);
+void BatchedSPSCQueue::commit_write(size_t nb_batches) {
+  size_t write_idx = control_->write_idx.load(std::memory_order_relaxed);
+  size_t next_write_idx = advance(write_idx, nb_batches * enqueue_batch_size_);
 
-  size_t diff = write_idx - read_idx;
+  // A flush only covers the elements committed before it. Clearing it before
+  // publishing the index keeps the reader from seeing the new index with the
+  // old flush.
+  if (control_->flushed.load(std::memory_order_relaxed))
+    control_->flushed.store(false, std::memory_order_relaxed);
 
-  if (write_idx < read_idx)
-    diff += nb_slots_;
+  control_->write_idx.store(next_write_idx, std::memory_order_release);
 
-  return diff;
+#ifdef HOLOFLOW_QUEUE_TELEMETRY
+  record_write(next_write_idx, nb_batches);
+#endif
+
+  // The request is on a line that is almost never written, so checking it
+  // only costs a load that hits the cache.
+  if (pending_batch_size(
+          control_->pending_batch_sizes.load(std::memory_order_relaxed),
+          ENQUEUE_SHIFT))
+    apply_batch_size(ENQUEUE_SHIFT, enqueue_batch_size_,
+                     control_->enqueue_batch_size, next_write_idx);
+
+  if (parking_)
+    notify(control_->reader_parked);
+}
+
+std::span<uint8_t> BatchedSPSCQueue::read_span(size_t max_batches) {
+  if (misaligned_)
+    return {};
+
+  size_t read_idx = control_->read_idx.load(std::memory_order_relaxed);
+
+  size_t until_wrap = mirrored_ ? std::numeric_limits<size_t>::max()
+                                : (nb_slots_ - read_idx) / dequeue_batch_size_;
+  size_t wanted = std::min(max_batches, until_wrap);
+  size_t nb_batches =
+      distance(cached_write_idx_, read_idx) / dequeue_batch_size_;
+
+  if (nb_batches < wanted) {
+    cached_write_idx_ = control_->write_idx.load(std::memory_order_acquire);
+    nb_batches = distance(cached_write_idx_, read_idx) / dequeue_batch_size_;
+  }
+
+  nb_batches = std::min(nb_batches, wanted);
+#ifdef HOLOFLOW_QUEUE_TELEMETRY
+  if (nb_batches == 0 && wanted > 0)
+    bump<uint64_t>(reader_counters_.stalls, 1);
+#endif
+  return {buffer_ + read_idx * element_size_,
+          nb_batches * dequeue_batch_size_ * element_size_};
+}
+
+void BatchedSPSCQueue::commit_read(size_t nb_batches) {
+  size_t read_idx = control_->read_idx.load(std::memory_order_relaxed);
+  size_t next_read_idx = advance(read_idx, nb_batches * dequeue_batch_size_);
+
+  control_->read_idx.store(next_read_idx, std::memory_order_release);
+
+#ifdef HOLOFLOW_QUEUE_TELEMETRY
+  bump<uint64_t>(reader_counters_.batches, nb_batches);
+#endif
+
+  if (pending_batch_size(
+          control_->pending_batch_sizes.load(std::memory_order_relaxed),
+          DEQUEUE_SHIFT))
+    apply_batch_size(DEQUEUE_SHIFT, dequeue_batch_size_,
+                     control_->dequeue_batch_size, next_read_idx);
+
+  if (parking_)
+    notify(control_->writer_parked);
+}
+
+void BatchedSPSCQueue::flush() {
+  control_->flushed.store(true, std::memory_order_release);
+
+  if (parking_)
+    notify(control_->reader_parked);
+}
+
+void BatchedSPSCQueue::close() {
+  // Flush first, so that a reader that sees the queue closed sees the flush.
+  control_->flushed.store(true, std::memory_order_release);
+  control_->closed.store(true, std::memory_order_release);
+
+  // Only wake up the reader once closed, so that it does not park again.
+  if (parking_)
+    notify(control_->reader_parked);
+}
+
+bool BatchedSPSCQueue::is_closed() const {
+  return control_->closed.load(std::memory_order_acquire);
+}
+
+uint8_t *BatchedSPSCQueue::read_ptr_partial(size_t &count) {
+  size_t read_idx = control_->read_idx.load(std::memory_order_relaxed);
+
+  // Stop at the next batch boundary, so that the elements never straddle the
+  // end of the circular buffer. A mirrored buffer has no such constraint.
+  size_t wanted = mirrored_ ? dequeue_batch_size_
+                            : dequeue_batch_size_ -
+                                  read_idx % dequeue_batch_size_;
+  size_t available = distance(cached_write_idx_, read_idx);
+
+  if (available < wanted) {
+    cached_write_idx_ = control_->write_idx.load(std::memory_order_acquire);
+    available = distance(cached_write_idx_, read_idx);
+
+    // The flush is loaded after the index: if it is still set, it covers at
+    // least the elements up to the loaded index.
+    if (available < wanted) {
+      if (available == 0 ||
+          !control_->flushed.load(std::memory_order_acquire)) {
+#ifdef HOLOFLOW_QUEUE_TELEMETRY
+        bump<uint64_t>(reader_counters_.stalls, 1);
+#endif
+        return nullptr;
+      }
+      wanted = available;
+    }
+  }
+
+  count = wanted;
+  return buffer_ + read_idx * element_size_;
+}
+
+void BatchedSPSCQueue::commit_read_partial(size_t count) {
+  size_t read_idx = control_->read_idx.load(std::memory_order_relaxed);
+  size_t next_read_idx = advance(read_idx, count);
+
+  control_->read_idx.store(next_read_idx, std::memory_order_release);
+  misaligned_ = !mirrored_ && next_read_idx % dequeue_batch_size_ != 0;
+
+  // A new size the index is aligned on also ends the partial batch.
+  if (pending_batch_size(
+          control_->pending_batch_sizes.load(std::memory_order_relaxed),
+          DEQUEUE_SHIFT) &&
+      apply_batch_size(DEQUEUE_SHIFT, dequeue_batch_size_,
+                       control_->dequeue_batch_size, next_read_idx))
+    misaligned_ = false;
+
+#ifdef HOLOFLOW_QUEUE_TELEMETRY
+  bump<uint64_t>(reader_counters_.batches, 1);
+#endif
+
+  if (parking_)
+    notify(control_->writer_parked);
+}
+
+uint8_t *BatchedSPSCQueue::wait_write_ptr() {
+  return wait(&BatchedSPSCQueue::write_ptr, control_->writer_parked,
+              nullptr, false);
+}
+
+uint8_t *BatchedSPSCQueue::wait_write_ptr(std::chrono::nanoseconds timeout) {
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+  return wait(&BatchedSPSCQueue::write_ptr, control_->writer_parked,
+              &deadline, false);
+}
+
+uint8_t *BatchedSPSCQueue::wait_read_ptr() {
+  return wait(&BatchedSPSCQueue::read_ptr, control_->reader_parked,
+              nullptr, true);
+}
+
+uint8_t *BatchedSPSCQueue::wait_read_ptr(std::chrono::nanoseconds timeout) {
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+  return wait(&BatchedSPSCQueue::read_ptr, control_->reader_parked,
+              &deadline, true);
+}
+
+void BatchedSPSCQueue::set_wait_strategy(const WaitStrategy &strategy) {
+  wait_strategy_ = strategy;
+  parking_ = strategy.policy == WaitPolicy::SpinPark;
+}
+
+void BatchedSPSCQueue::request_enqueue_batch_size(size_t enqueue_batch_size) {
+  request_batch_size(enqueue_batch_size, ENQUEUE_SHIFT,
+                     control_->dequeue_batch_size);
+}
+
+void BatchedSPSCQueue::request_dequeue_batch_size(size_t dequeue_batch_size) {
+  request_batch_size(dequeue_batch_size, DEQUEUE_SHIFT,
+                     control_->enqueue_batch_size);
+}
+
+size_t BatchedSPSCQueue::element_size() const { return element_size_; }
+
+size_t BatchedSPSCQueue::enqueue_batch_size() const {
+  return enqueue_batch_size_;
+}
+
+size_t BatchedSPSCQueue::dequeue_batch_size() const {
+  return dequeue_batch_size_;
+}
+
+[[maybe_unused]] size_t BatchedSPSCQueue::size() {
+  size_t write_idx = control_->write_idx.load(std::memory_order_acquire);
+  size_t read_idx = control_->read_idx.load(std::memory_order_acquire);
+
+  return distance(write_idx, read_idx);
+}
+
+QueueTelemetry BatchedSPSCQueue::telemetry() const {
+  QueueTelemetry telemetry;
+#ifdef HOLOFLOW_QUEUE_TELEMETRY
+  telemetry.enabled = true;
+  telemetry.write_stalls =
+      writer_counters_.stalls.load(std::memory_order_relaxed);
+  telemetry.read_stalls =
+      reader_counters_.stalls.load(std::memory_order_relaxed);
+  telemetry.write_batches =
+      writer_counters_.batches.load(std::memory_order_relaxed);
+  telemetry.read_batches =
+      reader_counters_.batches.load(std::memory_order_relaxed);
+  telemetry.high_water_mark =
+      occupancy_.high_water_mark.load(std::memory_order_relaxed);
+  for (size_t i = 0; i < QUEUE_OCCUPANCY_BUCKETS; i++)
+    telemetry.occupancy_histogram[i] =
+        occupancy_.histogram[i].load(std::memory_order_relaxed);
+#endif
+  return telemetry;
 }
 
 void BatchedSPSCQueue::reset() {
-  write_idx_.store(0, std::memory_order_release);
-  read_idx_.store(0, std::memory_order_release);
+  control_->write_idx.store(0, std::memory_order_release);
+  control_->read_idx.store(0, std::memory_order_release);
+  control_->flushed.store(false, std::memory_order_release);
+  control_->closed.store(false, std::memory_order_release);
+  cached_read_idx_ = 0;
+  cached_write_idx_ = 0;
+  misaligned_ = false;
 }
 
 void BatchedSPSCQueue::fill() {
-  write_idx_.store(nb_slots_, std::memory_order_release);
-  read_idx_.store(0, std::memory_order_release);
+  // As many whole batches as write_span() lets the writer enqueue. Without a
+  // mirror, this is `nb_slots_ - enqueue_batch_size_`.
+  size_t size = (nb_slots_ - 1) / enqueue_batch_size_ * enqueue_batch_size_;
+
+  control_->write_idx.store(size, std::memory_order_release);
+  control_->read_idx.store(0, std::memory_order_release);
+  cached_read_idx_ = 0;
+  cached_write_idx_ = size;
+  misaligned_ = false;
 }
 
-size_t BatchedSPSCQueue::writer_size() {
-  size_t write_idx = write_idx_.load(std::memory_order_relaxed);
-  size_t read_idx = read_idx_.load(std::memory_order_acquire);
+uint8_t *
+BatchedSPSCQueue::wait(uint8_t *(BatchedSPSCQueue::*acquire)(),
+                       std::atomic<uint32_t> &parked,
+                       const std::chrono::steady_clock::time_point *deadline,
+                       bool drain) {
+  const WaitStrategy &strategy = wait_strategy_;
+  const size_t yield_until =
+      strategy.spin_iterations + strategy.yield_iterations;
 
-  size_t diff = write_idx - read_idx;
+  for (size_t i = 0;; i++) {
+    if (uint8_t *ptr = (this->*acquire)())
+      return ptr;
 
-  if (write_idx < read_idx)
-    diff += nb_slots_;
+    // A closed queue gets no more elements, and after a partial read only
+    // read_ptr_partial() can read them. The elements committed before the
+    // close are visible once it is, hence the last poll.
+    if (drain && (misaligned_ || is_closed()))
+      return (this->*acquire)();
 
-  return diff;
+    // Reading the clock is much slower than polling the queue, only do it
+    // every few polls while spinning.
+    bool spinning = i < strategy.spin_iterations ||
+                    strategy.policy == WaitPolicy::Spin;
+    if (deadline && (!spinning || i % 64 == 0) &&
+        std::chrono::steady_clock::now() >= *deadline)
+      return nullptr;
+
+    if (spinning) {
+      cpu_relax();
+      continue;
+    }
+
+    if (strategy.policy == WaitPolicy::SpinYield || i < yield_until) {
+      std::this_thread::yield();
+      continue;
+    }
+
+    // Raise the flag before checking the queue one last time. The fence pairs
+    // with the one in `notify()`: either the other side sees the flag, or we
+    // see its commit.
+    parked.store(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (uint8_t *ptr = (this->*acquire)()) {
+      parked.store(0, std::memory_order_relaxed);
+      return ptr;
+    }
+    if (drain && is_closed()) {
+      parked.store(0, std::memory_order_relaxed);
+      return (this->*acquire)();
+    }
+
+    timespec timeout;
+    if (deadline) {
+      auto remaining = *deadline - std::chrono::steady_clock::now();
+      if (remaining <= std::chrono::steady_clock::duration::zero()) {
+        parked.store(0, std::memory_order_relaxed);
+        return nullptr;
+      }
+      auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(remaining)
+                    .count();
+      timeout.tv_sec = static_cast<time_t>(ns / 1000000000);
+      timeout.tv_nsec = static_cast<long>(ns % 1000000000);
+    }
+
+    futex_wait(parked, 1, deadline ? &timeout : nullptr, shared_);
+    parked.store(0, std::memory_order_relaxed);
+  }
+}
+
+void BatchedSPSCQueue::notify(std::atomic<uint32_t> &parked) {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (parked.load(std::memory_order_relaxed) &&
+      parked.exchange(0, std::memory_order_relaxed))
+    futex_wake(parked, shared_);
+}
+
+#ifdef HOLOFLOW_QUEUE_TELEMETRY
+void BatchedSPSCQueue::record_write(size_t write_idx, size_t nb_batches) {
+  uint64_t batches = writer_counters_.batches.load(std::memory_order_relaxed);
+  writer_counters_.batches.store(batches + nb_batches,
+                                 std::memory_order_relaxed);
+
+  // Only look at the reader's index once per sample period, so that the
+  // producer does not pull its cache line on every commit.
+  if (batches / QUEUE_OCCUPANCY_SAMPLE_PERIOD ==
+      (batches + nb_batches) / QUEUE_OCCUPANCY_SAMPLE_PERIOD)
+    return;
+
+  size_t occupancy =
+      distance(write_idx, control_->read_idx.load(std::memory_order_relaxed));
+  size_t bucket = std::min(occupancy * QUEUE_OCCUPANCY_BUCKETS / nb_slots_,
+                           QUEUE_OCCUPANCY_BUCKETS - 1);
+  bump<uint64_t>(occupancy_.histogram[bucket], 1);
+  raise(occupancy_.high_water_mark, occupancy);
+}
+#endif
+
+size_t BatchedSPSCQueue::control_size() {
+  size_t page_size = QueueBuffer::page_size();
+  return (sizeof(ControlBlock) + page_size - 1) / page_size * page_size;
 }
 
-size_t BatchedSPSCQueue::reader_size() {
-  size_t write_idx = write_idx_.load(std::memory_order_acquire);
-  size_t read_idx = read_idx_.load(std::memory_order_relaxed);
+void BatchedSPSCQueue::check_geometry(size_t nb_slots,
+                                      size_t enqueue_batch_size,
+                                      size_t dequeue_batch_size,
+                                      bool mirrored) {
+  if (enqueue_batch_size == 0 || enqueue_batch_size >= nb_slots ||
+      dequeue_batch_size == 0 || dequeue_batch_size >= nb_slots)
+    throw std::invalid_argument(
+        "Batch sizes must be non-zero and lower than the number of slots");
 
+  if (!mirrored && (nb_slots % enqueue_batch_size != 0 ||
+                    nb_slots % dequeue_batch_size != 0))
+    throw std::invalid_argument(
+        "nb_slots must be a multiple of both batch sizes");
+
+  // The writer stops once fewer than `enqueue_batch_size + 1` slots are free.
+  // If the reader still needs more elements than that for a batch, both sides
+  // wait for each other forever. Divisors of `nb_slots` never add up to more.
+  if (mirrored && enqueue_batch_size + dequeue_batch_size > nb_slots)
+    throw std::invalid_argument(
+        "Batch sizes of a mirrored queue must add up to at most nb_slots");
+}
+
+void BatchedSPSCQueue::check_batch_size(
+    size_t batch_size, size_t other_batch_size,
+    size_t other_pending_batch_size) const {
+  if (batch_size == 0 || batch_size >= nb_slots_)
+    throw std::invalid_argument(
+        "Batch size must be non-zero and lower than the number of slots");
+
+  if (batch_size > PENDING_MASK)
+    throw std::invalid_argument("Requested batch size must fit in 32 bits");
+
+  if (!mirrored_ && nb_slots_ % batch_size != 0)
+    throw std::invalid_argument(
+        "nb_slots must be a multiple of the batch size");
+
+  // See check_geometry(). The other side may be about to switch to its
+  // pending size, so the new one has to fit with both.
+  size_t other = std::max(other_batch_size, other_pending_batch_size);
+  if (mirrored_ && batch_size + other > nb_slots_)
+    throw std::invalid_argument(
+        "Batch sizes of a mirrored queue must add up to at most nb_slots");
+}
+
+void BatchedSPSCQueue::request_batch_size(
+    size_t batch_size, unsigned shift,
+    const std::atomic<size_t> &other_batch_size) {
+  unsigned other_shift = DEQUEUE_SHIFT - shift;
+  uint64_t pending =
+      control_->pending_batch_sizes.load(std::memory_order_acquire);
+  uint64_t requested;
+
+  // A request of the other side, or its switch to one, changes the word, so
+  // the swap fails unless the check saw the sizes the new one has to fit.
+  // The other side stores its new batch size before clearing its request,
+  // hence the load after the word.
+  do {
+    check_batch_size(batch_size,
+                     other_batch_size.load(std::memory_order_acquire),
+                     pending_batch_size(pending, other_shift));
+    requested = (pending & ~(PENDING_MASK << shift)) |
+                (static_cast<uint64_t>(batch_size) << shift);
+  } while (!control_->pending_batch_sizes.compare_exchange_weak(
+      pending, requested, std::memory_order_acq_rel,
+      std::memory_order_acquire));
+}
+
+bool BatchedSPSCQueue::apply_batch_size(unsigned shift, size_t &batch_size,
+                                        std::atomic<size_t> &shared_batch_size,
+                                        size_t idx) {
+  // Without a mirror, batches must not straddle the wrap point, so the index
+  // has to be a multiple of the new size. Since `nb_slots_` is one, this
+  // happens at the latest on the wrap point.
+  uint64_t pending =
+      control_->pending_batch_sizes.load(std::memory_order_acquire);
+  size_t requested = pending_batch_size(pending, shift);
+  if (requested == 0 || (!mirrored_ && idx % requested != 0))
+    return false;
+
+  batch_size = requested;
+  shared_batch_size.store(requested, std::memory_order_relaxed);
+
+  // Clear only this side's request, and keep one made in the meantime for
+  // the next commit. The release publishes the new size to the requests
+  // that see the cleared word.
+  while (pending_batch_size(pending, shift) == requested &&
+         !control_->pending_batch_sizes.compare_exchange_weak(
+             pending, pending & ~(PENDING_MASK << shift),
+             std::memory_order_release, std::memory_order_relaxed)) {
+  }
+  return true;
+}
+
+size_t BatchedSPSCQueue::distance(size_t write_idx, size_t read_idx) const {
   size_t diff = write_idx - read_idx;
 
   if (write_idx < read_idx)
@@ -91,4 +710,14 @@ size_t BatchedSPSCQueue::reader_size() {
 
   return diff;
 }
+
+size_t BatchedSPSCQueue::advance(size_t idx, size_t nb_elements) const {
+  // Without a mirror, batches end exactly on the wrap point. With a mirror,
+  // they may go past it.
+  size_t next_idx = idx + nb_elements;
+  if (next_idx >= nb_slots_)
+    next_idx -= nb_slots_;
+
+  return next_idx;
+}
 } // namespace holoflow
@@ -0,0 +1,297 @@
+#include "batched_spsc_queue/queue_buffer.hh"
+
+#include <cerrno>
+#include <climits>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace holoflow {
+namespace {
+/// Throws the `std::system_error` matching `errno`.
+[[noreturn]] void throw_errno(const char *what) {
+  throw std::system_error(errno, std::generic_category(), what);
+}
+
+/// Closes a file descriptor when going out of scope.
+struct FdGuard {
+  int fd;
+  ~FdGuard() { close(fd); }
+};
+
+/// Rounds `size` up to a multiple of `alignment`.
+size_t round_up(size_t size, size_t alignment) {
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+/// Maps `size` bytes of anonymous memory aligned on `alignment` bytes, by
+/// over-reserving and trimming the unaligned ends. Returns `nullptr` on
+/// failure.
+uint8_t *map_aligned(size_t size, size_t alignment) {
+  size_t reserved_size = size + alignment;
+  void *reserved = mmap(nullptr, reserved_size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (reserved == MAP_FAILED)
+    return nullptr;
+
+  auto begin = reinterpret_cast<uintptr_t>(reserved);
+  auto aligned = round_up(begin, alignment);
+  if (aligned > begin)
+    munmap(reserved, aligned - begin);
+  size_t tail = begin + reserved_size - (aligned + size);
+  if (tail > 0)
+    munmap(reinterpret_cast<void *>(aligned + size), tail);
+
+  return reinterpret_cast<uint8_t *>(aligned);
+}
+
+/// Binds `[data, data + size)` to `node`. Returns whether it succeeded.
+bool bind_to_node(uint8_t *data, size_t size, int node) {
+  constexpr size_t bits = sizeof(unsigned long) * CHAR_BIT;
+  size_t index = static_cast<size_t>(node);
+
+  // The kernel ignores the last bit of the mask, keep one spare word.
+  std::vector<unsigned long> mask(index / bits + 2, 0);
+  mask[index / bits] |= 1UL << (index % bits);
+
+  return syscall(SYS_mbind, data, size, MPOL_BIND, mask.data(),
+                 mask.size() * bits, MPOL_MF_STRICT | MPOL_MF_MOVE) == 0;
+}
+
+/// Faults every page of `[data, data + size)` in.
+void prefault(uint8_t *data, size_t size, size_t page_size) {
+#ifdef MADV_POPULATE_WRITE
+  if (madvise(data, size, MADV_POPULATE_WRITE) == 0)
+    return;
+#endif
+  for (size_t offset = 0; offset < size; offset += page_size)
+    reinterpret_cast<volatile uint8_t *>(data)[offset] = 0;
+}
+} // namespace
+
+QueueBuffer QueueBuffer::mirrored(size_t size) {
+  if (size == 0 || size % page_size() != 0)
+    throw std::invalid_argument(
+        "Mirrored buffer size must be a non-zero multiple of the page size");
+
+  int fd = memfd_create("holoflow-queue", MFD_CLOEXEC);
+  if (fd < 0)
+    throw_errno("memfd_create");
+  FdGuard guard{fd};
+
+  if (ftruncate(fd, static_cast<off_t>(size)) != 0)
+    throw_errno("ftruncate");
+
+  // Reserve twice the size, then map the file over each half.
+  void *reserved =
+      mmap(nullptr, 2 * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (reserved == MAP_FAILED)
+    throw_errno("mmap");
+
+  QueueBuffer buffer;
+  buffer.data_ = static_cast<uint8_t *>(reserved);
+  buffer.size_ = size;
+  buffer.mapping_size_ = 2 * size;
+  buffer.mirrored_ = true;
+  buffer.backing_ = BufferBacking::Pages;
+
+  for (uint8_t *half : {buffer.data_, buffer.data_ + size}) {
+    if (mmap(half, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd,
+             0) == MAP_FAILED)
+      throw_errno("mmap");
+  }
+
+  return buffer;
+}
+
+QueueBuffer QueueBuffer::allocate(size_t size, const BufferOptions &options) {
+  if (size == 0)
+    throw std::invalid_argument("Buffer size must not be zero");
+
+  QueueBuffer buffer;
+  buffer.size_ = size;
+
+  if (options.huge_pages == HugePages::Explicit) {
+    size_t mapping_size = round_up(size, huge_page_size());
+    void *data = mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (data != MAP_FAILED) {
+      buffer.data_ = static_cast<uint8_t *>(data);
+      buffer.mapping_size_ = mapping_size;
+      buffer.backing_ = BufferBacking::HugeTLB;
+    }
+  }
+
+  if (!buffer.data_ && options.huge_pages != HugePages::None) {
+    // Transparent huge pages only back huge-page-aligned ranges.
+    size_t mapping_size = round_up(size, huge_page_size());
+    buffer.data_ = map_aligned(mapping_size, huge_page_size());
+    if (buffer.data_) {
+      buffer.mapping_size_ = mapping_size;
+      buffer.backing_ =
+          madvise(buffer.data_, mapping_size, MADV_HUGEPAGE) == 0
+              ? BufferBacking::TransparentHugePages
+              : BufferBacking::Pages;
+    }
+  }
+
+  if (!buffer.data_) {
+    size_t mapping_size = round_up(size, page_size());
+    void *data = mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (data == MAP_FAILED)
+      throw_errno("mmap");
+    buffer.data_ = static_cast<uint8_t *>(data);
+    buffer.mapping_size_ = mapping_size;
+    buffer.backing_ = BufferBacking::Pages;
+  }
+
+  // Bind before faulting in, otherwise the pages are already placed.
+  if (options.numa_node >= 0 &&
+      bind_to_node(buffer.data_, buffer.mapping_size_, options.numa_node))
+    buffer.numa_node_ = options.numa_node;
+
+  if (options.prefault) {
+    prefault(buffer.data_, buffer.mapping_size_, page_size());
+    buffer.prefaulted_ = true;
+  }
+
+  return buffer;
+}
+
+QueueBuffer QueueBuffer::create_shared(const std::string &name, size_t size) {
+  if (size == 0)
+    throw std::invalid_argument("Buffer size must not be zero");
+
+  int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd < 0)
+    throw_errno("shm_open");
+  FdGuard guard{fd};
+
+  // From here on, the buffer owns the name and removes it on failure.
+  QueueBuffer buffer;
+  buffer.shm_name_ = name;
+
+  size_t mapping_size = round_up(size, page_size());
+  if (ftruncate(fd, static_cast<off_t>(mapping_size)) != 0)
+    throw_errno("ftruncate");
+
+  void *data = mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                    fd, 0);
+  if (data == MAP_FAILED)
+    throw_errno("mmap");
+
+  buffer.data_ = static_cast<uint8_t *>(data);
+  buffer.size_ = size;
+  buffer.mapping_size_ = mapping_size;
+  buffer.backing_ = BufferBacking::Pages;
+  buffer.shared_ = true;
+  return buffer;
+}
+
+QueueBuffer QueueBuffer::open_shared(const std::string &name) {
+  int fd = shm_open(name.c_str(), O_RDWR, 0);
+  if (fd < 0)
+    throw_errno("shm_open");
+  FdGuard guard{fd};
+
+  struct stat st;
+  if (fstat(fd, &st) != 0)
+    throw_errno("fstat");
+  auto size = static_cast<size_t>(st.st_size);
+  if (size == 0)
+    throw std::invalid_argument("Shared memory segment is empty");
+
+  void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED)
+    throw_errno("mmap");
+
+  QueueBuffer buffer;
+  buffer.data_ = static_cast<uint8_t *>(data);
+  buffer.size_ = size;
+  buffer.mapping_size_ = size;
+  buffer.backing_ = BufferBacking::Pages;
+  buffer.shared_ = true;
+  return buffer;
+}
+
+size_t QueueBuffer::page_size() {
+  static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  return size;
+}
+
+size_t QueueBuffer::huge_page_size() {
+  static const size_t size = []() -> size_t {
+    std::ifstream meminfo("/proc/meminfo");
+    std::string key;
+    size_t value;
+    while (meminfo >> key >> value) {
+      if (key == "Hugepagesize:")
+        return value * 1024;
+      meminfo.ignore(INT_MAX, '\n');
+    }
+    return 2 * 1024 * 1024;
+  }();
+  return size;
+}
+
+QueueBuffer::QueueBuffer()
+    : data_(nullptr), size_(0), mapping_size_(0), mirrored_(false),
+      backing_(BufferBacking::None), numa_node_(-1), prefaulted_(false),
+      shared_(false) {}
+
+QueueBuffer::QueueBuffer(QueueBuffer &&other) noexcept : QueueBuffer() {
+  *this = std::move(other);
+}
+
+QueueBuffer &QueueBuffer::operator=(QueueBuffer &&other) noexcept {
+  if (this != &other) {
+    release();
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+    mapping_size_ = std::exchange(other.mapping_size_, 0);
+    mirrored_ = std::exchange(other.mirrored_, false);
+    backing_ = std::exchange(other.backing_, BufferBacking::None);
+    numa_node_ = std::exchange(other.numa_node_, -1);
+    prefaulted_ = std::exchange(other.prefaulted_, false);
+    shared_ = std::exchange(other.shared_, false);
+    shm_name_ = std::exchange(other.shm_name_, std::string());
+  }
+  return *this;
+}
+
+QueueBuffer::~QueueBuffer() { release(); }
+
+uint8_t *QueueBuffer::data() const { return data_; }
+
+size_t QueueBuffer::size() const { return size_; }
+
+bool QueueBuffer::is_mirrored() const { return mirrored_; }
+
+BufferBacking QueueBuffer::backing() const { return backing_; }
+
+int QueueBuffer::numa_node() const { return numa_node_; }
+
+bool QueueBuffer::is_prefaulted() const { return prefaulted_; }
+
+bool QueueBuffer::is_shared() const { return shared_; }
+
+void QueueBuffer::release() {
+  if (data_)
+    munmap(data_, mapping_size_);
+  if (!shm_name_.empty())
+    shm_unlink(shm_name_.c_str());
+  data_ = nullptr;
+  shm_name_.clear();
+}
+} // namespace holoflow
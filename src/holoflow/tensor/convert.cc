@@ -0,0 +1,506 @@
+#include "holoflow/tensor/convert.hh"
+#include "holoflow/tensor/elementwise.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HOLOFLOW_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace holoflow {
+namespace {
+
+/// The number of elements of a strided inner run that are gathered into a
+/// dense block, converted, and scattered back at once.
+constexpr std::size_t BLOCK_SIZE = 256;
+
+/// The type a conversion computes in: its floating-point side.
+template <typename S, typename D>
+using Real = std::conditional_t<std::is_floating_point_v<S>, S, D>;
+
+/// The lowest value of the integer type `D`, in the floating-point type `R`.
+template <typename D, typename R>
+constexpr R LOWEST = static_cast<R>(std::numeric_limits<D>::lowest());
+
+/// The highest value of the integer type `D`, in the floating-point type `R`.
+template <typename D, typename R>
+constexpr R HIGHEST = static_cast<R>(std::numeric_limits<D>::max());
+
+/**
+ * @brief Converts `n` contiguous elements one by one. This is the reference
+ * of the vectorized kernels, which convert their tail with it.
+ *
+ * @param fused Whether to fuse the multiply-add, as the FMA kernels do.
+ */
+template <typename S, typename D>
+void convert_scalar(const S *src, D *dst, std::size_t n, Real<S, D> scale,
+                    Real<S, D> offset, bool fused) {
+  using R = Real<S, D>;
+  for (std::size_t i = 0; i < n; ++i) {
+    R value = fused ? std::fma(static_cast<R>(src[i]), scale, offset)
+                    : static_cast<R>(src[i]) * scale + offset;
+    if constexpr (std::is_floating_point_v<D>) {
+      dst[i] = value;
+    } else {
+      // Written so that NaN gives the lowest value, as `max` does in SIMD.
+      value = value >= LOWEST<D, R> ? value : LOWEST<D, R>;
+      value = value <= HIGHEST<D, R> ? value : HIGHEST<D, R>;
+      dst[i] = static_cast<D>(std::nearbyint(value));
+    }
+  }
+}
+
+#if defined(HOLOFLOW_X86_KERNELS)
+
+// SSE4.1: 4 elements at a time.
+
+/// Loads 4 integers and widens them to 32 bits.
+template <typename S>
+[[gnu::target("sse4.1")]] inline __m128i load4_sse4(const S *src) {
+  if constexpr (std::is_same_v<S, uint8_t>) {
+    int32_t bytes;
+    std::memcpy(&bytes, src, sizeof(bytes));
+    return _mm_cvtepu8_epi32(_mm_cvtsi32_si128(bytes));
+  } else {
+    __m128i words = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(src));
+    if constexpr (std::is_same_v<S, uint16_t>)
+      return _mm_cvtepu16_epi32(words);
+    else
+      return _mm_cvtepi16_epi32(words);
+  }
+}
+
+/// Narrows 4 32-bit integers, already in the range of `D`, and stores them.
+template <typename D>
+[[gnu::target("sse4.1")]] inline void store4_sse4(__m128i values, D *dst) {
+  if constexpr (std::is_same_v<D, uint8_t>) {
+    __m128i words = _mm_packus_epi32(values, values);
+    int32_t bytes = _mm_cvtsi128_si32(_mm_packus_epi16(words, words));
+    std::memcpy(dst, &bytes, sizeof(bytes));
+  } else if constexpr (std::is_same_v<D, uint16_t>) {
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(dst),
+                     _mm_packus_epi32(values, values));
+  } else {
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(dst),
+                     _mm_packs_epi32(values, values));
+  }
+}
+
+template <typename S, typename D>
+[[gnu::target("sse4.1")]] void widen_sse4(const S *src, D *dst, std::size_t n,
+                                          D scale, D offset) {
+  std::size_t i = 0;
+  if constexpr (std::is_same_v<D, float>) {
+    const __m128 s = _mm_set1_ps(scale);
+    const __m128 o = _mm_set1_ps(offset);
+    for (; i + 4 <= n; i += 4) {
+      __m128 values = _mm_cvtepi32_ps(load4_sse4(src + i));
+      _mm_storeu_ps(dst + i, _mm_add_ps(_mm_mul_ps(values, s), o));
+    }
+  } else {
+    const __m128d s = _mm_set1_pd(scale);
+    const __m128d o = _mm_set1_pd(offset);
+    for (; i + 4 <= n; i += 4) {
+      __m128i values = load4_sse4(src + i);
+      __m128d low = _mm_cvtepi32_pd(values);
+      __m128d high = _mm_cvtepi32_pd(_mm_unpackhi_epi64(values, values));
+      _mm_storeu_pd(dst + i, _mm_add_pd(_mm_mul_pd(low, s), o));
+      _mm_storeu_pd(dst + i + 2, _mm_add_pd(_mm_mul_pd(high, s), o));
+    }
+  }
+  convert_scalar(src + i, dst + i, n - i, scale, offset, false);
+}
+
+template <typename S, typename D>
+[[gnu::target("sse4.1")]] void narrow_sse4(const S *src, D *dst, std::size_t n,
+                                           S scale, S offset) {
+  std::size_t i = 0;
+  if constexpr (std::is_same_v<S, float>) {
+    const __m128 s = _mm_set1_ps(scale);
+    const __m128 o = _mm_set1_ps(offset);
+    const __m128 lowest = _mm_set1_ps(LOWEST<D, float>);
+    const __m128 highest = _mm_set1_ps(HIGHEST<D, float>);
+    for (; i + 4 <= n; i += 4) {
+      __m128 values = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(src + i), s), o);
+      values = _mm_min_ps(_mm_max_ps(values, lowest), highest);
+      store4_sse4(_mm_cvtps_epi32(values), dst + i);
+    }
+  } else {
+    const __m128d s = _mm_set1_pd(scale);
+    const __m128d o = _mm_set1_pd(offset);
+    const __m128d lowest = _mm_set1_pd(LOWEST<D, double>);
+    const __m128d highest = _mm_set1_pd(HIGHEST<D, double>);
+    for (; i + 4 <= n; i += 4) {
+      __m128d low = _mm_add_pd(_mm_mul_pd(_mm_loadu_pd(src + i), s), o);
+      __m128d high = _mm_add_pd(_mm_mul_pd(_mm_loadu_pd(src + i + 2), s), o);
+      low = _mm_min_pd(_mm_max_pd(low, lowest), highest);
+      high = _mm_min_pd(_mm_max_pd(high, lowest), highest);
+      store4_sse4(
+          _mm_unpacklo_epi64(_mm_cvtpd_epi32(low), _mm_cvtpd_epi32(high)),
+          dst + i);
+    }
+  }
+  convert_scalar(src + i, dst + i, n - i, scale, offset, false);
+}
+
+// AVX2 and FMA: 8 elements at a time.
+
+/// Loads 8 integers and widens them to 32 bits.
+template <typename S>
+[[gnu::target("avx2,fma")]] inline __m256i load8_avx2(const S *src) {
+  if constexpr (std::is_same_v<S, uint8_t>) {
+    return _mm256_cvtepu8_epi32(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i *>(src)));
+  } else {
+    __m128i words = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+    if constexpr (std::is_same_v<S, uint16_t>)
+      return _mm256_cvtepu16_epi32(words);
+    else
+      return _mm256_cvtepi16_epi32(words);
+  }
+}
+
+/// Narrows 8 32-bit integers, already in the range of `D`, and stores them.
+template <typename D>
+[[gnu::target("avx2,fma")]] inline void store8_avx2(__m256i values, D *dst) {
+  // The packing instructions of AVX2 work within 128-bit lanes, so the two
+  // halves are packed with SSE instead.
+  __m128i low = _mm256_castsi256_si128(values);
+  __m128i high = _mm256_extracti128_si256(values, 1);
+  if constexpr (std::is_same_v<D, uint8_t>) {
+    __m128i words = _mm_packus_epi32(low, high);
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(dst),
+                     _mm_packus_epi16(words, words));
+  } else if constexpr (std::is_same_v<D, uint16_t>) {
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst),
+                     _mm_packus_epi32(low, high));
+  } else {
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst),
+                     _mm_packs_epi32(low, high));
+  }
+}
+
+template <typename S, typename D>
+[[gnu::target("avx2,fma")]] void widen_avx2(const S *src, D *dst, std::size_t n,
+                                            D scale, D offset) {
+  std::size_t i = 0;
+  if constexpr (std::is_same_v<D, float>) {
+    const __m256 s = _mm256_set1_ps(scale);
+    const __m256 o = _mm256_set1_ps(offset);
+    for (; i + 8 <= n; i += 8) {
+      __m256 values = _mm256_cvtepi32_ps(load8_avx2(src + i));
+      _mm256_storeu_ps(dst + i, _mm256_fmadd_ps(values, s, o));
+    }
+  } else {
+    const __m256d s = _mm256_set1_pd(scale);
+    const __m256d o = _mm256_set1_pd(offset);
+    for (; i + 8 <= n; i += 8) {
+      __m256i values = load8_avx2(src + i);
+      __m256d low = _mm256_cvtepi32_pd(_mm256_castsi256_si128(values));
+      __m256d high = _mm256_cvtepi32_pd(_mm256_extracti128_si256(values, 1));
+      _mm256_storeu_pd(dst + i, _mm256_fmadd_pd(low, s, o));
+      _mm256_storeu_pd(dst + i + 4, _mm256_fmadd_pd(high, s, o));
+    }
+  }
+  convert_scalar(src + i, dst + i, n - i, scale, offset, true);
+}
+
+template <typename S, typename D>
+[[gnu::target("avx2,fma")]] void narrow_avx2(const S *src, D *dst,
+                                             std::size_t n, S scale,
+                                             S offset) {
+  std::size_t i = 0;
+  if constexpr (std::is_same_v<S, float>) {
+    const __m256 s = _mm256_set1_ps(scale);
+    const __m256 o = _mm256_set1_ps(offset);
+    const __m256 lowest = _mm256_set1_ps(LOWEST<D, float>);
+    const __m256 highest = _mm256_set1_ps(HIGHEST<D, float>);
+    for (; i + 8 <= n; i += 8) {
+      __m256 values = _mm256_fmadd_ps(_mm256_loadu_ps(src + i), s, o);
+      values = _mm256_min_ps(_mm256_max_ps(values, lowest), highest);
+      store8_avx2(_mm256_cvtps_epi32(values), dst + i);
+    }
+  } else {
+    const __m256d s = _mm256_set1_pd(scale);
+    const __m256d o = _mm256_set1_pd(offset);
+    const __m256d lowest = _mm256_set1_pd(LOWEST<D, double>);
+    const __m256d highest = _mm256_set1_pd(HIGHEST<D, double>);
+    for (; i + 8 <= n; i += 8) {
+      __m256d low = _mm256_fmadd_pd(_mm256_loadu_pd(src + i), s, o);
+      __m256d high = _mm256_fmadd_pd(_mm256_loadu_pd(src + i + 4), s, o);
+      low = _mm256_min_pd(_mm256_max_pd(low, lowest), highest);
+      high = _mm256_min_pd(_mm256_max_pd(high, lowest), highest);
+      store8_avx2(_mm256_set_m128i(_mm256_cvtpd_epi32(high),
+                                   _mm256_cvtpd_epi32(low)),
+                  dst + i);
+    }
+  }
+  convert_scalar(src + i, dst + i, n - i, scale, offset, true);
+}
+
+// AVX-512F: 16 elements at a time.
+
+// GCC warns about the undefined vectors that the AVX-512 intrinsics pass as
+// masked-off sources.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+/// Loads 16 integers and widens them to 32 bits.
+template <typename S>
+[[gnu::target("avx512f,avx2,fma")]] inline __m512i
+load16_avx512(const S *src) {
+  if constexpr (std::is_same_v<S, uint8_t>) {
+    return _mm512_cvtepu8_epi32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(src)));
+  } else {
+    __m256i words =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src));
+    if constexpr (std::is_same_v<S, uint16_t>)
+      return _mm512_cvtepu16_epi32(words);
+    else
+      return _mm512_cvtepi16_epi32(words);
+  }
+}
+
+/// Narrows 16 32-bit integers, already in the range of `D`, and stores them.
+template <typename D>
+[[gnu::target("avx512f,avx2,fma")]] inline void store16_avx512(__m512i values,
+                                                               D *dst) {
+  if constexpr (std::is_same_v<D, uint8_t>)
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst),
+                     _mm512_cvtepi32_epi8(values));
+  else
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst),
+                        _mm512_cvtepi32_epi16(values));
+}
+
+template <typename S, typename D>
+[[gnu::target("avx512f,avx2,fma")]] void
+widen_avx512(const S *src, D *dst, std::size_t n, D scale, D offset) {
+  std::size_t i = 0;
+  if constexpr (std::is_same_v<D, float>) {
+    const __m512 s = _mm512_set1_ps(scale);
+    const __m512 o = _mm512_set1_ps(offset);
+    for (; i + 16 <= n; i += 16) {
+      __m512 values = _mm512_cvtepi32_ps(load16_avx512(src + i));
+      _mm512_storeu_ps(dst + i, _mm512_fmadd_ps(values, s, o));
+    }
+  } else {
+    const __m512d s = _mm512_set1_pd(scale);
+    const __m512d o = _mm512_set1_pd(offset);
+    for (; i + 16 <= n; i += 16) {
+      __m512i values = load16_avx512(src + i);
+      __m512d low = _mm512_cvtepi32_pd(_mm512_castsi512_si256(values));
+      __m512d high =
+          _mm512_cvtepi32_pd(_mm512_extracti64x4_epi64(values, 1));
+      _mm512_storeu_pd(dst + i, _mm512_fmadd_pd(low, s, o));
+      _mm512_storeu_pd(dst + i + 8, _mm512_fmadd_pd(high, s, o));
+    }
+  }
+  convert_scalar(src + i, dst + i, n - i, scale, offset, true);
+}
+
+template <typename S, typename D>
+[[gnu::target("avx512f,avx2,fma")]] void
+narrow_avx512(const S *src, D *dst, std::size_t n, S scale, S offset) {
+  std::size_t i = 0;
+  if constexpr (std::is_same_v<S, float>) {
+    const __m512 s = _mm512_set1_ps(scale);
+    const __m512 o = _mm512_set1_ps(offset);
+    const __m512 lowest = _mm512_set1_ps(LOWEST<D, float>);
+    const __m512 highest = _mm512_set1_ps(HIGHEST<D, float>);
+    for (; i + 16 <= n; i += 16) {
+      __m512 values = _mm512_fmadd_ps(_mm512_loadu_ps(src + i), s, o);
+      values = _mm512_min_ps(_mm512_max_ps(values, lowest), highest);
+      store16_avx512(_mm512_cvtps_epi32(values), dst + i);
+    }
+  } else {
+    const __m512d s = _mm512_set1_pd(scale);
+    const __m512d o = _mm512_set1_pd(offset);
+    const __m512d lowest = _mm512_set1_pd(LOWEST<D, double>);
+    const __m512d highest = _mm512_set1_pd(HIGHEST<D, double>);
+    for (; i + 16 <= n; i += 16) {
+      __m512d low = _mm512_fmadd_pd(_mm512_loadu_pd(src + i), s, o);
+      __m512d high = _mm512_fmadd_pd(_mm512_loadu_pd(src + i + 8), s, o);
+      low = _mm512_min_pd(_mm512_max_pd(low, lowest), highest);
+      high = _mm512_min_pd(_mm512_max_pd(high, lowest), highest);
+      __m512i values = _mm512_inserti64x4(
+          _mm512_castsi256_si512(_mm512_cvtpd_epi32(low)),
+          _mm512_cvtpd_epi32(high), 1);
+      store16_avx512(values, dst + i);
+    }
+  }
+  convert_scalar(src + i, dst + i, n - i, scale, offset, true);
+}
+
+#pragma GCC diagnostic pop
+#endif
+
+/// Converts `n` contiguous elements, from and to untyped buffers.
+using ConvertKernel = void (*)(const std::byte *src, std::byte *dst,
+                               std::size_t n, double scale, double offset);
+
+template <typename S, typename D, SimdLevel Level>
+void convert_run(const std::byte *src, std::byte *dst, std::size_t n,
+                 double scale, double offset) {
+  using R = Real<S, D>;
+  const S *in = reinterpret_cast<const S *>(src);
+  D *out = reinterpret_cast<D *>(dst);
+  const R s = static_cast<R>(scale);
+  const R o = static_cast<R>(offset);
+  constexpr bool widen = std::is_floating_point_v<D>;
+
+#if defined(HOLOFLOW_X86_KERNELS)
+  if constexpr (Level == SimdLevel::AVX512) {
+    if constexpr (widen)
+      return widen_avx512(in, out, n, s, o);
+    else
+      return narrow_avx512(in, out, n, s, o);
+  } else if constexpr (Level == SimdLevel::AVX2) {
+    if constexpr (widen)
+      return widen_avx2(in, out, n, s, o);
+    else
+      return narrow_avx2(in, out, n, s, o);
+  } else if constexpr (Level == SimdLevel::SSE4) {
+    if constexpr (widen)
+      return widen_sse4(in, out, n, s, o);
+    else
+      return narrow_sse4(in, out, n, s, o);
+  }
+#endif
+  convert_scalar(in, out, n, s, o, false);
+}
+
+template <typename S, typename D>
+ConvertKernel select_kernel(SimdLevel level) {
+  switch (level) {
+  case SimdLevel::Scalar:
+    return &convert_run<S, D, SimdLevel::Scalar>;
+  case SimdLevel::SSE4:
+    return &convert_run<S, D, SimdLevel::SSE4>;
+  case SimdLevel::AVX2:
+    return &convert_run<S, D, SimdLevel::AVX2>;
+  case SimdLevel::AVX512:
+    return &convert_run<S, D, SimdLevel::AVX512>;
+  }
+  return nullptr;
+}
+
+template <typename S> ConvertKernel select_kernel(DType dst, SimdLevel level) {
+  if constexpr (std::is_floating_point_v<S>) {
+    switch (dst) {
+    case DType::U8:
+      return select_kernel<S, uint8_t>(level);
+    case DType::U16:
+      return select_kernel<S, uint16_t>(level);
+    case DType::I16:
+      return select_kernel<S, int16_t>(level);
+    default:
+      return nullptr;
+    }
+  } else {
+    switch (dst) {
+    case DType::F32:
+      return select_kernel<S, float>(level);
+    case DType::F64:
+      return select_kernel<S, double>(level);
+    default:
+      return nullptr;
+    }
+  }
+}
+
+/// Returns the kernel of a conversion, or `nullptr` if it is not supported.
+ConvertKernel select_kernel(DType src, DType dst, SimdLevel level) {
+  switch (src) {
+  case DType::U8:
+    return select_kernel<uint8_t>(dst, level);
+  case DType::U16:
+    return select_kernel<uint16_t>(dst, level);
+  case DType::I16:
+    return select_kernel<int16_t>(dst, level);
+  case DType::F32:
+    return select_kernel<float>(dst, level);
+  case DType::F64:
+    return select_kernel<double>(dst, level);
+  default:
+    return nullptr;
+  }
+}
+} // namespace
+
+void convert(const Tensor &src, const Tensor &dst,
+             const ConvertOptions &options) {
+  const TensorDescriptor &src_desc = src.desc();
+  const TensorDescriptor &dst_desc = dst.desc();
+  CHECK(src_desc.shape() == dst_desc.shape())
+      << ": Cannot convert between different shapes!";
+  ConvertKernel kernel = select_kernel(src_desc.dtype(), dst_desc.dtype(),
+                                       simd_level(options.max_simd_level));
+  CHECK(kernel != nullptr) << ": Cannot convert from " << src_desc.dtype()
+                           << " to " << dst_desc.dtype() << "!";
+
+  if (src_desc.nb_elements() == 0)
+    return;
+
+  const std::byte *in = src.raw_data();
+  std::byte *out = dst.raw_data();
+  const double scale = options.scale;
+  const double offset = options.offset;
+  ElementwiseLayout layout(src_desc, dst_desc);
+  if (layout.rank == 0) {
+    kernel(in, out, 1, scale, offset);
+    return;
+  }
+
+  const std::size_t inner = layout.rank - 1;
+  const std::size_t count = layout.shape[inner];
+  const std::size_t src_size = src_desc.type_size();
+  const std::size_t dst_size = dst_desc.type_size();
+  const std::size_t src_stride = layout.src_strides[inner];
+  const std::size_t dst_stride = layout.dst_strides[inner];
+  if (src_stride == src_size && dst_stride == dst_size) {
+    layout.for_each_outer(
+        inner, MAX_TENSOR_RANK,
+        [&](std::size_t src_offset, std::size_t dst_offset) {
+          kernel(in + src_offset, out + dst_offset, count, scale, offset);
+        });
+    return;
+  }
+
+  // A strided side goes through a dense block, so that the kernels still only
+  // see contiguous elements.
+  alignas(64) std::byte src_block[BLOCK_SIZE * sizeof(double)];
+  alignas(64) std::byte dst_block[BLOCK_SIZE * sizeof(double)];
+  layout.for_each_outer(
+      inner, MAX_TENSOR_RANK,
+      [&](std::size_t src_offset, std::size_t dst_offset) {
+        for (std::size_t begin = 0; begin < count; begin += BLOCK_SIZE) {
+          const std::size_t size = std::min(BLOCK_SIZE, count - begin);
+          const std::byte *src_run = in + src_offset + begin * src_stride;
+          std::byte *dst_run = out + dst_offset + begin * dst_stride;
+
+          if (src_stride != src_size) {
+            for (std::size_t i = 0; i < size; ++i)
+              std::memcpy(src_block + i * src_size, src_run + i * src_stride,
+                          src_size);
+            src_run = src_block;
+          }
+          kernel(src_run, dst_stride == dst_size ? dst_run : dst_block, size,
+                 scale, offset);
+          if (dst_stride != dst_size) {
+            for (std::size_t i = 0; i < size; ++i)
+              std::memcpy(dst_run + i * dst_stride, dst_block + i * dst_size,
+                          dst_size);
+          }
+        }
+      });
+}
+
+} // namespace holoflow
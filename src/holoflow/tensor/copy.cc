@@ -0,0 +1,173 @@
+#include "holoflow/tensor/copy.hh"
+#include "holoflow/tensor/elementwise.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace holoflow {
+namespace {
+
+/// The side, in elements, of the tiles of a transposing copy. A tile of the
+/// source and one of the destination fit in the L1 cache for every type.
+constexpr std::size_t TILE_SIZE = 32;
+
+/// Copies `size` bytes with non-temporal stores.
+void stream_copy(std::byte *dst, const std::byte *src, std::size_t size) {
+#if defined(__SSE2__)
+  // Align the destination on 16 bytes, as the streaming stores require.
+  std::size_t head = (16 - reinterpret_cast<uintptr_t>(dst) % 16) % 16;
+  head = std::min(head, size);
+  std::memcpy(dst, src, head);
+  dst += head;
+  src += head;
+  size -= head;
+
+  for (; size >= 64; size -= 64, dst += 64, src += 64) {
+    auto *out = reinterpret_cast<__m128i *>(dst);
+    auto *in = reinterpret_cast<const __m128i *>(src);
+    __m128i a = _mm_loadu_si128(in);
+    __m128i b = _mm_loadu_si128(in + 1);
+    __m128i c = _mm_loadu_si128(in + 2);
+    __m128i d = _mm_loadu_si128(in + 3);
+    _mm_stream_si128(out, a);
+    _mm_stream_si128(out + 1, b);
+    _mm_stream_si128(out + 2, c);
+    _mm_stream_si128(out + 3, d);
+  }
+#endif
+  std::memcpy(dst, src, size);
+}
+
+/// Copies `shape[dim0] x shape[dim1]` elements of `N` bytes through tiles,
+/// where `dim1` is contiguous in the destination.
+template <std::size_t N>
+void copy_tiled(const ElementwiseLayout &layout, std::size_t dim0,
+                std::size_t dim1, const std::byte *src, std::byte *dst) {
+  const std::size_t rows = layout.shape[dim0];
+  const std::size_t cols = layout.shape[dim1];
+  const std::size_t src_row = layout.src_strides[dim0];
+  const std::size_t src_col = layout.src_strides[dim1];
+  const std::size_t dst_row = layout.dst_strides[dim0];
+
+  for (std::size_t i0 = 0; i0 < rows; i0 += TILE_SIZE) {
+    std::size_t i1 = std::min(i0 + TILE_SIZE, rows);
+    for (std::size_t j0 = 0; j0 < cols; j0 += TILE_SIZE) {
+      std::size_t j1 = std::min(j0 + TILE_SIZE, cols);
+      for (std::size_t i = i0; i < i1; ++i) {
+        const std::byte *in = src + i * src_row + j0 * src_col;
+        std::byte *out = dst + i * dst_row + j0 * N;
+        for (std::size_t j = j0; j < j1; ++j, in += src_col, out += N)
+          std::memcpy(out, in, N);
+      }
+    }
+  }
+}
+
+/// Copies the elements of `N` bytes of the inner dimension one by one.
+template <std::size_t N>
+void copy_elements(std::size_t count, std::size_t src_stride,
+                   std::size_t dst_stride, const std::byte *src,
+                   std::byte *dst) {
+  for (std::size_t i = 0; i < count; ++i, src += src_stride, dst += dst_stride)
+    std::memcpy(dst, src, N);
+}
+
+/// Calls `f.template operator()<N>()` with `N` the size of an element.
+template <typename F> void dispatch_size(std::size_t type_size, F f) {
+  switch (type_size) {
+  case 1:
+    return f.template operator()<1>();
+  case 2:
+    return f.template operator()<2>();
+  case 4:
+    return f.template operator()<4>();
+  case 8:
+    return f.template operator()<8>();
+  case 16:
+    return f.template operator()<16>();
+  default:
+    LOG(FATAL) << "Unsupported element size " << type_size;
+  }
+}
+} // namespace
+
+void copy(const Tensor &src, const Tensor &dst, const CopyOptions &options) {
+  const TensorDescriptor &src_desc = src.desc();
+  const TensorDescriptor &dst_desc = dst.desc();
+  CHECK_EQ(src_desc.dtype(), dst_desc.dtype())
+      << ": Cannot copy between different types!";
+  CHECK(src_desc.shape() == dst_desc.shape())
+      << ": Cannot copy between different shapes!";
+
+  const std::size_t type_size = src_desc.type_size();
+  const std::size_t nb_elements = src_desc.nb_elements();
+  if (nb_elements == 0)
+    return;
+
+  const std::byte *in = src.raw_data();
+  std::byte *out = dst.raw_data();
+  ElementwiseLayout layout(src_desc, dst_desc);
+  if (layout.rank == 0) {
+    std::memcpy(out, in, type_size);
+    return;
+  }
+
+  const std::size_t inner = layout.rank - 1;
+  if (layout.src_strides[inner] == type_size &&
+      layout.dst_strides[inner] == type_size) {
+    bool non_temporal =
+        options.non_temporal == NonTemporal::Always ||
+        (options.non_temporal == NonTemporal::Auto &&
+         nb_elements * type_size >= NON_TEMPORAL_THRESHOLD);
+    std::size_t run = layout.shape[inner] * type_size;
+
+    layout.for_each_outer(
+        inner, MAX_TENSOR_RANK,
+        [&](std::size_t src_offset, std::size_t dst_offset) {
+          if (non_temporal)
+            stream_copy(out + dst_offset, in + src_offset, run);
+          else
+            std::memcpy(out + dst_offset, in + src_offset, run);
+        });
+#if defined(__SSE2__)
+    if (non_temporal)
+      _mm_sfence();
+#endif
+    return;
+  }
+
+  // A transpose: the destination is contiguous along a dimension of the
+  // source that is not its inner one.
+  if (layout.dst_strides[inner] == type_size) {
+    for (std::size_t dim = 0; dim < inner; ++dim) {
+      if (layout.src_strides[dim] != type_size)
+        continue;
+
+      dispatch_size(type_size, [&]<std::size_t N>() {
+        layout.for_each_outer(
+            dim, inner, [&](std::size_t src_offset, std::size_t dst_offset) {
+              copy_tiled<N>(layout, dim, inner, in + src_offset,
+                            out + dst_offset);
+            });
+      });
+      return;
+    }
+  }
+
+  dispatch_size(type_size, [&]<std::size_t N>() {
+    layout.for_each_outer(
+        inner, MAX_TENSOR_RANK,
+        [&](std::size_t src_offset, std::size_t dst_offset) {
+          copy_elements<N>(layout.shape[inner], layout.src_strides[inner],
+                           layout.dst_strides[inner], in + src_offset,
+                           out + dst_offset);
+        });
+  });
+}
+
+} // namespace holoflow
@@ -1,17 +1,16 @@
 #include "holoflow/tensor/descriptor.hh"
 
+#include <algorithm>
+#include <functional>
 #include <numeric>
 
 #include <glog/logging.h>
 
 namespace holoflow {
 
-TensorDescriptor::TensorDescriptor(const std::string &type_name,
-                                   std::size_t type_size,
-                                   const std::vector<std::size_t> &shape,
-                                   const std::vector<std::size_t> &strides)
-    : type_name_(type_name), type_size_(type_size), shape_(shape),
-      strides_(strides) {
+TensorDescriptor::TensorDescriptor(DType dtype, const Dims &shape,
+                                   const Dims &strides)
+    : dtype_(dtype), shape_(shape), strides_(strides) {
   CHECK_EQ(shape.size(), strides.size())
       << ": Shape and strides must have the same number of dimensions.";
 
@@ -19,7 +18,7 @@ TensorDescriptor::TensorDescriptor(const std::string &type_name,
     return;
 
   size_t last = shape.size() - 1;
-  CHECK_GE(strides[last], type_size_)
+  CHECK_GE(strides[last], type_size())
       << ": Stride is not big enough to hold elements!";
 
   for (size_t i = 1; i < shape.size(); ++i) {
@@ -31,21 +30,20 @@ TensorDescriptor::TensorDescriptor(const std::string &type_name,
   }
 }
 
-const std::string &TensorDescriptor::type_name() const { return type_name_; }
+DType TensorDescriptor::dtype() const { return dtype_; }
 
-std::size_t TensorDescriptor::type_size() const { return type_size_; }
-
-const std::vector<std::size_t> &TensorDescriptor::shape() const {
-  return shape_;
+std::string_view TensorDescriptor::type_name() const {
+  return dtype_name(dtype_);
 }
 
-const std::vector<std::size_t> &TensorDescriptor::strides() const {
-  return strides_;
-}
+std::size_t TensorDescriptor::type_size() const { return dtype_size(dtype_); }
+
+const Dims &TensorDescriptor::shape() const { return shape_; }
+
+const Dims &TensorDescriptor::strides() const { return strides_; }
 
 bool TensorDescriptor::operator==(const TensorDescriptor &other) const {
-  return type_name_ == other.type_name_ && type_size_ == other.type_size_ &&
-         shape_ == other.shape_;
+  return dtype_ == other.dtype_ && shape_ == other.shape_;
 }
 
 bool TensorDescriptor::operator!=(const TensorDescriptor &other) const {
@@ -56,7 +54,44 @@ std::size_t TensorDescriptor::size_in_bytes() const {
   if (shape_.empty() || strides_.empty()) {
     return 0;
   }
-  return shape_.front() * strides_.front();
+
+  // The span of each dimension, padding included, as the constructor checks
+  // it. The widest one holds the others, whatever their order.
+  std::size_t size = 0;
+  for (size_t i = 0; i < shape_.size(); ++i) {
+    if (shape_[i] == 0)
+      return 0;
+    size = std::max(size, shape_[i] * strides_[i]);
+  }
+  return size;
+}
+
+std::size_t TensorDescriptor::nb_elements() const {
+  if (shape_.empty())
+    return 0;
+  return std::accumulate(shape_.begin(), shape_.end(), std::size_t{1},
+                         std::multiplies<>());
+}
+
+bool TensorDescriptor::is_contiguous() const {
+  std::size_t expected = type_size();
+  for (size_t i = shape_.size(); i-- > 0;) {
+    if (shape_[i] == 1)
+      continue;
+    if (strides_[i] != expected)
+      return false;
+    expected *= shape_[i];
+  }
+  return true;
+}
+
+TensorDescriptor TensorDescriptor::unchecked(DType dtype, const Dims &shape,
+                                             const Dims &strides) {
+  TensorDescriptor desc;
+  desc.dtype_ = dtype;
+  desc.shape_ = shape;
+  desc.strides_ = strides;
+  return desc;
 }
 
 } // namespace holoflow
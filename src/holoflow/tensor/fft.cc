@@ -0,0 +1,622 @@
+#include "holoflow/tensor/fft.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <numbers>
+#include <type_traits>
+#include <utility>
+
+namespace holoflow {
+
+/// A stage of a Stockham FFT, which splits `s` interleaved sequences of length
+/// `radix * m` into `s * radix` sequences of length `m`.
+struct FftStage {
+  std::size_t radix = 0;
+  std::size_t m = 0;
+  std::size_t s = 0;
+
+  /// The offset in the twiddles of the pass of the `m * (radix - 1)` twiddle
+  /// factors of the stage, as (real, imaginary) pairs.
+  std::size_t twiddles = 0;
+
+  /// The offset in the twiddles of the pass of the `radix` roots of unity of
+  /// a generic stage.
+  std::size_t roots = 0;
+};
+
+struct FftPass {
+  /// The length of the lines.
+  std::size_t length = 0;
+
+  /// The stride in bytes of the elements of the lines in the source.
+  std::size_t src_stride = 0;
+
+  /// The stride in bytes of the elements of the lines in the destination.
+  std::size_t dst_stride = 0;
+
+  /// The byte offset of each line in the source.
+  std::vector<std::size_t> src_lines;
+
+  /// The byte offset of each line in the destination.
+  std::vector<std::size_t> dst_lines;
+
+  std::vector<FftStage> stages;
+
+  /// The twiddle factors and roots of unity of the stages, in each precision.
+  std::vector<float> twiddles_f32;
+  std::vector<double> twiddles_f64;
+};
+
+namespace {
+
+/// Returns the byte offsets of the lines of a tensor along `axis`, in the
+/// order of its other dimensions.
+std::vector<std::size_t> line_offsets(const Dims &shape, const Dims &strides,
+                                      std::size_t axis) {
+  std::vector<std::size_t> offsets{0};
+  for (std::size_t dim = 0; dim < shape.size(); ++dim) {
+    if (dim == axis)
+      continue;
+    std::vector<std::size_t> next;
+    next.reserve(offsets.size() * shape[dim]);
+    for (std::size_t offset : offsets)
+      for (std::size_t i = 0; i < shape[dim]; ++i)
+        next.push_back(offset + i * strides[dim]);
+    offsets.swap(next);
+  }
+  return offsets;
+}
+
+/// Returns the radices of a length: as many 4 as possible, then 2, 3 and the
+/// other prime factors.
+std::vector<std::size_t> factorize(std::size_t length) {
+  std::vector<std::size_t> radices;
+  while (length % 4 == 0) {
+    radices.push_back(4);
+    length /= 4;
+  }
+  for (std::size_t factor = 2; length > 1; ++factor) {
+    if (factor * factor > length)
+      factor = length;
+    while (length % factor == 0) {
+      radices.push_back(factor);
+      length /= factor;
+    }
+  }
+  return radices;
+}
+
+/// Appends `exp(-2i * pi * k / n)` to `twiddles`.
+void push_root(std::vector<double> &twiddles, std::size_t k, std::size_t n) {
+  const double angle = -2 * std::numbers::pi * static_cast<double>(k % n) /
+                       static_cast<double>(n);
+  twiddles.push_back(std::cos(angle));
+  twiddles.push_back(std::sin(angle));
+}
+
+/// Plans the stages of a pass, and computes their twiddle factors.
+void plan_stages(FftPass &pass) {
+  std::size_t m = pass.length;
+  std::size_t s = 1;
+  for (std::size_t radix : factorize(pass.length)) {
+    m /= radix;
+    FftStage stage{.radix = radix,
+                   .m = m,
+                   .s = s,
+                   .twiddles = pass.twiddles_f64.size()};
+    for (std::size_t p = 0; p < m; ++p)
+      for (std::size_t k = 1; k < radix; ++k)
+        push_root(pass.twiddles_f64, p * k, radix * m);
+    stage.roots = pass.twiddles_f64.size();
+    if (radix > 4)
+      for (std::size_t j = 0; j < radix; ++j)
+        push_root(pass.twiddles_f64, j, radix);
+    pass.stages.push_back(stage);
+    s *= radix;
+  }
+  pass.twiddles_f32.assign(pass.twiddles_f64.begin(),
+                           pass.twiddles_f64.end());
+}
+
+/// Multiplies `(re, im)` by `w[0] + i * w[1]`.
+template <typename V, typename T>
+[[gnu::always_inline]] inline void multiply(V &re, V &im, const T *w) {
+  V r = re * w[0] - im * w[1];
+  im = re * w[1] + im * w[0];
+  re = r;
+}
+
+/**
+ * @brief Runs a stage on SIMD vectors of `Width` bytes: `x` and `y` hold the
+ * `n` real parts then the `n` imaginary parts of the elements, each as a
+ * vector of one lane per line.
+ *
+ * Radices 2, 3 and 4 have their own butterflies, the others compute a direct
+ * DFT from the roots of unity.
+ */
+template <typename T, std::size_t Width, std::size_t Radix>
+[[gnu::always_inline]] inline void
+run_stage(const FftStage &stage, const T *twiddles, const T *x, T *y,
+          std::size_t n) {
+  typedef T V
+      __attribute__((vector_size(Width), aligned(alignof(T)), may_alias));
+  const V *xr = reinterpret_cast<const V *>(x);
+  const V *xi = xr + n;
+  V *yr = reinterpret_cast<V *>(y);
+  V *yi = yr + n;
+  const std::size_t radix = Radix != 0 ? Radix : stage.radix;
+  const std::size_t m = stage.m;
+  const std::size_t s = stage.s;
+  const std::size_t sm = s * m;
+
+  for (std::size_t p = 0; p < m; ++p) {
+    const T *w = twiddles + stage.twiddles + 2 * p * (radix - 1);
+    for (std::size_t q = 0; q < s; ++q) {
+      const std::size_t in = q + s * p;
+      const std::size_t out = q + s * radix * p;
+
+      if constexpr (Radix == 2) {
+        V ar = xr[in];
+        V ai = xi[in];
+        V br = xr[in + sm];
+        V bi = xi[in + sm];
+        V dr = ar - br;
+        V di = ai - bi;
+        multiply(dr, di, w);
+        yr[out] = ar + br;
+        yi[out] = ai + bi;
+        yr[out + s] = dr;
+        yi[out + s] = di;
+      } else if constexpr (Radix == 3) {
+        const T sin60 = static_cast<T>(std::numbers::sqrt3 / 2);
+        V ar = xr[in];
+        V ai = xi[in];
+        V br = xr[in + sm];
+        V bi = xi[in + sm];
+        V cr = xr[in + 2 * sm];
+        V ci = xi[in + 2 * sm];
+        V tr = br + cr;
+        V ti = bi + ci;
+        V dr = (br - cr) * sin60;
+        V di = (bi - ci) * sin60;
+        V mr = ar - tr * T(0.5);
+        V mi = ai - ti * T(0.5);
+        // Multiplying by -i maps (re, im) to (im, -re).
+        V y1r = mr + di;
+        V y1i = mi - dr;
+        V y2r = mr - di;
+        V y2i = mi + dr;
+        multiply(y1r, y1i, w);
+        multiply(y2r, y2i, w + 2);
+        yr[out] = ar + tr;
+        yi[out] = ai + ti;
+        yr[out + s] = y1r;
+        yi[out + s] = y1i;
+        yr[out + 2 * s] = y2r;
+        yi[out + 2 * s] = y2i;
+      } else if constexpr (Radix == 4) {
+        V ar = xr[in];
+        V ai = xi[in];
+        V br = xr[in + sm];
+        V bi = xi[in + sm];
+        V cr = xr[in + 2 * sm];
+        V ci = xi[in + 2 * sm];
+        V dr = xr[in + 3 * sm];
+        V di = xi[in + 3 * sm];
+        V t0r = ar + cr;
+        V t0i = ai + ci;
+        V t1r = ar - cr;
+        V t1i = ai - ci;
+        V t2r = br + dr;
+        V t2i = bi + di;
+        // (b - d) * -i.
+        V t3r = bi - di;
+        V t3i = dr - br;
+        V y1r = t1r + t3r;
+        V y1i = t1i + t3i;
+        V y2r = t0r - t2r;
+        V y2i = t0i - t2i;
+        V y3r = t1r - t3r;
+        V y3i = t1i - t3i;
+        multiply(y1r, y1i, w);
+        multiply(y2r, y2i, w + 2);
+        multiply(y3r, y3i, w + 4);
+        yr[out] = t0r + t2r;
+        yi[out] = t0i + t2i;
+        yr[out + s] = y1r;
+        yi[out + s] = y1i;
+        yr[out + 2 * s] = y2r;
+        yi[out + 2 * s] = y2i;
+        yr[out + 3 * s] = y3r;
+        yi[out + 3 * s] = y3i;
+      } else {
+        const T *roots = twiddles + stage.roots;
+        for (std::size_t k = 0; k < radix; ++k) {
+          V sum_r = {};
+          V sum_i = {};
+          for (std::size_t j = 0, root = 0; j < radix; ++j) {
+            V ar = xr[in + j * sm];
+            V ai = xi[in + j * sm];
+            sum_r += ar * roots[2 * root] - ai * roots[2 * root + 1];
+            sum_i += ar * roots[2 * root + 1] + ai * roots[2 * root];
+            root = (root + k) % radix;
+          }
+          if (k > 0)
+            multiply(sum_r, sum_i, w + 2 * (k - 1));
+          yr[out + k * s] = sum_r;
+          yi[out + k * s] = sum_i;
+        }
+      }
+    }
+  }
+}
+
+/// Splits `B` interleaved complex numbers into their `B` real and `B`
+/// imaginary parts.
+template <typename T, std::size_t Width, std::size_t... K>
+[[gnu::always_inline]] inline void
+deinterleave(const std::byte *in, T *re, T *im, std::index_sequence<K...>) {
+  typedef T V
+      __attribute__((vector_size(Width), aligned(alignof(T)), may_alias));
+  const V *v = reinterpret_cast<const V *>(in);
+  V a = v[0];
+  V b = v[1];
+  *reinterpret_cast<V *>(re) = __builtin_shufflevector(a, b, (2 * K)...);
+  *reinterpret_cast<V *>(im) = __builtin_shufflevector(a, b, (2 * K + 1)...);
+}
+
+/// Merges `B` real and `B` imaginary parts into interleaved complex numbers.
+template <typename T, std::size_t Width, std::size_t... K>
+[[gnu::always_inline]] inline void
+interleave(const T *re, const T *im, std::byte *out,
+           std::index_sequence<K...>) {
+  typedef T V
+      __attribute__((vector_size(Width), aligned(alignof(T)), may_alias));
+  constexpr std::size_t B = sizeof...(K);
+  V a = *reinterpret_cast<const V *>(re);
+  V b = *reinterpret_cast<const V *>(im);
+  V *v = reinterpret_cast<V *>(out);
+  v[0] = __builtin_shufflevector(a, b, (K % 2 ? B + K / 2 : K / 2)...);
+  v[1] = __builtin_shufflevector(a, b,
+                                 (K % 2 ? B + (B + K) / 2 : (B + K) / 2)...);
+}
+
+/// Swaps the off-diagonal `H`x`H` blocks of each `2H`x`2H` block of a `B`x`B`
+/// matrix of vectors, one step of its transposition.
+template <typename T, std::size_t Width, std::size_t H, std::size_t... K>
+[[gnu::always_inline]] inline void transpose_step(T *matrix,
+                                                  std::index_sequence<K...>) {
+  typedef T V
+      __attribute__((vector_size(Width), aligned(alignof(T)), may_alias));
+  constexpr std::size_t B = sizeof...(K);
+  V *rows = reinterpret_cast<V *>(matrix);
+  for (std::size_t j = 0; j < B; ++j) {
+    if (j & H)
+      continue;
+    V a = rows[j];
+    V b = rows[j + H];
+    rows[j] = __builtin_shufflevector(a, b, (K & H ? B + K - H : K)...);
+    rows[j + H] = __builtin_shufflevector(a, b, (K & H ? B + K : K + H)...);
+  }
+}
+
+/// Transposes a `B`x`B` matrix of vectors of `Width` bytes in place.
+template <typename T, std::size_t Width>
+[[gnu::always_inline]] inline void transpose(T *matrix) {
+  constexpr std::size_t B = Width / sizeof(T);
+  constexpr auto lanes = std::make_index_sequence<B>();
+  if constexpr (B >= 16)
+    transpose_step<T, Width, 8>(matrix, lanes);
+  if constexpr (B >= 8)
+    transpose_step<T, Width, 4>(matrix, lanes);
+  if constexpr (B >= 4)
+    transpose_step<T, Width, 2>(matrix, lanes);
+  transpose_step<T, Width, 1>(matrix, lanes);
+}
+
+/// Returns whether the `B` lines of a block are consecutive complex numbers.
+template <typename T, std::size_t B>
+[[gnu::always_inline]] inline bool adjacent(const std::size_t *lines) {
+  for (std::size_t l = 1; l < B; ++l)
+    if (lines[l] != lines[0] + l * 2 * sizeof(T))
+      return false;
+  return true;
+}
+
+/**
+ * @brief Transforms the lines `[begin, end)` of a pass, by blocks of one line
+ * per lane of `Width` bytes.
+ *
+ * The blocks are gathered into the real and imaginary parts of each element,
+ * one lane per line. Full blocks of adjacent lines, e.g. columns, are split
+ * with one shuffle per element, and full blocks of contiguous lines, e.g. rows,
+ * are transposed in registers by tiles of `B`x`B` elements. The others go
+ * element by element.
+ */
+template <typename T, std::size_t Width>
+[[gnu::always_inline]] inline void
+transform_lines(const FftPass &pass, const std::byte *src, std::byte *dst,
+                std::size_t begin, std::size_t end, bool inverse) {
+  constexpr std::size_t B = Width / sizeof(T);
+  constexpr auto lanes = std::make_index_sequence<B>();
+  const std::size_t n = pass.length;
+  const T *twiddles;
+  if constexpr (std::is_same_v<T, float>)
+    twiddles = pass.twiddles_f32.data();
+  else
+    twiddles = pass.twiddles_f64.data();
+
+  // The parts of the block, and of the next stage. The inverse transform is
+  // the forward one of the swapped parts, swapped.
+  std::vector<T> work(4 * n * B);
+  T *x = work.data();
+  T *y = x + 2 * n * B;
+  const std::size_t tiled = n - n % B;
+  const bool contiguous_src = pass.src_stride == 2 * sizeof(T);
+  const bool contiguous_dst = pass.dst_stride == 2 * sizeof(T);
+
+  for (std::size_t line = begin; line < end; line += B) {
+    const std::size_t nb_lines = std::min(B, end - line);
+    const std::size_t *src_lines = pass.src_lines.data() + line;
+    const std::size_t *dst_lines = pass.dst_lines.data() + line;
+
+    T *re = inverse ? x + n * B : x;
+    T *im = inverse ? x : x + n * B;
+    std::size_t i = 0;
+    if (nb_lines == B && adjacent<T, B>(src_lines)) {
+      for (; i < n; ++i)
+        deinterleave<T, Width>(src + src_lines[0] + i * pass.src_stride,
+                               re + i * B, im + i * B, lanes);
+    } else if (nb_lines == B && contiguous_src) {
+      for (; i < tiled; i += B) {
+        for (std::size_t l = 0; l < B; ++l)
+          deinterleave<T, Width>(src + src_lines[l] + i * pass.src_stride,
+                                 re + (i + l) * B, im + (i + l) * B, lanes);
+        transpose<T, Width>(re + i * B);
+        transpose<T, Width>(im + i * B);
+      }
+    }
+    for (; i < n; ++i) {
+      for (std::size_t l = 0; l < B; ++l) {
+        std::complex<T> value;
+        if (l < nb_lines)
+          std::memcpy(&value, src + src_lines[l] + i * pass.src_stride,
+                      sizeof(value));
+        re[i * B + l] = value.real();
+        im[i * B + l] = value.imag();
+      }
+    }
+
+    T *cur = x;
+    T *next = y;
+    for (const FftStage &stage : pass.stages) {
+      switch (stage.radix) {
+      case 2:
+        run_stage<T, Width, 2>(stage, twiddles, cur, next, n);
+        break;
+      case 3:
+        run_stage<T, Width, 3>(stage, twiddles, cur, next, n);
+        break;
+      case 4:
+        run_stage<T, Width, 4>(stage, twiddles, cur, next, n);
+        break;
+      default:
+        run_stage<T, Width, 0>(stage, twiddles, cur, next, n);
+        break;
+      }
+      std::swap(cur, next);
+    }
+
+    if (inverse)
+      for (std::size_t j = 0; j < 2 * n * B; ++j)
+        cur[j] /= static_cast<T>(n);
+    re = inverse ? cur + n * B : cur;
+    im = inverse ? cur : cur + n * B;
+    i = 0;
+    if (nb_lines == B && adjacent<T, B>(dst_lines)) {
+      for (; i < n; ++i)
+        interleave<T, Width>(re + i * B, im + i * B,
+                             dst + dst_lines[0] + i * pass.dst_stride, lanes);
+    } else if (nb_lines == B && contiguous_dst) {
+      for (; i < tiled; i += B) {
+        transpose<T, Width>(re + i * B);
+        transpose<T, Width>(im + i * B);
+        for (std::size_t l = 0; l < B; ++l)
+          interleave<T, Width>(re + (i + l) * B, im + (i + l) * B,
+                               dst + dst_lines[l] + i * pass.dst_stride,
+                               lanes);
+      }
+    }
+    for (; i < n; ++i) {
+      for (std::size_t l = 0; l < nb_lines; ++l) {
+        std::complex<T> value(re[i * B + l], im[i * B + l]);
+        std::memcpy(dst + dst_lines[l] + i * pass.dst_stride, &value,
+                    sizeof(value));
+      }
+    }
+  }
+}
+
+/// A kernel transforming lines `[begin, end)` of a pass.
+using FftKernel = void (*)(const FftPass &pass, const std::byte *src,
+                           std::byte *dst, std::size_t begin, std::size_t end,
+                           bool inverse);
+
+template <typename T>
+void transform_scalar(const FftPass &pass, const std::byte *src,
+                      std::byte *dst, std::size_t begin, std::size_t end,
+                      bool inverse) {
+  transform_lines<T, 2 * sizeof(T)>(pass, src, dst, begin, end, inverse);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HOLOFLOW_X86_KERNELS
+
+template <typename T>
+[[gnu::target("sse4.1")]] void
+transform_sse4(const FftPass &pass, const std::byte *src, std::byte *dst,
+               std::size_t begin, std::size_t end, bool inverse) {
+  transform_lines<T, 16>(pass, src, dst, begin, end, inverse);
+}
+
+template <typename T>
+[[gnu::target("avx2,fma")]] void
+transform_avx2(const FftPass &pass, const std::byte *src, std::byte *dst,
+               std::size_t begin, std::size_t end, bool inverse) {
+  transform_lines<T, 32>(pass, src, dst, begin, end, inverse);
+}
+
+// Blocks of 512-bit lanes are twice as large for the same butterflies, and
+// were slower than 256-bit ones compiled for AVX-512 on large frames.
+template <typename T>
+[[gnu::target("avx512f,avx512vl,avx2,fma")]] void
+transform_avx512(const FftPass &pass, const std::byte *src, std::byte *dst,
+                 std::size_t begin, std::size_t end, bool inverse) {
+  transform_lines<T, 32>(pass, src, dst, begin, end, inverse);
+}
+#endif
+
+/// A kernel and the number of lines it transforms at once.
+struct FftKernelInfo {
+  FftKernel kernel = nullptr;
+  std::size_t lanes = 1;
+};
+
+template <typename T> FftKernelInfo select_kernel(SimdLevel level) {
+#if defined(HOLOFLOW_X86_KERNELS)
+  switch (level) {
+  case SimdLevel::Scalar:
+    break;
+  case SimdLevel::SSE4:
+    return {&transform_sse4<T>, 16 / sizeof(T)};
+  case SimdLevel::AVX2:
+    return {&transform_avx2<T>, 32 / sizeof(T)};
+  case SimdLevel::AVX512:
+    return {&transform_avx512<T>, 32 / sizeof(T)};
+  }
+#endif
+  (void)level;
+  return {&transform_scalar<T>, 2};
+}
+
+/// Returns the key of a plan in the cache.
+std::vector<std::size_t> plan_key(const TensorDescriptor &src,
+                                  const TensorDescriptor &dst,
+                                  std::size_t nb_axes) {
+  std::vector<std::size_t> key{static_cast<std::size_t>(src.dtype()),
+                               static_cast<std::size_t>(dst.dtype()), nb_axes,
+                               src.shape().size(), dst.shape().size()};
+  key.insert(key.end(), src.shape().begin(), src.shape().end());
+  key.insert(key.end(), dst.shape().begin(), dst.shape().end());
+  key.insert(key.end(), src.strides().begin(), src.strides().end());
+  key.insert(key.end(), dst.strides().begin(), dst.strides().end());
+  return key;
+}
+} // namespace
+
+FftPlan::FftPlan(const TensorDescriptor &src, const TensorDescriptor &dst,
+                 std::size_t nb_axes)
+    : src_(src), dst_(dst) {
+  CHECK(src.dtype() == DType::Complex64 || src.dtype() == DType::Complex128)
+      << ": Cannot transform " << src.dtype() << " tensors!";
+  CHECK(dst.dtype() == src.dtype())
+      << ": The source and destination must have the same data type!";
+  CHECK(dst.shape() == src.shape())
+      << ": The source and destination must have the same shape!";
+  CHECK(nb_axes == 1 || nb_axes == 2)
+      << ": Can only transform along 1 or 2 dimensions!";
+  CHECK_LE(nb_axes, src.shape().size())
+      << ": Not enough dimensions to transform!";
+
+  // The first pass reads the source, the next ones the destination in place.
+  const std::size_t rank = src.shape().size();
+  for (std::size_t axis = rank; axis-- > rank - nb_axes;) {
+    const TensorDescriptor &in = passes_.empty() ? src : dst;
+    FftPass pass;
+    pass.length = src.shape()[axis];
+    pass.src_stride = in.strides()[axis];
+    pass.dst_stride = dst.strides()[axis];
+    if (pass.length > 0) {
+      pass.src_lines = line_offsets(in.shape(), in.strides(), axis);
+      pass.dst_lines = line_offsets(dst.shape(), dst.strides(), axis);
+      plan_stages(pass);
+    }
+    passes_.push_back(std::move(pass));
+  }
+}
+
+FftPlan::~FftPlan() = default;
+
+std::shared_ptr<const FftPlan> FftPlan::cached(const TensorDescriptor &src,
+                                               const TensorDescriptor &dst,
+                                               std::size_t nb_axes) {
+  // The most recently used plan first. The cache is small enough for a
+  // linear search.
+  static std::mutex mutex;
+  static std::list<
+      std::pair<std::vector<std::size_t>, std::shared_ptr<const FftPlan>>>
+      plans;
+
+  std::vector<std::size_t> key = plan_key(src, dst, nb_axes);
+  std::lock_guard lock(mutex);
+  auto it = std::find_if(plans.begin(), plans.end(), [&key](const auto &entry) {
+    return entry.first == key;
+  });
+  if (it != plans.end()) {
+    plans.splice(plans.begin(), plans, it);
+  } else {
+    plans.emplace_front(std::move(key),
+                        std::make_shared<const FftPlan>(src, dst, nb_axes));
+    if (plans.size() > FFT_PLAN_CACHE_SIZE)
+      plans.pop_back();
+  }
+  return plans.front().second;
+}
+
+void FftPlan::execute(const Tensor &src, const Tensor &dst,
+                      const FftOptions &options) const {
+  CHECK(src.desc() == src_ && dst.desc() == dst_)
+      << ": The tensors do not have the layouts of the plan!";
+
+  const SimdLevel level = simd_level(options.max_simd_level);
+  const FftKernelInfo info = src_.dtype() == DType::Complex64
+                                 ? select_kernel<float>(level)
+                                 : select_kernel<double>(level);
+  const bool inverse = options.direction == FftDirection::Inverse;
+
+  for (const FftPass &pass : passes_) {
+    const std::byte *in = &pass == &passes_.front() ? src.raw_data()
+                                                    : dst.raw_data();
+    const std::size_t nb_lines = pass.src_lines.size();
+    const std::size_t nb_blocks = (nb_lines + info.lanes - 1) / info.lanes;
+    std::size_t nb_tasks = 1;
+    if (options.pool != nullptr)
+      nb_tasks = std::clamp<std::size_t>(nb_blocks, 1, options.pool->size());
+
+    if (nb_tasks == 1) {
+      info.kernel(pass, in, dst.raw_data(), 0, nb_lines, inverse);
+      continue;
+    }
+    // Each task transforms a contiguous range of whole blocks.
+    options.pool->parallel_for(nb_tasks, [&](std::size_t task) {
+      std::size_t begin = task * nb_blocks / nb_tasks * info.lanes;
+      std::size_t end =
+          std::min((task + 1) * nb_blocks / nb_tasks * info.lanes, nb_lines);
+      info.kernel(pass, in, dst.raw_data(), begin, end, inverse);
+    });
+  }
+}
+
+void fft(const Tensor &src, const Tensor &dst, const FftOptions &options) {
+  FftPlan::cached(src.desc(), dst.desc(), 1)->execute(src, dst, options);
+}
+
+void fft2(const Tensor &src, const Tensor &dst, const FftOptions &options) {
+  FftPlan::cached(src.desc(), dst.desc(), 2)->execute(src, dst, options);
+}
+
+} // namespace holoflow
@@ -0,0 +1,599 @@
+#include "holoflow/tensor/reduce.hh"
+#include "holoflow/tensor/elementwise.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace holoflow {
+namespace {
+
+/// The number of elements reduced in SIMD lanes before being merged in
+/// `double`, and the size of the blocks tasks are made of.
+constexpr std::size_t BLOCK_SIZE = 1024;
+
+/// The number of values each SIMD lane adds before its sums are widened to
+/// `double`, whatever the width of the lanes.
+constexpr std::size_t LANE_RUN = 32;
+
+/// The partial statistics of a set of elements.
+struct Moments {
+  /// Returns the compensated sum.
+  double total() const { return sum - compensation; }
+
+  /// Adds the elements of `other`, with Chan's update for the variance.
+  void merge(const Moments &other) {
+    if (other.count == 0)
+      return;
+    if (count == 0) {
+      *this = other;
+      return;
+    }
+
+    // Kahan summation: `compensation` holds what the additions lost.
+    double y = other.total() - compensation;
+    double t = sum + y;
+    compensation = (t - sum) - y;
+    sum = t;
+
+    double n = static_cast<double>(count + other.count);
+    double delta = other.mean - mean;
+    mean += delta * static_cast<double>(other.count) / n;
+    m2 += other.m2 + delta * delta * static_cast<double>(count) *
+                         static_cast<double>(other.count) / n;
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+    count += other.count;
+  }
+
+  std::size_t count = 0;
+  double sum = 0;
+  double compensation = 0;
+  double mean = 0;
+
+  /// The sum of the squared deviations from `mean`.
+  double m2 = 0;
+
+  double min = std::numeric_limits<double>::infinity();
+  double max = -std::numeric_limits<double>::infinity();
+};
+
+/// The type the SIMD lanes reduce elements of type `S` in.
+template <typename S>
+using Lane = std::conditional_t<std::is_same_v<S, float>, float, double>;
+
+/// Returns `n` elements of type `S`, `stride` bytes apart, as contiguous
+/// elements of type `T`: in place when they already are, in `block` otherwise.
+template <typename S, typename T>
+[[gnu::always_inline]] inline const T *
+dense_block(const std::byte *data, std::size_t stride, std::size_t n,
+            T *block) {
+  if constexpr (std::is_same_v<S, T>) {
+    if (stride == sizeof(S))
+      return reinterpret_cast<const T *>(data);
+  }
+  for (std::size_t i = 0; i < n; ++i) {
+    S value;
+    std::memcpy(&value, data + i * stride, sizeof(S));
+    block[i] = static_cast<T>(value);
+  }
+  return block;
+}
+
+/**
+ * @brief Reduces a block of at most `BLOCK_SIZE` elements in SIMD lanes of
+ * `Width` bytes, with GCC vector extensions so that each instruction set
+ * instantiates it with its own registers.
+ *
+ * @param with_m2 Whether to make a second pass for the squared deviations.
+ */
+template <typename S, std::size_t Width>
+[[gnu::always_inline]] inline Moments
+block_moments(const std::byte *data, std::size_t stride, std::size_t n,
+              bool with_m2) {
+  using T = Lane<S>;
+  typedef T V __attribute__((vector_size(Width)));
+  constexpr std::size_t L = Width / sizeof(T);
+  constexpr std::size_t RUN = 2 * L * LANE_RUN;
+
+  alignas(64) T block[BLOCK_SIZE];
+  const T *values = dense_block<S>(data, stride, n, block);
+
+  // Two accumulators of each, to hide the latency of the additions. The sums
+  // are widened every `LANE_RUN` values per lane, so that narrow lanes do not
+  // add up hundreds of `float` values.
+  double wide[L] = {};
+  V low = V{} + std::numeric_limits<T>::infinity();
+  V high = V{} - std::numeric_limits<T>::infinity();
+  std::size_t i = 0;
+  for (std::size_t run = 0; run < n; run += RUN) {
+    const std::size_t end = std::min(run + RUN, n);
+    V sum0 = {};
+    V sum1 = {};
+    for (; i + 2 * L <= end; i += 2 * L) {
+      V a;
+      V b;
+      std::memcpy(&a, values + i, sizeof(V));
+      std::memcpy(&b, values + i + L, sizeof(V));
+      sum0 += a;
+      sum1 += b;
+      low = a < low ? a : low;
+      low = b < low ? b : low;
+      high = a > high ? a : high;
+      high = b > high ? b : high;
+    }
+    for (std::size_t l = 0; l < L; ++l)
+      wide[l] += static_cast<double>(sum0[l]) + static_cast<double>(sum1[l]);
+  }
+
+  Moments moments;
+  moments.count = n;
+  for (std::size_t l = 0; l < L; ++l) {
+    moments.sum += wide[l];
+    moments.min = std::min(moments.min, static_cast<double>(low[l]));
+    moments.max = std::max(moments.max, static_cast<double>(high[l]));
+  }
+  for (; i < n; ++i) {
+    moments.sum += values[i];
+    moments.min = std::min(moments.min, static_cast<double>(values[i]));
+    moments.max = std::max(moments.max, static_cast<double>(values[i]));
+  }
+  moments.mean = moments.sum / static_cast<double>(n);
+
+  if (with_m2) {
+    const T mean = static_cast<T>(moments.mean);
+    double wide_m2[L] = {};
+    i = 0;
+    for (std::size_t run = 0; run < n; run += RUN) {
+      const std::size_t end = std::min(run + RUN, n);
+      V m0 = {};
+      V m1 = {};
+      for (; i + 2 * L <= end; i += 2 * L) {
+        V a;
+        V b;
+        std::memcpy(&a, values + i, sizeof(V));
+        std::memcpy(&b, values + i + L, sizeof(V));
+        a -= mean;
+        b -= mean;
+        m0 += a * a;
+        m1 += b * b;
+      }
+      for (std::size_t l = 0; l < L; ++l)
+        wide_m2[l] += static_cast<double>(m0[l]) + static_cast<double>(m1[l]);
+    }
+    for (std::size_t l = 0; l < L; ++l)
+      moments.m2 += wide_m2[l];
+    for (; i < n; ++i) {
+      T deviation = values[i] - mean;
+      moments.m2 += deviation * deviation;
+    }
+  }
+  return moments;
+}
+
+/// Adds a block of at most `BLOCK_SIZE` elements to contiguous sums, with
+/// Kahan compensation, in SIMD lanes of `Width` bytes.
+template <typename S, std::size_t Width>
+[[gnu::always_inline]] inline void
+block_kahan_add(const std::byte *data, std::size_t stride, std::size_t n,
+                double *sums, double *compensations) {
+  typedef double V __attribute__((vector_size(Width)));
+  constexpr std::size_t L = Width / sizeof(double);
+  typedef S VS __attribute__((vector_size(L * sizeof(S))));
+
+  // Contiguous elements are widened in the lanes, the others gathered first.
+  alignas(64) double block[BLOCK_SIZE];
+  const bool dense = stride == sizeof(S);
+  const double *values =
+      dense ? nullptr : dense_block<S>(data, stride, n, block);
+
+  std::size_t i = 0;
+  for (; i + L <= n; i += L) {
+    V x;
+    V s;
+    V c;
+    if (dense) {
+      VS narrow;
+      std::memcpy(&narrow, data + i * sizeof(S), sizeof(VS));
+      x = __builtin_convertvector(narrow, V);
+    } else {
+      std::memcpy(&x, values + i, sizeof(V));
+    }
+    std::memcpy(&s, sums + i, sizeof(V));
+    std::memcpy(&c, compensations + i, sizeof(V));
+    V y = x - c;
+    V t = s + y;
+    c = (t - s) - y;
+    std::memcpy(sums + i, &t, sizeof(V));
+    std::memcpy(compensations + i, &c, sizeof(V));
+  }
+  for (; i < n; ++i) {
+    double value;
+    if (dense) {
+      S element;
+      std::memcpy(&element, data + i * sizeof(S), sizeof(S));
+      value = static_cast<double>(element);
+    } else {
+      value = values[i];
+    }
+    double y = value - compensations[i];
+    double t = sums[i] + y;
+    compensations[i] = (t - sums[i]) - y;
+    sums[i] = t;
+  }
+}
+
+/// The kernels of a data type, for one instruction set.
+struct ReduceKernels {
+  Moments (*moments)(const std::byte *data, std::size_t stride, std::size_t n,
+                     bool with_m2);
+  void (*kahan_add)(const std::byte *data, std::size_t stride, std::size_t n,
+                    double *sums, double *compensations);
+};
+
+template <typename S>
+Moments moments_scalar(const std::byte *data, std::size_t stride,
+                       std::size_t n, bool with_m2) {
+  return block_moments<S, 8>(data, stride, n, with_m2);
+}
+
+template <typename S>
+void kahan_add_scalar(const std::byte *data, std::size_t stride, std::size_t n,
+                      double *sums, double *compensations) {
+  block_kahan_add<S, 8>(data, stride, n, sums, compensations);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HOLOFLOW_X86_KERNELS
+
+template <typename S>
+[[gnu::target("sse4.1")]] Moments moments_sse4(const std::byte *data,
+                                               std::size_t stride,
+                                               std::size_t n, bool with_m2) {
+  return block_moments<S, 16>(data, stride, n, with_m2);
+}
+
+template <typename S>
+[[gnu::target("sse4.1")]] void
+kahan_add_sse4(const std::byte *data, std::size_t stride, std::size_t n,
+               double *sums, double *compensations) {
+  block_kahan_add<S, 16>(data, stride, n, sums, compensations);
+}
+
+template <typename S>
+[[gnu::target("avx2,fma")]] Moments moments_avx2(const std::byte *data,
+                                                 std::size_t stride,
+                                                 std::size_t n, bool with_m2) {
+  return block_moments<S, 32>(data, stride, n, with_m2);
+}
+
+template <typename S>
+[[gnu::target("avx2,fma")]] void
+kahan_add_avx2(const std::byte *data, std::size_t stride, std::size_t n,
+               double *sums, double *compensations) {
+  block_kahan_add<S, 32>(data, stride, n, sums, compensations);
+}
+
+template <typename S>
+[[gnu::target("avx512f,avx2,fma")]] Moments
+moments_avx512(const std::byte *data, std::size_t stride, std::size_t n,
+               bool with_m2) {
+  return block_moments<S, 64>(data, stride, n, with_m2);
+}
+
+template <typename S>
+[[gnu::target("avx512f,avx2,fma")]] void
+kahan_add_avx512(const std::byte *data, std::size_t stride, std::size_t n,
+                 double *sums, double *compensations) {
+  block_kahan_add<S, 64>(data, stride, n, sums, compensations);
+}
+#endif
+
+template <typename S> ReduceKernels select_kernels(SimdLevel level) {
+#if defined(HOLOFLOW_X86_KERNELS)
+  switch (level) {
+  case SimdLevel::Scalar:
+    break;
+  case SimdLevel::SSE4:
+    return {&moments_sse4<S>, &kahan_add_sse4<S>};
+  case SimdLevel::AVX2:
+    return {&moments_avx2<S>, &kahan_add_avx2<S>};
+  case SimdLevel::AVX512:
+    return {&moments_avx512<S>, &kahan_add_avx512<S>};
+  }
+#endif
+  (void)level;
+  return {&moments_scalar<S>, &kahan_add_scalar<S>};
+}
+
+ReduceKernels select_kernels(DType dtype, SimdLevel level) {
+  switch (dtype) {
+  case DType::U8:
+    return select_kernels<uint8_t>(level);
+  case DType::U16:
+    return select_kernels<uint16_t>(level);
+  case DType::U32:
+    return select_kernels<uint32_t>(level);
+  case DType::U64:
+    return select_kernels<uint64_t>(level);
+  case DType::I8:
+    return select_kernels<int8_t>(level);
+  case DType::I16:
+    return select_kernels<int16_t>(level);
+  case DType::I32:
+    return select_kernels<int32_t>(level);
+  case DType::I64:
+    return select_kernels<int64_t>(level);
+  case DType::F32:
+    return select_kernels<float>(level);
+  case DType::F64:
+    return select_kernels<double>(level);
+  default:
+    return {nullptr, nullptr};
+  }
+}
+
+/// Returns the kernels of a data type, after checking it can be reduced.
+ReduceKernels checked_kernels(DType dtype, SimdLevel level) {
+  ReduceKernels kernels = select_kernels(dtype, level);
+  CHECK(kernels.moments != nullptr)
+      << ": Cannot reduce " << dtype << " tensors!";
+  return kernels;
+}
+
+/// Returns the simplified layout of a reduction, with at least one dimension.
+ElementwiseLayout make_layout(const Dims &shape, const Dims &src_strides,
+                              const Dims &dst_strides) {
+  ElementwiseLayout layout(shape, src_strides, dst_strides);
+  if (layout.rank == 0) {
+    layout.rank = 1;
+    layout.shape[0] = 1;
+  }
+  return layout;
+}
+
+/// The runs of the inner dimension of a layout, cut into numbered blocks.
+class Blocks {
+public:
+  /// A block, with its byte offsets.
+  struct Block {
+    std::size_t src_offset = 0;
+    std::size_t dst_offset = 0;
+    std::size_t size = 0;
+  };
+
+  Blocks(const ElementwiseLayout &layout, std::size_t block_size)
+      : layout_(layout), inner_(layout.rank - 1), block_size_(block_size) {
+    run_size_ = layout.shape[inner_];
+    blocks_per_run_ = (run_size_ + block_size - 1) / block_size;
+    nb_runs_ = 1;
+    for (std::size_t dim = 0; dim < inner_; ++dim)
+      nb_runs_ *= layout.shape[dim];
+  }
+
+  /// Returns the number of blocks.
+  std::size_t size() const { return nb_runs_ * blocks_per_run_; }
+
+  /// Returns the stride in bytes of the elements of a block in the source.
+  std::size_t src_stride() const { return layout_.src_strides[inner_]; }
+
+  /// Returns the stride in bytes of the elements of a block in the
+  /// destination.
+  std::size_t dst_stride() const { return layout_.dst_strides[inner_]; }
+
+  /// Returns the block `index`, in the order of the dimensions.
+  Block operator[](std::size_t index) const {
+    std::size_t run = index / blocks_per_run_;
+    std::size_t begin = index % blocks_per_run_ * block_size_;
+
+    Block block;
+    for (std::size_t dim = inner_; dim-- > 0;) {
+      std::size_t i = run % layout_.shape[dim];
+      run /= layout_.shape[dim];
+      block.src_offset += i * layout_.src_strides[dim];
+      block.dst_offset += i * layout_.dst_strides[dim];
+    }
+    block.src_offset += begin * src_stride();
+    block.dst_offset += begin * dst_stride();
+    block.size = std::min(block_size_, run_size_ - begin);
+    return block;
+  }
+
+private:
+  ElementwiseLayout layout_;
+  std::size_t inner_;
+  std::size_t block_size_;
+  std::size_t run_size_;
+  std::size_t blocks_per_run_;
+  std::size_t nb_runs_;
+};
+
+/// Returns the number of tasks to split `nb_elements` elements in
+/// `nb_blocks` blocks into.
+std::size_t count_tasks(const ReduceOptions &options, std::size_t nb_elements,
+                        std::size_t nb_blocks) {
+  if (options.pool == nullptr || nb_blocks == 0)
+    return 1;
+  std::size_t nb_tasks = nb_elements / std::max<std::size_t>(
+                                           options.min_task_size, 1);
+  return std::clamp<std::size_t>(nb_tasks, 1,
+                                 std::min(options.pool->size(), nb_blocks));
+}
+
+/// Calls `f(task, begin, end)` for `nb_tasks` contiguous ranges of blocks,
+/// on the pool of `options` if there are several.
+template <typename F>
+void run_tasks(const ReduceOptions &options, std::size_t nb_tasks,
+               std::size_t nb_blocks, F f) {
+  if (nb_tasks == 1)
+    return f(0, 0, nb_blocks);
+  options.pool->parallel_for(nb_tasks, [&](std::size_t task) {
+    f(task, task * nb_blocks / nb_tasks, (task + 1) * nb_blocks / nb_tasks);
+  });
+}
+
+Moments reduce_all(const Tensor &src, const ReduceOptions &options,
+                   bool with_m2) {
+  const TensorDescriptor &desc = src.desc();
+  const ReduceKernels kernels =
+      checked_kernels(desc.dtype(), simd_level(options.max_simd_level));
+  const Blocks blocks(make_layout(desc.shape(), desc.strides(), desc.strides()),
+                      BLOCK_SIZE);
+  const std::byte *data = src.raw_data();
+
+  const std::size_t nb_tasks =
+      count_tasks(options, desc.nb_elements(), blocks.size());
+  std::vector<Moments> partials(nb_tasks);
+  run_tasks(options, nb_tasks, blocks.size(),
+            [&](std::size_t task, std::size_t begin, std::size_t end) {
+              Moments moments;
+              for (std::size_t i = begin; i < end; ++i) {
+                Blocks::Block block = blocks[i];
+                moments.merge(kernels.moments(data + block.src_offset,
+                                              blocks.src_stride(), block.size,
+                                              with_m2));
+              }
+              partials[task] = moments;
+            });
+
+  Moments total;
+  for (const Moments &partial : partials)
+    total.merge(partial);
+  return total;
+}
+
+void reduce_axis(const Tensor &src, std::size_t axis, const Tensor &dst,
+                 const ReduceOptions &options, bool average) {
+  const TensorDescriptor &src_desc = src.desc();
+  const TensorDescriptor &dst_desc = dst.desc();
+  CHECK_LT(axis, src_desc.shape().size()) << ": Dimension out of range!";
+  CHECK(dst_desc.dtype() == DType::F32 || dst_desc.dtype() == DType::F64)
+      << ": Cannot reduce into " << dst_desc.dtype() << " tensors!";
+
+  Dims shape;
+  Dims src_strides;
+  for (std::size_t i = 0; i < src_desc.shape().size(); ++i) {
+    if (i != axis) {
+      shape.push_back(src_desc.shape()[i]);
+      src_strides.push_back(src_desc.strides()[i]);
+    }
+  }
+  CHECK(dst_desc.shape() == shape)
+      << ": The shape of the destination must be the one of the source "
+         "without the reduced dimension!";
+
+  if (dst_desc.nb_elements() == 0)
+    return;
+
+  const ReduceKernels kernels =
+      checked_kernels(src_desc.dtype(), simd_level(options.max_simd_level));
+  const std::size_t length = src_desc.shape()[axis];
+  const std::size_t axis_stride = src_desc.strides()[axis];
+  const std::byte *data = src.raw_data();
+
+  // The sums are accumulated in dense `double` buffers of the output shape.
+  Dims sum_strides = shape;
+  std::size_t nb_outputs = 1;
+  for (std::size_t i = shape.size(); i-- > 0;) {
+    sum_strides[i] = nb_outputs * sizeof(double);
+    nb_outputs *= shape[i];
+  }
+  std::vector<double> sums(nb_outputs);
+  std::vector<double> compensations(nb_outputs);
+
+  if (axis_stride == src_desc.type_size() && length > 1) {
+    // The reduced dimension is contiguous: each output is a whole run.
+    const Blocks outputs(make_layout(shape, src_strides, sum_strides), 1);
+    const std::size_t nb_tasks =
+        count_tasks(options, src_desc.nb_elements(), outputs.size());
+    run_tasks(options, nb_tasks, outputs.size(),
+              [&](std::size_t, std::size_t begin, std::size_t end) {
+                for (std::size_t i = begin; i < end; ++i) {
+                  Blocks::Block output = outputs[i];
+                  Moments moments;
+                  for (std::size_t j = 0; j < length; j += BLOCK_SIZE) {
+                    moments.merge(kernels.moments(
+                        data + output.src_offset + j * axis_stride,
+                        axis_stride, std::min(BLOCK_SIZE, length - j), false));
+                  }
+                  sums[output.dst_offset / sizeof(double)] = moments.total();
+                }
+              });
+  } else {
+    // The reduced dimension is strided: each block of outputs adds the
+    // matching block of every slice, while it stays in the cache.
+    const Blocks blocks(make_layout(shape, src_strides, sum_strides),
+                        BLOCK_SIZE);
+    const std::size_t nb_tasks =
+        count_tasks(options, src_desc.nb_elements(), blocks.size());
+    run_tasks(options, nb_tasks, blocks.size(),
+              [&](std::size_t, std::size_t begin, std::size_t end) {
+                for (std::size_t i = begin; i < end; ++i) {
+                  Blocks::Block block = blocks[i];
+                  std::size_t output = block.dst_offset / sizeof(double);
+                  for (std::size_t k = 0; k < length; ++k) {
+                    kernels.kahan_add(
+                        data + block.src_offset + k * axis_stride,
+                        blocks.src_stride(), block.size, sums.data() + output,
+                        compensations.data() + output);
+                  }
+                }
+              });
+  }
+
+  const double scale = average ? 1.0 / static_cast<double>(length) : 1.0;
+  const ElementwiseLayout layout =
+      make_layout(shape, sum_strides, dst_desc.strides());
+  const std::size_t inner = layout.rank - 1;
+  std::byte *out = dst.raw_data();
+  layout.for_each_outer(
+      inner, MAX_TENSOR_RANK,
+      [&](std::size_t sum_offset, std::size_t dst_offset) {
+        for (std::size_t j = 0; j < layout.shape[inner]; ++j) {
+          std::size_t output = sum_offset / sizeof(double) +
+                               j * layout.src_strides[inner] / sizeof(double);
+          double value = (sums[output] - compensations[output]) * scale;
+          std::byte *element = out + dst_offset + j * layout.dst_strides[inner];
+          if (dst_desc.dtype() == DType::F32)
+            *reinterpret_cast<float *>(element) = static_cast<float>(value);
+          else
+            *reinterpret_cast<double *>(element) = value;
+        }
+      });
+}
+} // namespace
+
+TensorStats stats(const Tensor &src, const ReduceOptions &options) {
+  Moments moments = reduce_all(src, options, true);
+  const double count = static_cast<double>(moments.count);
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+
+  TensorStats stats;
+  stats.count = moments.count;
+  stats.sum = moments.total();
+  stats.min = moments.min;
+  stats.max = moments.max;
+  stats.mean = moments.count > 0 ? stats.sum / count : nan;
+  stats.variance = moments.count > 0 ? moments.m2 / count : nan;
+  return stats;
+}
+
+double sum(const Tensor &src, const ReduceOptions &options) {
+  return reduce_all(src, options, false).total();
+}
+
+void sum(const Tensor &src, std::size_t axis, const Tensor &dst,
+         const ReduceOptions &options) {
+  reduce_axis(src, axis, dst, options, false);
+}
+
+void mean(const Tensor &src, std::size_t axis, const Tensor &dst,
+          const ReduceOptions &options) {
+  reduce_axis(src, axis, dst, options, true);
+}
+
+} // namespace holoflow
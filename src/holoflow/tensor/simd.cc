@@ -0,0 +1,32 @@
+#include "holoflow/tensor/simd.hh"
+
+#include <algorithm>
+
+namespace holoflow {
+namespace {
+
+SimdLevel detect_simd_level() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx2") &&
+      __builtin_cpu_supports("fma"))
+    return SimdLevel::AVX512;
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    return SimdLevel::AVX2;
+  if (__builtin_cpu_supports("sse4.1"))
+    return SimdLevel::SSE4;
+#endif
+  return SimdLevel::Scalar;
+}
+} // namespace
+
+SimdLevel cpu_simd_level() {
+  static const SimdLevel level = detect_simd_level();
+  return level;
+}
+
+SimdLevel simd_level(SimdLevel max_level) {
+  return std::min(cpu_simd_level(), max_level);
+}
+
+} // namespace holoflow
@@ -1,5 +1,7 @@
 #include "holoflow/tensor/tensor.hh"
 
+#include <algorithm>
+
 namespace holoflow {
 
 Tensor::Tensor(const TensorDescriptor &desc, std::byte *data)
@@ -7,4 +9,164 @@ Tensor::Tensor(const TensorDescriptor &desc, std::byte *data)
 
 const TensorDescriptor &Tensor::desc() const { return desc_; }
 
+void Tensor::rebind(std::byte *data) { data_ = data; }
+
+std::byte *Tensor::raw_data() const { return data_; }
+
+bool Tensor::is_contiguous() const { return desc_.is_contiguous(); }
+
+Tensor Tensor::slice(std::size_t dim, std::size_t begin, std::size_t end,
+                     std::size_t step) const {
+  CHECK_LT(dim, desc_.shape().size()) << ": Dimension out of range!";
+  CHECK_LE(begin, end) << ": Slice begins after its end!";
+  CHECK_LE(end, desc_.shape()[dim]) << ": Slice out of range!";
+  CHECK_GT(step, 0) << ": Slice step must not be zero!";
+
+  Dims shape = desc_.shape();
+  Dims strides = desc_.strides();
+  shape[dim] = (end - begin + step - 1) / step;
+  strides[dim] *= step;
+  return Tensor(TensorDescriptor::unchecked(desc_.dtype(), shape, strides),
+                data_ + begin * desc_.strides()[dim]);
+}
+
+Tensor Tensor::crop(const Dims &begin, const Dims &shape) const {
+  CHECK_EQ(begin.size(), desc_.shape().size())
+      << ": Crop must begin at one index per dimension!";
+  CHECK_EQ(shape.size(), desc_.shape().size())
+      << ": Crop must have the rank of the tensor!";
+
+  std::byte *data = data_;
+  for (std::size_t i = 0; i < shape.size(); ++i) {
+    CHECK_LE(begin[i] + shape[i], desc_.shape()[i])
+        << ": Crop out of range at dimension " << i << "!";
+    data += begin[i] * desc_.strides()[i];
+  }
+  return Tensor(
+      TensorDescriptor::unchecked(desc_.dtype(), shape, desc_.strides()),
+      data);
+}
+
+Tensor Tensor::permute(const Dims &axes) const {
+  CHECK_EQ(axes.size(), desc_.shape().size())
+      << ": Permutation must have the rank of the tensor!";
+
+  Dims shape;
+  Dims strides;
+  std::size_t seen = 0;
+  for (std::size_t axis : axes) {
+    CHECK_LT(axis, desc_.shape().size()) << ": Dimension out of range!";
+    CHECK_EQ(seen & (std::size_t{1} << axis), 0)
+        << ": Dimension " << axis << " appears twice!";
+    seen |= std::size_t{1} << axis;
+    shape.push_back(desc_.shape()[axis]);
+    strides.push_back(desc_.strides()[axis]);
+  }
+  return Tensor(TensorDescriptor::unchecked(desc_.dtype(), shape, strides),
+                data_);
+}
+
+Tensor Tensor::transpose(std::size_t dim0, std::size_t dim1) const {
+  CHECK_LT(dim0, desc_.shape().size()) << ": Dimension out of range!";
+  CHECK_LT(dim1, desc_.shape().size()) << ": Dimension out of range!";
+
+  Dims shape = desc_.shape();
+  Dims strides = desc_.strides();
+  std::swap(shape[dim0], shape[dim1]);
+  std::swap(strides[dim0], strides[dim1]);
+  return Tensor(TensorDescriptor::unchecked(desc_.dtype(), shape, strides),
+                data_);
+}
+
+std::optional<Tensor> Tensor::reshape(const Dims &shape) const {
+  std::size_t nb_elements = 1;
+  for (std::size_t size : shape)
+    nb_elements *= size;
+  CHECK_EQ(shape.empty() ? 0 : nb_elements, desc_.nb_elements())
+      << ": Reshape must keep the number of elements!";
+
+  Dims strides;
+  for (std::size_t i = 0; i < shape.size(); ++i)
+    strides.push_back(0);
+
+  // The dimensions of size 1 can be left out, their stride does not matter.
+  Dims old_shape;
+  Dims old_strides;
+  for (std::size_t i = 0; i < desc_.shape().size(); ++i) {
+    if (desc_.shape()[i] != 1) {
+      old_shape.push_back(desc_.shape()[i]);
+      old_strides.push_back(desc_.strides()[i]);
+    }
+  }
+
+  if (nb_elements == 0 || desc_.is_contiguous()) {
+    std::size_t stride = desc_.type_size();
+    for (std::size_t i = shape.size(); i-- > 0;) {
+      strides[i] = stride;
+      stride *= std::max<std::size_t>(shape[i], 1);
+    }
+    return Tensor(TensorDescriptor::unchecked(desc_.dtype(), shape, strides),
+                  data_);
+  }
+
+  // Match groups of old dimensions with groups of new dimensions of the same
+  // number of elements. The old dimensions of a group must be mergeable, the
+  // new ones then split it with row-major strides.
+  std::size_t old_i = 0;
+  std::size_t new_i = 0;
+  while (old_i < old_shape.size() && new_i < shape.size()) {
+    std::size_t old_end = old_i + 1;
+    std::size_t new_end = new_i + 1;
+    std::size_t old_size = old_shape[old_i];
+    std::size_t new_size = shape[new_i];
+    while (old_size != new_size) {
+      if (new_size < old_size)
+        new_size *= shape[new_end++];
+      else
+        old_size *= old_shape[old_end++];
+    }
+
+    for (std::size_t i = old_i; i + 1 < old_end; ++i) {
+      if (old_strides[i] != old_shape[i + 1] * old_strides[i + 1])
+        return std::nullopt;
+    }
+
+    strides[new_end - 1] = old_strides[old_end - 1];
+    for (std::size_t i = new_end - 1; i > new_i; --i)
+      strides[i - 1] = strides[i] * shape[i];
+
+    old_i = old_end;
+    new_i = new_end;
+  }
+
+  // Trailing dimensions of size 1.
+  for (; new_i < shape.size(); ++new_i)
+    strides[new_i] = desc_.type_size();
+
+  return Tensor(TensorDescriptor::unchecked(desc_.dtype(), shape, strides),
+                data_);
+}
+
+Tensor Tensor::broadcast(const Dims &shape) const {
+  CHECK_GE(shape.size(), desc_.shape().size())
+      << ": Cannot broadcast to a lower rank!";
+
+  Dims strides;
+  std::size_t offset = shape.size() - desc_.shape().size();
+  for (std::size_t i = 0; i < shape.size(); ++i) {
+    if (i < offset) {
+      strides.push_back(0);
+      continue;
+    }
+
+    std::size_t size = desc_.shape()[i - offset];
+    CHECK(size == shape[i] || size == 1)
+        << ": Cannot broadcast dimension " << i - offset << " of size "
+        << size << " to " << shape[i] << "!";
+    strides.push_back(size == shape[i] ? desc_.strides()[i - offset] : 0);
+  }
+  return Tensor(TensorDescriptor::unchecked(desc_.dtype(), shape, strides),
+                data_);
+}
+
 } // namespace holoflow
@@ -0,0 +1,82 @@
+#include "holoflow/tensor/tensor_queue.hh"
+
+#include <utility>
+
+namespace holoflow {
+namespace {
+/// Returns the descriptor of `batch_size` frames laid out back to back.
+TensorDescriptor batched(const TensorDescriptor &frame, size_t batch_size) {
+  Dims shape = {batch_size};
+  Dims strides = {frame.size_in_bytes()};
+  for (size_t i = 0; i < frame.shape().size(); i++) {
+    shape.push_back(frame.shape()[i]);
+    strides.push_back(frame.strides()[i]);
+  }
+  return TensorDescriptor(frame.dtype(), shape, strides);
+}
+} // namespace
+
+TensorQueue::TensorQueue(const TensorDescriptor &frame, size_t nb_slots,
+                         size_t enqueue_batch_size, size_t dequeue_batch_size,
+                         uint8_t *buffer)
+    : frame_(frame), queue_(nb_slots, enqueue_batch_size, dequeue_batch_size,
+                            frame.size_in_bytes(), buffer),
+      write_tensor_(batched(frame, enqueue_batch_size), nullptr),
+      read_tensor_(batched(frame, dequeue_batch_size), nullptr) {}
+
+TensorQueue::TensorQueue(const TensorDescriptor &frame, size_t nb_slots,
+                         size_t enqueue_batch_size, size_t dequeue_batch_size,
+                         QueueBuffer buffer)
+    : frame_(frame), queue_(nb_slots, enqueue_batch_size, dequeue_batch_size,
+                            frame.size_in_bytes(), std::move(buffer)),
+      write_tensor_(batched(frame, enqueue_batch_size), nullptr),
+      read_tensor_(batched(frame, dequeue_batch_size), nullptr) {}
+
+Tensor *TensorQueue::write_tensor() {
+  return bind(write_tensor_, queue_.enqueue_batch_size(), queue_.write_ptr());
+}
+
+Tensor *TensorQueue::wait_write_tensor() {
+  return bind(write_tensor_, queue_.enqueue_batch_size(),
+              queue_.wait_write_ptr());
+}
+
+Tensor *TensorQueue::wait_write_tensor(std::chrono::nanoseconds timeout) {
+  return bind(write_tensor_, queue_.enqueue_batch_size(),
+              queue_.wait_write_ptr(timeout));
+}
+
+void TensorQueue::commit_write() { queue_.commit_write(); }
+
+const Tensor *TensorQueue::read_tensor() {
+  return bind(read_tensor_, queue_.dequeue_batch_size(), queue_.read_ptr());
+}
+
+const Tensor *TensorQueue::wait_read_tensor() {
+  return bind(read_tensor_, queue_.dequeue_batch_size(),
+              queue_.wait_read_ptr());
+}
+
+const Tensor *TensorQueue::wait_read_tensor(std::chrono::nanoseconds timeout) {
+  return bind(read_tensor_, queue_.dequeue_batch_size(),
+              queue_.wait_read_ptr(timeout));
+}
+
+void TensorQueue::commit_read() { queue_.commit_read(); }
+
+const TensorDescriptor &TensorQueue::frame() const { return frame_; }
+
+BatchedSPSCQueue &TensorQueue::queue() { return queue_; }
+
+Tensor *TensorQueue::bind(Tensor &tensor, size_t batch_size, uint8_t *data) {
+  if (!data)
+    return nullptr;
+
+  // The batch size only changes when the queue is reconfigured.
+  if (tensor.desc().shape().front() != batch_size)
+    tensor = Tensor(batched(frame_, batch_size), nullptr);
+  tensor.rebind(reinterpret_cast<std::byte *>(data));
+  return &tensor;
+}
+
+} // namespace holoflow
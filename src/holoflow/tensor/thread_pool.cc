@@ -0,0 +1,95 @@
+#include "holoflow/tensor/thread_pool.hh"
+
+#include <algorithm>
+
+namespace holoflow {
+
+ThreadPool::ThreadPool(std::size_t nb_threads) {
+  if (nb_threads == 0)
+    nb_threads = std::max(1u, std::thread::hardware_concurrency());
+
+  workers_.reserve(nb_threads - 1);
+  for (std::size_t i = 0; i + 1 < nb_threads; ++i)
+    workers_.emplace_back(&ThreadPool::work, this);
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard lock(mutex_);
+    stopping_ = true;
+  }
+  batch_started_.notify_all();
+  for (std::thread &worker : workers_)
+    worker.join();
+}
+
+std::size_t ThreadPool::size() const { return workers_.size() + 1; }
+
+void ThreadPool::parallel_for(std::size_t nb_tasks,
+                              const std::function<void(std::size_t)> &task) {
+  if (nb_tasks == 0)
+    return;
+  if (workers_.empty() || nb_tasks == 1) {
+    for (std::size_t i = 0; i < nb_tasks; ++i)
+      task(i);
+    return;
+  }
+
+  std::lock_guard batch_lock(batch_mutex_);
+  {
+    std::lock_guard lock(mutex_);
+    task_ = &task;
+    nb_tasks_ = nb_tasks;
+    next_task_.store(0, std::memory_order_relaxed);
+    done_tasks_.store(0, std::memory_order_relaxed);
+    ++generation_;
+  }
+  batch_started_.notify_all();
+
+  run_tasks();
+
+  // The workers still in the batch may be about to claim a task, so the batch
+  // only ends once they have all left it.
+  std::unique_lock lock(mutex_);
+  batch_done_.wait(lock, [&] {
+    return done_tasks_.load(std::memory_order_acquire) == nb_tasks &&
+           busy_workers_ == 0;
+  });
+  task_ = nullptr;
+}
+
+void ThreadPool::work() {
+  std::size_t generation = 0;
+  while (true) {
+    {
+      std::unique_lock lock(mutex_);
+      batch_started_.wait(lock, [&] {
+        return stopping_ || (generation_ != generation && task_ != nullptr);
+      });
+      if (stopping_)
+        return;
+      generation = generation_;
+      ++busy_workers_;
+    }
+
+    run_tasks();
+
+    {
+      std::lock_guard lock(mutex_);
+      --busy_workers_;
+    }
+    batch_done_.notify_all();
+  }
+}
+
+void ThreadPool::run_tasks() {
+  while (true) {
+    std::size_t i = next_task_.fetch_add(1, std::memory_order_relaxed);
+    if (i >= nb_tasks_)
+      return;
+    (*task_)(i);
+    done_tasks_.fetch_add(1, std::memory_order_release);
+  }
+}
+
+} // namespace holoflow
@@ -0,0 +1,279 @@
+#include "queue_io/disk_recorder.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace holoflow {
+namespace {
+/// Throws the `std::system_error` matching `errno`.
+[[noreturn]] void throw_errno(const char *what) {
+  throw std::system_error(errno, std::generic_category(), what);
+}
+
+/// Rounds `size` up to a multiple of `alignment`.
+size_t round_up(size_t size, size_t alignment) {
+  return (size + alignment - 1) / alignment * alignment;
+}
+} // namespace
+
+DiskRecorder::DiskRecorder(BatchedSPSCQueue &queue, const std::string &path,
+                           const RecorderOptions &options)
+    : queue_(queue), options_(options), fd_(-1), direct_io_(false),
+      context_(0),
+      batch_bytes_(queue.dequeue_batch_size() * queue.element_size()),
+      zero_copy_(batch_bytes_ % DIRECT_IO_ALIGNMENT == 0),
+      events_(options.max_in_flight),
+      staging_size_(round_up(options.write_size, DIRECT_IO_ALIGNMENT)),
+      staging_busy_(options.max_in_flight, false) {
+  if (options.write_size == 0)
+    throw std::invalid_argument("The write size must not be zero");
+  if (options.max_in_flight == 0)
+    throw std::invalid_argument("At least one write must be in flight");
+
+  staging_ = QueueBuffer::allocate(staging_size_ * options.max_in_flight);
+
+  // Most file systems accept `O_DIRECT`, the others refuse it at open time.
+  int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+  if (options.direct_io) {
+    fd_ = open(path.c_str(), flags | O_DIRECT, 0644);
+    direct_io_ = fd_ >= 0;
+  }
+  if (fd_ < 0)
+    fd_ = open(path.c_str(), flags, 0644);
+  if (fd_ < 0)
+    throw_errno("open");
+
+  // Reserve the extents without changing the size of the file, which only
+  // grows with the data written.
+  if (options.preallocate > 0 &&
+      fallocate(fd_, FALLOC_FL_KEEP_SIZE, 0,
+                static_cast<off_t>(options.preallocate)) != 0 &&
+      errno != EOPNOTSUPP) {
+    int error = errno;
+    close(fd_);
+    throw std::system_error(error, std::generic_category(), "fallocate");
+  }
+
+  if (syscall(SYS_io_setup, options.max_in_flight, &context_) != 0) {
+    int error = errno;
+    close(fd_);
+    throw std::system_error(error, std::generic_category(), "io_setup");
+  }
+}
+
+DiskRecorder::~DiskRecorder() {
+  try {
+    finish();
+  } catch (const std::system_error &) {
+  }
+  // Waits for the writes still in flight after a failure.
+  syscall(SYS_io_destroy, context_);
+  close(fd_);
+}
+
+bool DiskRecorder::poll() {
+  if (finished_)
+    return false;
+
+  reap(in_flight_.size() >= options_.max_in_flight);
+
+  // Read the closed flag before looking for batches, so that a batch committed
+  // right before `close()` is not missed.
+  bool closed = queue_.is_closed();
+  if (zero_copy_ ? submit_batches() : stage_batch())
+    return true;
+  if (!closed)
+    return true;
+
+  // The batches in flight must be committed before the queue is read past
+  // them.
+  while (!in_flight_.empty())
+    reap(true);
+
+  size_t count = 0;
+  while (const uint8_t *data = queue_.read_ptr_partial(count)) {
+    stage(data, count * queue_.element_size());
+    queue_.commit_read_partial(count);
+  }
+  finish();
+  return false;
+}
+
+void DiskRecorder::run() {
+  while (poll()) {
+  }
+}
+
+void DiskRecorder::finish() {
+  if (finished_)
+    return;
+
+  if (staging_current_ >= 0 && staging_fill_ > 0)
+    submit_staging();
+  while (!in_flight_.empty())
+    reap(true);
+
+  // Drop the padding of the last write, and the preallocated extents past it.
+  if (ftruncate(fd_, static_cast<off_t>(bytes_submitted_)) != 0)
+    throw_errno("ftruncate");
+  finished_ = true;
+}
+
+RecorderStats DiskRecorder::stats() const {
+  RecorderStats stats;
+  stats.bytes_written = bytes_written_;
+  if (bytes_written_ > 0)
+    stats.elapsed = last_completion_ - first_write_;
+  stats.direct_io = direct_io_;
+  stats.zero_copy = zero_copy_;
+  return stats;
+}
+
+bool DiskRecorder::submit_batches() {
+  if (in_flight_.size() >= options_.max_in_flight)
+    return false;
+
+  // The batches in flight are still at the front of the queue, the new write
+  // starts right after them.
+  size_t batches_per_write =
+      std::max<size_t>(options_.write_size / batch_bytes_, 1);
+  std::span<uint8_t> span =
+      queue_.read_span(pending_batches_ + batches_per_write);
+  size_t nb_batches = span.size() / batch_bytes_;
+  if (nb_batches <= pending_batches_)
+    return false;
+
+  const uint8_t *data = span.data() + pending_batches_ * batch_bytes_;
+  if (reinterpret_cast<uintptr_t>(data) % DIRECT_IO_ALIGNMENT != 0) {
+    // Not an aligned buffer: copy the batches instead, once the ones in flight
+    // are committed.
+    if (in_flight_.empty())
+      zero_copy_ = false;
+    return false;
+  }
+
+  nb_batches -= pending_batches_;
+  submit(data, nb_batches * batch_bytes_, nb_batches * batch_bytes_,
+         nb_batches, -1);
+  pending_batches_ += nb_batches;
+  return true;
+}
+
+bool DiskRecorder::stage_batch() {
+  const uint8_t *batch = queue_.read_ptr();
+  if (!batch)
+    return false;
+
+  stage(batch, batch_bytes_);
+  queue_.commit_read();
+  return true;
+}
+
+void DiskRecorder::stage(const uint8_t *data, size_t size) {
+  while (size > 0) {
+    while (staging_current_ < 0) {
+      auto idle =
+          std::find(staging_busy_.begin(), staging_busy_.end(), false);
+      if (idle != staging_busy_.end())
+        staging_current_ = static_cast<int>(idle - staging_busy_.begin());
+      else
+        reap(true);
+    }
+
+    size_t n = std::min(size, staging_size_ - staging_fill_);
+    std::memcpy(staging_.data() + staging_current_ * staging_size_ +
+                    staging_fill_,
+                data, n);
+    staging_fill_ += n;
+    data += n;
+    size -= n;
+
+    if (staging_fill_ == staging_size_)
+      submit_staging();
+  }
+}
+
+void DiskRecorder::submit_staging() {
+  // Only the last write of the file can be partial, `finish()` truncates its
+  // padding.
+  uint8_t *data = staging_.data() + staging_current_ * staging_size_;
+  size_t size = round_up(staging_fill_, DIRECT_IO_ALIGNMENT);
+  std::memset(data + staging_fill_, 0, size - staging_fill_);
+
+  staging_busy_[staging_current_] = true;
+  submit(data, size, staging_fill_, 0, staging_current_);
+  staging_current_ = -1;
+  staging_fill_ = 0;
+}
+
+void DiskRecorder::submit(const uint8_t *data, size_t size, size_t payload,
+                          size_t nb_batches, int staging) {
+  iocb request{};
+  request.aio_data = next_id_;
+  request.aio_lio_opcode = IOCB_CMD_PWRITE;
+  request.aio_fildes = static_cast<uint32_t>(fd_);
+  request.aio_buf = reinterpret_cast<uintptr_t>(data);
+  request.aio_nbytes = size;
+  request.aio_offset = static_cast<int64_t>(file_offset_);
+
+  iocb *requests[] = {&request};
+  if (syscall(SYS_io_submit, context_, 1, requests) != 1)
+    throw_errno("io_submit");
+
+  if (next_id_ == 0)
+    first_write_ = std::chrono::steady_clock::now();
+  in_flight_.push_back({next_id_++, size, payload, nb_batches, staging, false});
+  file_offset_ += size;
+  bytes_submitted_ += payload;
+}
+
+void DiskRecorder::reap(bool wait) {
+  if (in_flight_.empty())
+    return;
+
+  long nb_events = syscall(SYS_io_getevents, context_, wait ? 1 : 0,
+                           events_.size(), events_.data(), nullptr);
+  if (nb_events < 0) {
+    if (errno == EINTR)
+      return;
+    throw_errno("io_getevents");
+  }
+
+  for (long i = 0; i < nb_events; i++) {
+    const io_event &event = events_[i];
+    auto write = std::find_if(
+        in_flight_.begin(), in_flight_.end(),
+        [&event](const Write &write) { return write.id == event.data; });
+    if (event.res < 0)
+      throw std::system_error(static_cast<int>(-event.res),
+                              std::generic_category(), "write");
+    if (static_cast<size_t>(event.res) != write->size)
+      throw std::system_error(EIO, std::generic_category(), "short write");
+    write->done = true;
+  }
+
+  // Batches are committed in order, a write that completed early waits for
+  // the ones before it.
+  while (!in_flight_.empty() && in_flight_.front().done) {
+    const Write &write = in_flight_.front();
+    if (write.staging >= 0) {
+      staging_busy_[write.staging] = false;
+    } else {
+      queue_.commit_read(write.nb_batches);
+      pending_batches_ -= write.nb_batches;
+    }
+    bytes_written_ += write.payload;
+    last_completion_ = std::chrono::steady_clock::now();
+    in_flight_.pop_front();
+  }
+}
+
+} // namespace holoflow
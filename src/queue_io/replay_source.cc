@@ -0,0 +1,176 @@
+#include "queue_io/replay_source.hh"
+#include "batched_spsc_queue/queue_buffer.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace holoflow {
+namespace {
+/// Throws the `std::system_error` matching `errno`.
+[[noreturn]] void throw_errno(const char *what) {
+  throw std::system_error(errno, std::generic_category(), what);
+}
+
+/// Closes a file descriptor when going out of scope.
+struct FdGuard {
+  int fd;
+  ~FdGuard() { close(fd); }
+};
+
+/// Rounds `size` up to a multiple of `alignment`.
+size_t round_up(size_t size, size_t alignment) {
+  return (size + alignment - 1) / alignment * alignment;
+}
+} // namespace
+
+ReplaySource::ReplaySource(BatchedSPSCQueue &queue, const std::string &path,
+                           const ReplayOptions &options)
+    : queue_(queue), options_(options), data_(nullptr), size_(0),
+      frame_size_(options.zero_copy ? options.frame_size
+                                    : queue.element_size()),
+      nb_frames_(0) {
+  if (options.pacing == ReplayPacing::FixedRate && !(options.fps > 0))
+    throw std::invalid_argument("The frame rate must be positive");
+  if (options.pacing == ReplayPacing::Timestamps && !options.timestamp)
+    throw std::invalid_argument("Replaying timestamps needs a timestamp "
+                                "function");
+  if (options.zero_copy && queue.element_size() != sizeof(const uint8_t *))
+    throw std::invalid_argument("The elements of a zero-copy queue must be "
+                                "pointers");
+  if (frame_size_ == 0)
+    throw std::invalid_argument("The frame size must not be zero");
+
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    throw_errno("open");
+  FdGuard guard{fd};
+
+  struct stat st;
+  if (fstat(fd, &st) != 0)
+    throw_errno("fstat");
+  size_ = static_cast<size_t>(st.st_size);
+  nb_frames_ = size_ / frame_size_;
+  if (size_ == 0)
+    return;
+
+  void *data = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED)
+    throw_errno("mmap");
+  data_ = static_cast<const uint8_t *>(data);
+
+  // Sequential advice doubles the read-ahead window and lets the kernel drop
+  // the pages behind the producer first.
+  madvise(data, size_, MADV_SEQUENTIAL);
+  prefetch();
+}
+
+ReplaySource::~ReplaySource() {
+  if (data_)
+    munmap(const_cast<uint8_t *>(data_), size_);
+}
+
+bool ReplaySource::poll() {
+  if (done_)
+    return false;
+  if (!started_) {
+    start_ = std::chrono::steady_clock::now();
+    started_ = true;
+  }
+
+  if (next_frame_ + queue_.enqueue_batch_size() > nb_frames_) {
+    queue_.close();
+    done_ = true;
+    return false;
+  }
+  if (std::chrono::steady_clock::now() < deadline())
+    return true;
+
+  if (uint8_t *write_ptr = queue_.write_ptr())
+    enqueue(write_ptr);
+  return true;
+}
+
+void ReplaySource::run() {
+  if (!started_) {
+    start_ = std::chrono::steady_clock::now();
+    started_ = true;
+  }
+
+  while (next_frame_ + queue_.enqueue_batch_size() <= nb_frames_) {
+    std::this_thread::sleep_until(deadline());
+    enqueue(queue_.wait_write_ptr());
+  }
+  if (!done_) {
+    queue_.close();
+    done_ = true;
+  }
+}
+
+size_t ReplaySource::nb_frames() const { return nb_frames_; }
+
+size_t ReplaySource::frames_replayed() const { return next_frame_; }
+
+const uint8_t *ReplaySource::frame(const uint8_t *element) {
+  const uint8_t *frame;
+  std::memcpy(&frame, element, sizeof(frame));
+  return frame;
+}
+
+std::chrono::steady_clock::time_point ReplaySource::deadline() const {
+  size_t last = next_frame_ + queue_.enqueue_batch_size() - 1;
+  switch (options_.pacing) {
+  case ReplayPacing::FixedRate:
+    return start_ + std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::duration<double>(last / options_.fps));
+  case ReplayPacing::Timestamps:
+    return start_ + (options_.timestamp(data_ + last * frame_size_) -
+                     options_.timestamp(data_));
+  default:
+    return start_;
+  }
+}
+
+void ReplaySource::enqueue(uint8_t *write_ptr) {
+  // The queue may switch to a new batch size when the batch is committed.
+  size_t batch_size = queue_.enqueue_batch_size();
+  const uint8_t *first = data_ + next_frame_ * frame_size_;
+  if (options_.zero_copy) {
+    for (size_t i = 0; i < batch_size; i++) {
+      const uint8_t *frame = first + i * frame_size_;
+      std::memcpy(write_ptr + i * sizeof(frame), &frame, sizeof(frame));
+    }
+  } else {
+    std::memcpy(write_ptr, first, batch_size * frame_size_);
+  }
+  queue_.commit_write();
+
+  next_frame_ += batch_size;
+  prefetch();
+}
+
+void ReplaySource::prefetch() {
+  // Keep at least half of the window ahead of the producer, in large enough
+  // requests.
+  size_t position = next_frame_ * frame_size_;
+  if (position + options_.prefetch / 2 < prefetched_ || prefetched_ >= size_)
+    return;
+
+  size_t end = round_up(std::min(position + options_.prefetch, size_),
+                        QueueBuffer::page_size());
+  if (end <= prefetched_)
+    return;
+  madvise(const_cast<uint8_t *>(data_) + prefetched_, end - prefetched_,
+          MADV_WILLNEED);
+  prefetched_ = end;
+}
+
+} // namespace holoflow
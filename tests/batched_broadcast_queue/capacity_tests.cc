@@ -0,0 +1,182 @@
+#include "batched_broadcast_queue/batched_broadcast_queue.hh"
+
+#include <cstdint>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace holoflow {
+class BatchedBroadcastQueueCapacityTest
+    : public ::testing::TestWithParam<std::tuple<size_t, size_t, size_t>> {};
+
+TEST_P(BatchedBroadcastQueueCapacityTest, Slowest_Consumer_Bounds_Capacity) {
+  // Test parameters.
+  auto [nb_slots, enqueue_batch_size, dequeue_batch_size] = GetParam();
+
+  // Check predicates to avoid undefined behavior as specified in the
+  // BatchedBroadcastQueue documentation.
+  if (nb_slots % enqueue_batch_size != 0)
+    FAIL() << "nb_slots % enqueue_batch_size != 0";
+
+  if (nb_slots % dequeue_batch_size != 0)
+    FAIL() << "nb_slots % dequeue_batch_size != 0";
+
+  // Prepare the buffer.
+  size_t element_size = sizeof(uint8_t);
+  std::vector<uint8_t> buffer(nb_slots * element_size);
+
+  // Shift the internal positions by every possible amount.
+  for (size_t i = 0; i < nb_slots * 2; i++) {
+    BatchedBroadcastQueue queue(nb_slots, enqueue_batch_size, element_size,
+                                buffer.data(),
+                                {{dequeue_batch_size}, {enqueue_batch_size}});
+    for (size_t j = 0; j < i; j++) {
+      for (size_t k = 0; k < dequeue_batch_size; k++) {
+        ASSERT_TRUE(queue.write_ptr());
+        queue.commit_write();
+      }
+      for (size_t k = 0; k < enqueue_batch_size; k++) {
+        ASSERT_TRUE(queue.read_ptr(0));
+        ASSERT_TRUE(queue.commit_read(0));
+      }
+      for (size_t k = 0; k < dequeue_batch_size; k++) {
+        ASSERT_TRUE(queue.read_ptr(1));
+        ASSERT_TRUE(queue.commit_read(1));
+      }
+    }
+    ASSERT_EQ(queue.size(0), 0);
+    ASSERT_EQ(queue.size(1), 0);
+
+    // The whole buffer can be used.
+    for (size_t j = 0; j < nb_slots / enqueue_batch_size; j++) {
+      ASSERT_TRUE(queue.write_ptr());
+      queue.commit_write();
+    }
+    ASSERT_FALSE(queue.write_ptr());
+
+    // The first consumer reading everything is not enough to free space.
+    for (size_t j = 0; j < nb_slots / dequeue_batch_size; j++) {
+      ASSERT_TRUE(queue.read_ptr(0));
+      ASSERT_TRUE(queue.commit_read(0));
+    }
+    ASSERT_FALSE(queue.read_ptr(0));
+    ASSERT_FALSE(queue.write_ptr());
+    ASSERT_EQ(queue.size(1), nb_slots);
+
+    // Both consumers read the same elements.
+    for (size_t j = 0; j < nb_slots / enqueue_batch_size; j++) {
+      ASSERT_TRUE(queue.read_ptr(1));
+      ASSERT_TRUE(queue.commit_read(1));
+    }
+    ASSERT_FALSE(queue.read_ptr(1));
+    ASSERT_TRUE(queue.write_ptr());
+  }
+}
+
+TEST(BatchedBroadcastQueueLossyTest, Lossy_Consumer_Does_Not_Block) {
+  std::vector<uint8_t> buffer(16);
+  BatchedBroadcastQueue queue(16, 2, sizeof(uint8_t), buffer.data(),
+                              {{4}, {4, true}});
+
+  // Write 32 elements, the first consumer keeps up, the lossy one never reads.
+  for (uint8_t i = 0; i < 32; i += 2) {
+    uint8_t *write_ptr = queue.write_ptr();
+    ASSERT_TRUE(write_ptr);
+    write_ptr[0] = i;
+    write_ptr[1] = i + 1;
+    queue.commit_write();
+
+    if (i % 4 == 2) {
+      ASSERT_TRUE(queue.read_ptr(0));
+      ASSERT_TRUE(queue.commit_read(0));
+    }
+  }
+  EXPECT_EQ(queue.size(0), 0);
+
+  // The lossy consumer skips to the latest complete batch.
+  uint8_t *read_ptr = queue.read_ptr(1);
+  ASSERT_TRUE(read_ptr);
+  EXPECT_EQ(read_ptr[0], 28);
+  EXPECT_EQ(queue.skipped(1), 28);
+  EXPECT_TRUE(queue.commit_read(1));
+  EXPECT_FALSE(queue.read_ptr(1));
+
+  // A batch overwritten while being read is reported.
+  for (size_t i = 0; i < 4; i++) {
+    ASSERT_TRUE(queue.write_ptr());
+    queue.commit_write();
+  }
+  for (size_t i = 0; i < 2; i++) {
+    ASSERT_TRUE(queue.read_ptr(0));
+    ASSERT_TRUE(queue.commit_read(0));
+  }
+  ASSERT_TRUE(queue.read_ptr(1));
+  for (size_t i = 0; i < 5; i++) {
+    ASSERT_TRUE(queue.write_ptr());
+    queue.commit_write();
+  }
+  EXPECT_FALSE(queue.commit_read(1));
+}
+
+TEST(BatchedBroadcastQueueLossyTest, Lapped_Consumer_Lands_On_Latest_Batch) {
+  std::vector<uint8_t> buffer(16);
+  BatchedBroadcastQueue queue(16, 2, sizeof(uint8_t), buffer.data(),
+                              {{4}, {4, true}});
+  uint8_t value = 0;
+
+  auto write = [&queue, &value](size_t nb_batches) {
+    for (size_t i = 0; i < nb_batches; i++) {
+      uint8_t *write_ptr = queue.write_ptr();
+      ASSERT_TRUE(write_ptr);
+      write_ptr[0] = value++;
+      write_ptr[1] = value++;
+      queue.commit_write();
+      if (value % 4 == 0) {
+        ASSERT_TRUE(queue.read_ptr(0));
+        ASSERT_TRUE(queue.commit_read(0));
+      }
+    }
+  };
+
+  // The lossy consumer reads the first of two batches, so it still sees the
+  // second one as available.
+  write(4);
+  uint8_t *read_ptr = queue.read_ptr(1);
+  ASSERT_TRUE(read_ptr);
+  EXPECT_EQ(read_ptr[0], 0);
+  EXPECT_TRUE(queue.commit_read(1));
+
+  // The producer laps it three times before its next read.
+  write(26);
+  read_ptr = queue.read_ptr(1);
+  ASSERT_TRUE(read_ptr);
+  EXPECT_EQ(read_ptr[0], 56);
+  EXPECT_EQ(queue.skipped(1), 52);
+  EXPECT_TRUE(queue.commit_read(1));
+  EXPECT_FALSE(queue.read_ptr(1));
+}
+
+INSTANTIATE_TEST_SUITE_P(BatchedBroadcastQueueCapacityTestSuite,
+                         BatchedBroadcastQueueCapacityTest,
+                         ::testing::Values(
+                             // 00
+                             std::make_tuple(100, // nb_slots
+                                             1,   // enqueue_batch_size
+                                             1),  // dequeue_batch_size
+                             // 01
+                             std::make_tuple(100, // nb_slots
+                                             1,   // enqueue_batch_size
+                                             2),  // dequeue_batch_size
+                             // 02
+                             std::make_tuple(100, // nb_slots
+                                             2,   // enqueue_batch_size
+                                             1),  // dequeue_batch_size
+                             // 03
+                             std::make_tuple(102, // nb_slots
+                                             3,   // enqueue_batch_size
+                                             2),  // dequeue_batch_size
+                             // 04
+                             std::make_tuple(105,  // nb_slots
+                                             5,    // enqueue_batch_size
+                                             3))); // dequeue_batch_size
+} // namespace holoflow
@@ -0,0 +1,140 @@
+#include "batched_broadcast_queue/batched_broadcast_queue.hh"
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace holoflow {
+class BatchedBroadcastQueueMultiThreadingTest
+    : public ::testing::TestWithParam<
+          std::tuple<std::chrono::seconds, std::chrono::microseconds,
+                     std::chrono::microseconds, size_t, size_t, size_t,
+                     size_t>> {};
+
+TEST_P(BatchedBroadcastQueueMultiThreadingTest, MT) {
+  // Test parameters.
+  auto [test_duration, enqueue_delay, lossy_delay, nb_slots,
+        enqueue_batch_size, dequeue_batch_size, lossy_batch_size] = GetParam();
+
+  // Create the queue. Two consumers must see every element, a third one is
+  // lossy and slower.
+  size_t element_size = sizeof(uint32_t);
+  size_t buffer_size = nb_slots * element_size;
+  std::vector<uint8_t> buffer(buffer_size);
+  std::vector<BroadcastConsumerOptions> consumers = {
+      {dequeue_batch_size}, {enqueue_batch_size}, {lossy_batch_size, true}};
+  BatchedBroadcastQueue queue(nb_slots, enqueue_batch_size, element_size,
+                              buffer.data(), consumers);
+
+  // Enqueue thread.
+  std::thread enqueue_thread([&queue, test_duration,
+                              enqueue_batch_size = enqueue_batch_size,
+                              enqueue_delay = enqueue_delay]() {
+    auto start_time = std::chrono::steady_clock::now();
+    uint32_t counter = 0;
+
+    // Loop for the specified duration.
+    while (std::chrono::steady_clock::now() - start_time < test_duration) {
+      // Try to get a write pointer.
+      auto write_ptr = queue.write_ptr();
+      if (!write_ptr)
+        continue;
+
+      // Write data to the buffer.
+      for (size_t j = 0; j < enqueue_batch_size; j++, counter++)
+        std::memcpy(write_ptr + j * sizeof(uint32_t), &counter,
+                    sizeof(uint32_t));
+
+      // Commit the write.
+      queue.commit_write();
+
+      // Sleep for the specified duration.
+      if (enqueue_delay.count())
+        std::this_thread::sleep_for(enqueue_delay);
+    }
+  });
+
+  // Dequeue threads.
+  std::vector<std::thread> dequeue_threads;
+  for (size_t consumer = 0; consumer < consumers.size(); consumer++) {
+    dequeue_threads.emplace_back([&queue, &consumers, consumer, test_duration,
+                                  lossy_delay = lossy_delay]() {
+      auto start_time = std::chrono::steady_clock::now();
+      size_t batch_size = consumers[consumer].dequeue_batch_size;
+      bool lossy = consumers[consumer].lossy;
+      std::vector<uint32_t> batch(batch_size);
+      uint32_t expected = 0;
+
+      // Loop for the specified duration.
+      while (std::chrono::steady_clock::now() - start_time < test_duration) {
+        // Try to get a read pointer.
+        auto read_ptr = queue.read_ptr(consumer);
+        if (!read_ptr)
+          continue;
+
+        std::memcpy(batch.data(), read_ptr, batch_size * sizeof(uint32_t));
+
+        // Sleep while holding the batch, so that the producer may overwrite
+        // it.
+        if (lossy && lossy_delay.count())
+          std::this_thread::sleep_for(lossy_delay);
+
+        // Commit the read, a lossy consumer discards an overwritten batch.
+        if (!queue.commit_read(consumer)) {
+          ASSERT_TRUE(lossy);
+          continue;
+        }
+
+        // Non-lossy consumers see every element, lossy ones may skip some.
+        if (lossy)
+          ASSERT_GE(batch[0], expected);
+        else
+          ASSERT_EQ(batch[0], expected);
+        for (size_t j = 1; j < batch_size; j++)
+          ASSERT_EQ(batch[j], batch[0] + j);
+        expected = batch[0] + batch_size;
+      }
+
+      // Drain what is left so that the producer never waits on a full queue.
+      while (queue.read_ptr(consumer))
+        queue.commit_read(consumer);
+    });
+  }
+
+  enqueue_thread.join();
+  for (auto &thread : dequeue_threads)
+    thread.join();
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    BatchedBroadcastQueueTestSuite, BatchedBroadcastQueueMultiThreadingTest,
+    ::testing::Values(
+        // 00
+        std::make_tuple(std::chrono::seconds(2),      // test_duration
+                        std::chrono::microseconds(0), // enqueue_delay
+                        std::chrono::microseconds(0), // lossy_delay
+                        3000,                         // nb_slots
+                        2,                            // enqueue_batch_size
+                        3,                            // dequeue_batch_size
+                        10),                          // lossy_batch_size
+        // 01
+        std::make_tuple(std::chrono::seconds(2),      // test_duration
+                        std::chrono::microseconds(0), // enqueue_delay
+                        std::chrono::microseconds(5), // lossy_delay
+                        3000,                         // nb_slots
+                        10,                           // enqueue_batch_size
+                        1000,                         // dequeue_batch_size
+                        100),                         // lossy_batch_size
+        // 02
+        std::make_tuple(std::chrono::seconds(2),      // test_duration
+                        std::chrono::microseconds(1), // enqueue_delay
+                        std::chrono::microseconds(2), // lossy_delay
+                        3000,                         // nb_slots
+                        3,                            // enqueue_batch_size
+                        2,                            // dequeue_batch_size
+                        1000)));                      // lossy_batch_size
+} // namespace holoflow
@@ -0,0 +1,142 @@
+#include "batched_mpsc_queue/batched_mpsc_queue.hh"
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace holoflow {
+class BatchedMPSCQueueCapacityTest
+    : public ::testing::TestWithParam<std::tuple<size_t, size_t, size_t>> {};
+
+TEST_P(BatchedMPSCQueueCapacityTest, Capacity_Is_Respected) {
+  // Test parameters.
+  auto [nb_slots, enqueue_batch_size, dequeue_batch_size] = GetParam();
+
+  // Check predicates to avoid undefined behavior as specified in the
+  // BatchedMPSCQueue documentation.
+  if (nb_slots % enqueue_batch_size != 0)
+    FAIL() << "nb_slots % enqueue_batch_size != 0";
+
+  if (nb_slots % dequeue_batch_size != 0)
+    FAIL() << "nb_slots % dequeue_batch_size != 0";
+
+  // Prepare the buffer.
+  size_t element_size = sizeof(uint8_t);
+  std::vector<uint8_t> buffer(nb_slots * element_size);
+
+  // Shift the internal positions by every possible amount.
+  for (size_t i = 0; i < nb_slots * 2; i++) {
+    BatchedMPSCQueue queue(nb_slots, enqueue_batch_size, dequeue_batch_size,
+                           element_size, buffer.data());
+    for (size_t j = 0; j < i; j++) {
+      for (size_t k = 0; k < dequeue_batch_size; k++) {
+        uint8_t *write_ptr = queue.write_ptr();
+        ASSERT_TRUE(write_ptr);
+        queue.commit_write(write_ptr);
+      }
+      for (size_t k = 0; k < enqueue_batch_size; k++) {
+        ASSERT_TRUE(queue.read_ptr());
+        queue.commit_read();
+      }
+    }
+    ASSERT_EQ(queue.size(), 0);
+
+    // The whole buffer can be used.
+    for (size_t j = 0; j < nb_slots / enqueue_batch_size; j++) {
+      uint8_t *write_ptr = queue.write_ptr();
+      ASSERT_TRUE(write_ptr);
+      queue.commit_write(write_ptr);
+    }
+    ASSERT_FALSE(queue.write_ptr());
+    ASSERT_EQ(queue.size(), nb_slots);
+
+    for (size_t j = 0; j < nb_slots / dequeue_batch_size; j++) {
+      ASSERT_TRUE(queue.read_ptr());
+      queue.commit_read();
+    }
+    ASSERT_FALSE(queue.read_ptr());
+  }
+}
+
+TEST(BatchedMPSCQueueOrderTest, Out_Of_Order_Commits_Are_Read_In_Order) {
+  std::vector<uint8_t> buffer(12);
+  BatchedMPSCQueue queue(12, 2, 3, sizeof(uint8_t), buffer.data());
+
+  // Three producers reserve one batch each.
+  uint8_t *first = queue.write_ptr();
+  uint8_t *second = queue.write_ptr();
+  uint8_t *third = queue.write_ptr();
+  ASSERT_TRUE(first && second && third);
+  EXPECT_EQ(second, first + 2);
+  EXPECT_EQ(third, first + 4);
+
+  // The first dequeue batch overlaps the first two enqueue batches.
+  queue.commit_write(second);
+  EXPECT_FALSE(queue.read_ptr());
+  queue.commit_write(third);
+  EXPECT_FALSE(queue.read_ptr());
+  queue.commit_write(first);
+  EXPECT_EQ(queue.read_ptr(), first);
+  queue.commit_read();
+  EXPECT_EQ(queue.read_ptr(), first + 3);
+  queue.commit_read();
+  EXPECT_FALSE(queue.read_ptr());
+}
+
+TEST(BatchedMPSCQueueGeometryTest, Invalid_Geometries_Are_Rejected) {
+  std::vector<uint8_t> buffer(12);
+  EXPECT_THROW(BatchedMPSCQueue(12, 0, 3, sizeof(uint8_t), buffer.data()),
+               std::invalid_argument);
+  EXPECT_THROW(BatchedMPSCQueue(12, 2, 0, sizeof(uint8_t), buffer.data()),
+               std::invalid_argument);
+  EXPECT_THROW(BatchedMPSCQueue(12, 5, 3, sizeof(uint8_t), buffer.data()),
+               std::invalid_argument);
+  EXPECT_THROW(BatchedMPSCQueue(12, 2, 5, sizeof(uint8_t), buffer.data()),
+               std::invalid_argument);
+
+  // A single enqueue batch could be reserved again before it is read.
+  EXPECT_THROW(BatchedMPSCQueue(12, 12, 3, sizeof(uint8_t), buffer.data()),
+               std::invalid_argument);
+
+  // With two batches, a third reservation finds the queue full.
+  BatchedMPSCQueue queue(12, 6, 12, sizeof(uint8_t), buffer.data());
+  uint8_t *first = queue.write_ptr();
+  ASSERT_TRUE(first);
+  queue.commit_write(first);
+  uint8_t *second = queue.write_ptr();
+  ASSERT_TRUE(second);
+  queue.commit_write(second);
+  EXPECT_FALSE(queue.write_ptr());
+  EXPECT_EQ(queue.read_ptr(), first);
+}
+
+INSTANTIATE_TEST_SUITE_P(BatchedMPSCQueueCapacityTestSuite,
+                         BatchedMPSCQueueCapacityTest,
+                         ::testing::Values(
+                             // 00
+                             std::make_tuple(100, // nb_slots
+                                             1,   // enqueue_batch_size
+                                             1),  // dequeue_batch_size
+                             // 01
+                             std::make_tuple(100, // nb_slots
+                                             1,   // enqueue_batch_size
+                                             2),  // dequeue_batch_size
+                             // 02
+                             std::make_tuple(100, // nb_slots
+                                             2,   // enqueue_batch_size
+                                             1),  // dequeue_batch_size
+                             // 03
+                             std::make_tuple(102, // nb_slots
+                                             3,   // enqueue_batch_size
+                                             2),  // dequeue_batch_size
+                             // 04
+                             std::make_tuple(102, // nb_slots
+                                             2,   // enqueue_batch_size
+                                             3),  // dequeue_batch_size
+                             // 05
+                             std::make_tuple(105,  // nb_slots
+                                             5,    // enqueue_batch_size
+                                             3))); // dequeue_batch_size
+} // namespace holoflow
@@ -0,0 +1,157 @@
+#include "batched_mpsc_queue/batched_mpsc_queue.hh"
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace holoflow {
+
+/// The element enqueued by the producers: who wrote it and in which order.
+struct Element {
+  uint32_t producer;
+  uint32_t counter;
+};
+
+class BatchedMPSCQueueMultiThreadingTest
+    : public ::testing::TestWithParam<
+          std::tuple<std::chrono::seconds, std::chrono::microseconds,
+                     std::chrono::microseconds, size_t, size_t, size_t,
+                     size_t>> {};
+
+TEST_P(BatchedMPSCQueueMultiThreadingTest, MT) {
+  // Test parameters.
+  auto [test_duration, enqueue_delay, dequeue_delay, nb_producers, nb_slots,
+        enqueue_batch_size, dequeue_batch_size] = GetParam();
+
+  // Create the queue.
+  size_t element_size = sizeof(Element);
+  size_t buffer_size = nb_slots * element_size;
+  std::vector<uint8_t> buffer(buffer_size);
+  BatchedMPSCQueue queue(nb_slots, enqueue_batch_size, dequeue_batch_size,
+                         element_size, buffer.data());
+
+  // Enqueue threads.
+  std::vector<std::thread> enqueue_threads;
+  for (uint32_t producer = 0; producer < nb_producers; producer++) {
+    enqueue_threads.emplace_back([&queue, producer, test_duration,
+                                  enqueue_batch_size = enqueue_batch_size,
+                                  enqueue_delay = enqueue_delay]() {
+      auto start_time = std::chrono::steady_clock::now();
+      uint32_t counter = 0;
+
+      // Loop for the specified duration.
+      while (std::chrono::steady_clock::now() - start_time < test_duration) {
+        // Try to reserve a batch.
+        auto write_ptr = queue.write_ptr();
+        if (!write_ptr)
+          continue;
+
+        // Write data to the buffer.
+        for (size_t j = 0; j < enqueue_batch_size; j++) {
+          Element element{producer, counter++};
+          std::memcpy(write_ptr + j * sizeof(Element), &element,
+                      sizeof(Element));
+        }
+
+        // Commit the write.
+        queue.commit_write(write_ptr);
+
+        // Sleep for the specified duration.
+        if (enqueue_delay.count())
+          std::this_thread::sleep_for(enqueue_delay);
+      }
+    });
+  }
+
+  // Dequeue thread.
+  std::thread dequeue_thread([&queue, test_duration, nb_producers,
+                              enqueue_batch_size = enqueue_batch_size,
+                              dequeue_batch_size = dequeue_batch_size,
+                              dequeue_delay = dequeue_delay]() {
+    auto start_time = std::chrono::steady_clock::now();
+    std::vector<uint32_t> expected(nb_producers, 0);
+    size_t read = 0;
+    uint32_t batch_producer = 0;
+
+    // Loop for the specified duration.
+    while (std::chrono::steady_clock::now() - start_time < test_duration) {
+      // Try to get a read pointer.
+      auto read_ptr = queue.read_ptr();
+      if (!read_ptr)
+        continue;
+
+      // Each producer's elements come in order, and an enqueue batch only
+      // holds elements of one producer.
+      for (size_t j = 0; j < dequeue_batch_size; j++, read++) {
+        Element element;
+        std::memcpy(&element, read_ptr + j * sizeof(Element),
+                    sizeof(Element));
+        ASSERT_LT(element.producer, nb_producers);
+        ASSERT_EQ(element.counter, expected[element.producer]++);
+        if (read % enqueue_batch_size == 0)
+          batch_producer = element.producer;
+        ASSERT_EQ(element.producer, batch_producer);
+      }
+
+      // Commit the read.
+      queue.commit_read();
+
+      // Sleep for the specified duration.
+      if (dequeue_delay.count())
+        std::this_thread::sleep_for(dequeue_delay);
+    }
+
+    // Drain what is left so that no producer waits on a full queue.
+    while (true) {
+      auto read_ptr = queue.read_ptr();
+      if (!read_ptr)
+        break;
+      queue.commit_read();
+    }
+  });
+
+  for (auto &thread : enqueue_threads)
+    thread.join();
+  dequeue_thread.join();
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    BatchedMPSCQueueTestSuite, BatchedMPSCQueueMultiThreadingTest,
+    ::testing::Values(
+        // 00
+        std::make_tuple(std::chrono::seconds(2),      // test_duration
+                        std::chrono::microseconds(0), // enqueue_delay
+                        std::chrono::microseconds(0), // dequeue_delay
+                        2,                            // nb_producers
+                        3000,                         // nb_slots
+                        2,                            // enqueue_batch_size
+                        3),                           // dequeue_batch_size
+        // 01
+        std::make_tuple(std::chrono::seconds(2),      // test_duration
+                        std::chrono::microseconds(2), // enqueue_delay
+                        std::chrono::microseconds(0), // dequeue_delay
+                        4,                            // nb_producers
+                        3000,                         // nb_slots
+                        3,                            // enqueue_batch_size
+                        2),                           // dequeue_batch_size
+        // 02
+        std::make_tuple(std::chrono::seconds(2),      // test_duration
+                        std::chrono::microseconds(0), // enqueue_delay
+                        std::chrono::microseconds(1), // dequeue_delay
+                        4,                            // nb_producers
+                        3000,                         // nb_slots
+                        10,                           // enqueue_batch_size
+                        1000),                        // dequeue_batch_size
+        // 03
+        std::make_tuple(std::chrono::seconds(2),      // test_duration
+                        std::chrono::microseconds(0), // enqueue_delay
+                        std::chrono::microseconds(0), // dequeue_delay
+                        8,                            // nb_producers
+                        3000,                         // nb_slots
+                        1000,                         // enqueue_batch_size
+                        10)));                        // dequeue_batch_size
+} // namespace holoflow
@@ -0,0 +1,173 @@
+#include "batched_spsc_queue/batched_spsc_queue.hh"
+#include "batched_spsc_queue/queue_buffer.hh"
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace holoflow {
+
+TEST(BatchedSPSCQueueFlushTest, Tail_Is_Readable_Once_Flushed) {
+  std::vector<uint8_t> buffer(12);
+  BatchedSPSCQueue queue(12, 2, 4, sizeof(uint8_t), buffer.data());
+  size_t count = 0;
+
+  for (size_t i = 0; i < 3; i++) {
+    ASSERT_TRUE(queue.write_ptr());
+    queue.commit_write();
+  }
+  ASSERT_TRUE(queue.read_ptr());
+  queue.commit_read();
+
+  // The two elements left are not a whole batch.
+  EXPECT_FALSE(queue.read_ptr());
+  EXPECT_FALSE(queue.read_ptr_partial(count));
+
+  queue.flush();
+  uint8_t *read_ptr = queue.read_ptr_partial(count);
+  ASSERT_TRUE(read_ptr);
+  EXPECT_EQ(read_ptr, buffer.data() + 4);
+  EXPECT_EQ(count, 2);
+  queue.commit_read_partial(count);
+  EXPECT_FALSE(queue.read_ptr_partial(count));
+
+  // The batch is completed without a flush, whole batches come back after.
+  for (size_t i = 0; i < 3; i++) {
+    ASSERT_TRUE(queue.write_ptr());
+    queue.commit_write();
+  }
+  EXPECT_FALSE(queue.read_ptr());
+  read_ptr = queue.read_ptr_partial(count);
+  ASSERT_TRUE(read_ptr);
+  EXPECT_EQ(read_ptr, buffer.data() + 6);
+  EXPECT_EQ(count, 2);
+  queue.commit_read_partial(count);
+  EXPECT_EQ(queue.read_ptr(), buffer.data() + 8);
+  queue.commit_read();
+  EXPECT_EQ(queue.size(), 0);
+}
+
+TEST(BatchedSPSCQueueFlushTest, Flush_Ends_At_Next_Commit) {
+  std::vector<uint8_t> buffer(12);
+  BatchedSPSCQueue queue(12, 1, 4, sizeof(uint8_t), buffer.data());
+  size_t count = 0;
+
+  ASSERT_TRUE(queue.write_ptr());
+  queue.commit_write();
+  queue.flush();
+  ASSERT_TRUE(queue.write_ptr());
+  queue.commit_write();
+
+  EXPECT_FALSE(queue.read_ptr_partial(count));
+  queue.flush();
+  ASSERT_TRUE(queue.read_ptr_partial(count));
+  EXPECT_EQ(count, 2);
+}
+
+TEST(BatchedSPSCQueueFlushTest, Closed_Stream_Is_Read_Entirely) {
+  const size_t nb_elements = 1001;
+  std::vector<uint8_t> buffer(64);
+  BatchedSPSCQueue queue(64, 1, 16, sizeof(uint8_t), buffer.data());
+
+  std::thread enqueue_thread([&queue, nb_elements]() {
+    for (size_t i = 0; i < nb_elements; i++) {
+      uint8_t *write_ptr = queue.wait_write_ptr();
+      *write_ptr = static_cast<uint8_t>(i);
+      queue.commit_write();
+    }
+    queue.close();
+  });
+
+  size_t read = 0;
+  while (true) {
+    bool closed = queue.is_closed();
+    size_t count = 0;
+    uint8_t *read_ptr = queue.read_ptr_partial(count);
+    if (!read_ptr) {
+      if (closed)
+        break;
+      continue;
+    }
+
+    for (size_t i = 0; i < count; i++, read++)
+      ASSERT_EQ(read_ptr[i], static_cast<uint8_t>(read));
+    queue.commit_read_partial(count);
+  }
+
+  enqueue_thread.join();
+  EXPECT_EQ(read, nb_elements);
+}
+
+TEST(BatchedSPSCQueueFlushTest, Waiting_Reader_Drains_Closed_Tail) {
+  std::vector<uint8_t> buffer(16);
+  BatchedSPSCQueue queue(16, 2, 4, sizeof(uint8_t), buffer.data());
+  queue.set_wait_strategy({WaitPolicy::SpinPark, 0, 0});
+
+  // The reader parks on a queue that will never hold a whole batch.
+  std::thread dequeue_thread([&queue]() {
+    EXPECT_FALSE(queue.wait_read_ptr(std::chrono::seconds(10)));
+    EXPECT_TRUE(queue.is_closed());
+
+    size_t count = 0;
+    uint8_t *read_ptr = queue.read_ptr_partial(count);
+    ASSERT_TRUE(read_ptr);
+    ASSERT_EQ(count, 2);
+    EXPECT_EQ(read_ptr[1], 1);
+    queue.commit_read_partial(count);
+
+    // Once a batch is partially read, waiting returns right away.
+    EXPECT_FALSE(queue.wait_read_ptr());
+    EXPECT_FALSE(queue.read_ptr_partial(count));
+  });
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  auto start = std::chrono::steady_clock::now();
+  uint8_t *write_ptr = queue.write_ptr();
+  ASSERT_TRUE(write_ptr);
+  write_ptr[0] = 0;
+  write_ptr[1] = 1;
+  queue.commit_write();
+  queue.close();
+  dequeue_thread.join();
+
+  // The reader was woken up by the close, not by its timeout.
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+}
+
+TEST(BatchedSPSCQueueFlushTest, Mirrored_Partial_Read_Straddles_Wrap) {
+  size_t nb_slots = QueueBuffer::page_size();
+  BatchedSPSCQueue queue(nb_slots, 1, 3, sizeof(uint8_t),
+                         QueueBuffer::mirrored(nb_slots));
+  size_t count = 0;
+
+  // Leave the read index two elements before the wrap point.
+  for (size_t i = 0; i < nb_slots - 2; i++) {
+    ASSERT_TRUE(queue.write_ptr());
+    queue.commit_write();
+    if (queue.read_ptr())
+      queue.commit_read();
+  }
+  queue.flush();
+  ASSERT_TRUE(queue.read_ptr_partial(count));
+  EXPECT_EQ(count, (nb_slots - 2) % 3);
+  queue.commit_read_partial(count);
+  ASSERT_EQ(queue.size(), 0);
+
+  for (size_t i = 0; i < 4; i++) {
+    ASSERT_TRUE(queue.write_ptr());
+    queue.commit_write();
+  }
+  ASSERT_TRUE(queue.read_ptr());
+  queue.commit_read();
+
+  queue.flush();
+  ASSERT_TRUE(queue.read_ptr_partial(count));
+  EXPECT_EQ(count, 1);
+  queue.commit_read_partial(count);
+  EXPECT_EQ(queue.size(), 0);
+}
+
+} // namespace holoflow
@@ -0,0 +1,222 @@
+#include "batched_spsc_queue/batched_spsc_queue.hh"
+#include "batched_spsc_queue/queue_buffer.hh"
+
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+namespace holoflow {
+
+TEST(QueueBufferTest, Mirrored_Buffer_Aliases_Its_Pages) {
+  size_t size = 2 * QueueBuffer::page_size();
+  QueueBuffer buffer = QueueBuffer::mirrored(size);
+  ASSERT_TRUE(buffer.data());
+  EXPECT_EQ(buffer.size(), size);
+  EXPECT_TRUE(buffer.is_mirrored());
+
+  buffer.data()[10] = 42;
+  EXPECT_EQ(buffer.data()[size + 10], 42);
+  buffer.data()[2 * size - 1] = 7;
+  EXPECT_EQ(buffer.data()[size - 1], 7);
+}
+
+TEST(QueueBufferTest, Mirrored_Buffer_Rejects_Partial_Pages) {
+  EXPECT_THROW(QueueBuffer::mirrored(0), std::invalid_argument);
+  EXPECT_THROW(QueueBuffer::mirrored(QueueBuffer::page_size() + 1),
+               std::invalid_argument);
+}
+
+TEST(QueueBufferTest, Queue_Validates_Owned_Buffer) {
+  size_t page = QueueBuffer::page_size();
+  EXPECT_THROW(BatchedSPSCQueue(page, 3, 8, 2, QueueBuffer::mirrored(page)),
+               std::invalid_argument);
+  EXPECT_THROW(BatchedSPSCQueue(page, 0, 8, 1, QueueBuffer::mirrored(page)),
+               std::invalid_argument);
+  EXPECT_NO_THROW(
+      BatchedSPSCQueue(page, 3, 8, 1, QueueBuffer::mirrored(page)));
+}
+
+TEST(QueueBufferTest, Queue_Rejects_Batches_Larger_Than_The_Buffer) {
+  // With 3 + (page - 2) slots, the writer would stop at page - 3 elements
+  // while the reader waits for page - 2.
+  size_t page = QueueBuffer::page_size();
+  EXPECT_THROW(
+      BatchedSPSCQueue(page, 3, page - 2, 1, QueueBuffer::mirrored(page)),
+      std::invalid_argument);
+
+  BatchedSPSCQueue queue(page, 3, page - 3, 1, QueueBuffer::mirrored(page));
+  EXPECT_THROW(queue.request_enqueue_batch_size(4), std::invalid_argument);
+  EXPECT_THROW(queue.request_dequeue_batch_size(page - 2),
+               std::invalid_argument);
+  EXPECT_NO_THROW(queue.request_dequeue_batch_size(7));
+
+  // The dequeue batch size may still switch back to page - 3.
+  EXPECT_THROW(queue.request_enqueue_batch_size(4), std::invalid_argument);
+}
+
+TEST(QueueBufferTest, Concurrent_Requests_Are_Checked_Against_Each_Other) {
+  // Each size fits with the current ones, but not with the other.
+  size_t page = QueueBuffer::page_size();
+  size_t batch_size = page / 2 + 1;
+
+  for (size_t round = 0; round < 2000; round++) {
+    BatchedSPSCQueue queue(page, 1, 1, 1, QueueBuffer::mirrored(page));
+    std::atomic<size_t> ready{0};
+
+    auto request = [&queue, &ready, batch_size](
+                       void (BatchedSPSCQueue::*request)(size_t)) {
+      ready.fetch_add(1);
+      while (ready.load() < 2)
+        std::this_thread::yield();
+      try {
+        (queue.*request)(batch_size);
+        return true;
+      } catch (const std::invalid_argument &) {
+        return false;
+      }
+    };
+
+    bool enqueue_accepted = false;
+    bool dequeue_accepted = false;
+    std::thread enqueue_thread([&]() {
+      enqueue_accepted = request(&BatchedSPSCQueue::request_enqueue_batch_size);
+    });
+    std::thread dequeue_thread([&]() {
+      dequeue_accepted = request(&BatchedSPSCQueue::request_dequeue_batch_size);
+    });
+    enqueue_thread.join();
+    dequeue_thread.join();
+
+    ASSERT_NE(enqueue_accepted, dequeue_accepted) << "round " << round;
+  }
+}
+
+TEST(QueueBufferTest, Largest_Batches_Never_Stall_Both_Sides) {
+  // Neither batch size divides the number of slots, and the reader needs all
+  // the slots the writer can fill.
+  size_t page = QueueBuffer::page_size();
+  size_t dequeue_batch_size = page - 3;
+  BatchedSPSCQueue queue(page, 3, dequeue_batch_size, 1,
+                         QueueBuffer::mirrored(page));
+
+  uint8_t value = 0;
+  uint8_t expected = 0;
+  for (size_t i = 0; i < 100; i++) {
+    bool progress = false;
+    while (uint8_t *write_ptr = queue.write_ptr()) {
+      for (size_t j = 0; j < 3; j++)
+        write_ptr[j] = value++;
+      queue.commit_write();
+      progress = true;
+    }
+    while (uint8_t *read_ptr = queue.read_ptr()) {
+      for (size_t j = 0; j < dequeue_batch_size; j++)
+        ASSERT_EQ(read_ptr[j], expected++);
+      queue.commit_read();
+      progress = true;
+    }
+    ASSERT_TRUE(progress) << "stalled at " << queue.size() << " elements";
+  }
+}
+
+class BatchedSPSCQueueMirroredTest
+    : public ::testing::TestWithParam<std::tuple<size_t, size_t>> {};
+
+TEST_P(BatchedSPSCQueueMirroredTest, Capacity_Is_Respected) {
+  auto [enqueue_batch_size, dequeue_batch_size] = GetParam();
+  size_t nb_slots = QueueBuffer::page_size();
+
+  // Shift the internal indexes so that batches straddle the wrap point.
+  for (size_t i = 0; i < 2 * enqueue_batch_size * dequeue_batch_size; i++) {
+    BatchedSPSCQueue queue(nb_slots, enqueue_batch_size, dequeue_batch_size,
+                           sizeof(uint8_t), QueueBuffer::mirrored(nb_slots));
+    for (size_t j = 0; j < i; j++) {
+      for (size_t k = 0; k < nb_slots / 2 / enqueue_batch_size; k++) {
+        ASSERT_TRUE(queue.write_ptr());
+        queue.commit_write();
+      }
+      while (queue.read_ptr())
+        queue.commit_read();
+      // Leftovers smaller than a dequeue batch stay in the queue.
+      ASSERT_LT(queue.size(), dequeue_batch_size);
+    }
+
+    // The capacity is nb_slots - 1, rounded down to whole enqueue batches.
+    size_t size = queue.size();
+    size_t nb_enqueues = (nb_slots - 1 - size) / enqueue_batch_size;
+    for (size_t j = 0; j < nb_enqueues; j++) {
+      ASSERT_TRUE(queue.write_ptr());
+      queue.commit_write();
+    }
+    ASSERT_FALSE(queue.write_ptr());
+    EXPECT_GT(queue.size() + enqueue_batch_size, nb_slots - 1);
+
+    size_t nb_dequeues = queue.size() / dequeue_batch_size;
+    for (size_t j = 0; j < nb_dequeues; j++) {
+      ASSERT_TRUE(queue.read_ptr());
+      queue.commit_read();
+    }
+    ASSERT_FALSE(queue.read_ptr());
+  }
+}
+
+TEST_P(BatchedSPSCQueueMirroredTest, Straddling_Batches_Are_Contiguous) {
+  auto [enqueue_batch_size, dequeue_batch_size] = GetParam();
+  size_t nb_slots = QueueBuffer::page_size();
+  size_t nb_elements = nb_slots * 100;
+
+  BatchedSPSCQueue queue(nb_slots, enqueue_batch_size, dequeue_batch_size,
+                         sizeof(uint8_t), QueueBuffer::mirrored(nb_slots));
+
+  std::thread enqueue_thread(
+      [&queue, nb_elements, enqueue_batch_size = enqueue_batch_size]() {
+        uint8_t data = 0;
+        for (size_t i = 0; i < nb_elements; i += enqueue_batch_size) {
+          uint8_t *write_ptr = queue.write_ptr();
+          while (!write_ptr)
+            write_ptr = queue.write_ptr();
+
+          for (size_t j = 0; j < enqueue_batch_size; j++)
+            write_ptr[j] = data++;
+          queue.commit_write();
+        }
+      });
+
+  uint8_t expected = 0;
+  for (size_t i = 0; i + dequeue_batch_size <= nb_elements;
+       i += dequeue_batch_size) {
+    uint8_t *read_ptr = queue.read_ptr();
+    while (!read_ptr)
+      read_ptr = queue.read_ptr();
+
+    for (size_t j = 0; j < dequeue_batch_size; j++)
+      ASSERT_EQ(read_ptr[j], expected++);
+    queue.commit_read();
+  }
+
+  enqueue_thread.join();
+}
+
+INSTANTIATE_TEST_SUITE_P(BatchedSPSCQueueMirroredTestSuite,
+                         BatchedSPSCQueueMirroredTest,
+                         ::testing::Values(
+                             // 00
+                             std::make_tuple(3,    // enqueue_batch_size
+                                             8),   // dequeue_batch_size
+                             // 01
+                             std::make_tuple(8,    // enqueue_batch_size
+                                             3),   // dequeue_batch_size
+                             // 02
+                             std::make_tuple(7,    // enqueue_batch_size
+                                             5),   // dequeue_batch_size
+                             // 03
+                             std::make_tuple(1,    // enqueue_batch_size
+                                             9),   // dequeue_batch_size
+                             // 04
+                             std::make_tuple(100,  // enqueue_batch_size
+                                             33))); // dequeue_batch_size
+
+} // namespace holoflow
@@ -0,0 +1,84 @@
+#include "batched_spsc_queue/batched_spsc_queue.hh"
+#include "batched_spsc_queue/queue_buffer.hh"
+
+#include <cstdint>
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+
+namespace holoflow {
+
+TEST(QueueBufferAllocateTest, Default_Allocation_Is_Page_Aligned) {
+  QueueBuffer buffer = QueueBuffer::allocate(1000);
+  ASSERT_TRUE(buffer.data());
+  EXPECT_EQ(buffer.size(), 1000);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(buffer.data()) %
+                QueueBuffer::page_size(),
+            0);
+  EXPECT_EQ(buffer.backing(), BufferBacking::Pages);
+  EXPECT_EQ(buffer.numa_node(), -1);
+  EXPECT_FALSE(buffer.is_prefaulted());
+  EXPECT_FALSE(buffer.is_mirrored());
+
+  buffer.data()[999] = 42;
+  EXPECT_EQ(buffer.data()[999], 42);
+}
+
+TEST(QueueBufferAllocateTest, Zero_Size_Is_Rejected) {
+  EXPECT_THROW(QueueBuffer::allocate(0), std::invalid_argument);
+}
+
+TEST(QueueBufferAllocateTest, Transparent_Huge_Pages_Are_Aligned) {
+  QueueBuffer buffer =
+      QueueBuffer::allocate(3 * 1024 * 1024, {HugePages::Transparent});
+  ASSERT_TRUE(buffer.data());
+  EXPECT_NE(buffer.backing(), BufferBacking::HugeTLB);
+  if (buffer.backing() == BufferBacking::TransparentHugePages) {
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(buffer.data()) %
+                  QueueBuffer::huge_page_size(),
+              0);
+  }
+}
+
+TEST(QueueBufferAllocateTest, Explicit_Huge_Pages_Fall_Back) {
+  // Whether the huge page pool has pages depends on the machine, the buffer
+  // must be usable either way.
+  QueueBuffer buffer = QueueBuffer::allocate(1024, {HugePages::Explicit});
+  ASSERT_TRUE(buffer.data());
+  EXPECT_NE(buffer.backing(), BufferBacking::None);
+  buffer.data()[0] = 1;
+}
+
+TEST(QueueBufferAllocateTest, Numa_Binding_And_Prefault) {
+  // Node 0 always exists, but NUMA policies may not be supported.
+  QueueBuffer buffer =
+      QueueBuffer::allocate(1 << 20, {HugePages::None, 0, true});
+  EXPECT_TRUE(buffer.numa_node() == 0 || buffer.numa_node() == -1);
+  EXPECT_TRUE(buffer.is_prefaulted());
+
+  // A node that does not exist is reported as unbound.
+  QueueBuffer unbound = QueueBuffer::allocate(4096, {HugePages::None, 1000});
+  EXPECT_EQ(unbound.numa_node(), -1);
+}
+
+TEST(QueueBufferAllocateTest, Queue_Owns_Allocated_Buffer) {
+  constexpr size_t nb_slots = 100;
+  constexpr size_t element_size = 512 * 512;
+  BatchedSPSCQueue queue(nb_slots, 4, 10, element_size,
+                         QueueBuffer::allocate(nb_slots * element_size));
+
+  uint8_t *write_ptr = queue.write_ptr();
+  ASSERT_TRUE(write_ptr);
+  write_ptr[0] = 42;
+  queue.commit_write();
+
+  // Non-mirrored owned buffers keep the divisibility constraints.
+  EXPECT_THROW(BatchedSPSCQueue(nb_slots, 3, 10, element_size,
+                                QueueBuffer::allocate(nb_slots * element_size)),
+               std::invalid_argument);
+  EXPECT_THROW(BatchedSPSCQueue(nb_slots, 4, 10, element_size,
+                                QueueBuffer::allocate(element_size)),
+               std::invalid_argument);
+}
+
+} // namespace holoflow
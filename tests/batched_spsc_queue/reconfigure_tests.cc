@@ -0,0 +1,122 @@
+#include "batched_spsc_queue/batched_spsc_queue.hh"
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace holoflow {
+
+TEST(BatchedSPSCQueueReconfigureTest, Invalid_Sizes_Are_Rejected) {
+  std::vector<uint8_t> buffer(24);
+  BatchedSPSCQueue queue(24, 4, 4, sizeof(uint8_t), buffer.data());
+
+  EXPECT_THROW(queue.request_enqueue_batch_size(0), std::invalid_argument);
+  EXPECT_THROW(queue.request_enqueue_batch_size(24), std::invalid_argument);
+  EXPECT_THROW(queue.request_dequeue_batch_size(5), std::invalid_argument);
+  EXPECT_NO_THROW(queue.request_dequeue_batch_size(12));
+}
+
+TEST(BatchedSPSCQueueReconfigureTest, Switch_Happens_On_Aligned_Index) {
+  std::vector<uint8_t> buffer(24);
+  BatchedSPSCQueue queue(24, 4, 4, sizeof(uint8_t), buffer.data());
+  uint8_t value = 0;
+
+  auto write = [&queue, &value]() {
+    uint8_t *write_ptr = queue.write_ptr();
+    ASSERT_TRUE(write_ptr);
+    for (size_t i = 0; i < queue.enqueue_batch_size(); i++)
+      write_ptr[i] = value++;
+    queue.commit_write();
+  };
+
+  for (size_t i = 0; i < 4; i++)
+    write();
+  ASSERT_TRUE(queue.read_ptr());
+  queue.commit_read();
+
+  // The read index is 4, the new size only applies once it reaches 12.
+  queue.request_dequeue_batch_size(6);
+  EXPECT_EQ(queue.dequeue_batch_size(), 4);
+  ASSERT_EQ(queue.read_ptr(), buffer.data() + 4);
+  queue.commit_read();
+  EXPECT_EQ(queue.dequeue_batch_size(), 4);
+  ASSERT_EQ(queue.read_ptr(), buffer.data() + 8);
+  queue.commit_read();
+  EXPECT_EQ(queue.dequeue_batch_size(), 6);
+
+  // The write index is 16, a multiple of 8.
+  queue.request_enqueue_batch_size(8);
+  write();
+  EXPECT_EQ(queue.enqueue_batch_size(), 4);
+  queue.request_enqueue_batch_size(2);
+  write();
+  EXPECT_EQ(queue.enqueue_batch_size(), 2);
+  EXPECT_EQ(queue.size(), 12);
+
+  // Nothing was lost.
+  uint8_t *read_ptr = queue.read_ptr();
+  ASSERT_EQ(read_ptr, buffer.data() + 12);
+  for (size_t i = 0; i < 6; i++)
+    EXPECT_EQ(read_ptr[i], 12 + i);
+  queue.commit_read();
+}
+
+TEST(BatchedSPSCQueueReconfigureTest, Live_Switches_Keep_Order) {
+  const size_t nb_slots = 720;
+  const std::vector<size_t> sizes = {1, 3, 4, 8, 9, 16, 45, 120};
+  const auto test_duration = std::chrono::seconds(2);
+  std::vector<uint8_t> buffer(nb_slots * sizeof(uint32_t));
+  BatchedSPSCQueue queue(nb_slots, 4, 9, sizeof(uint32_t), buffer.data());
+
+  std::thread enqueue_thread([&queue, &sizes, test_duration]() {
+    auto start_time = std::chrono::steady_clock::now();
+    uint32_t counter = 0;
+    for (size_t i = 0;
+         std::chrono::steady_clock::now() - start_time < test_duration; i++) {
+      if (i % 1000 == 0)
+        queue.request_enqueue_batch_size(sizes[i / 1000 % sizes.size()]);
+
+      auto write_ptr = queue.write_ptr();
+      if (!write_ptr)
+        continue;
+      for (size_t j = 0; j < queue.enqueue_batch_size(); j++, counter++)
+        std::memcpy(write_ptr + j * sizeof(uint32_t), &counter,
+                    sizeof(uint32_t));
+      queue.commit_write();
+    }
+  });
+
+  std::thread dequeue_thread([&queue, &sizes, test_duration]() {
+    auto start_time = std::chrono::steady_clock::now();
+    uint32_t expected = 0;
+    for (size_t i = 0;
+         std::chrono::steady_clock::now() - start_time < test_duration; i++) {
+      if (i % 777 == 0)
+        queue.request_dequeue_batch_size(sizes[i / 777 % sizes.size()]);
+
+      auto read_ptr = queue.read_ptr();
+      if (!read_ptr)
+        continue;
+      for (size_t j = 0; j < queue.dequeue_batch_size(); j++, expected++) {
+        uint32_t value;
+        std::memcpy(&value, read_ptr + j * sizeof(uint32_t), sizeof(value));
+        ASSERT_EQ(value, expected);
+      }
+      queue.commit_read();
+    }
+
+    // Drain what is left so that the producer never waits on a full queue.
+    while (queue.read_ptr())
+      queue.commit_read();
+  });
+
+  enqueue_thread.join();
+  dequeue_thread.join();
+}
+
+} // namespace holoflow
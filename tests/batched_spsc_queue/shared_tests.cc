@@ -0,0 +1,96 @@
+#include "batched_spsc_queue/batched_spsc_queue.hh"
+#include "batched_spsc_queue/queue_buffer.hh"
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include <gtest/gtest.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace holoflow {
+
+/// Returns a segment name that does not clash with concurrent test runs.
+static std::string segment_name(const char *suffix) {
+  return "/holoflow-test-" + std::to_string(getpid()) + "-" + suffix;
+}
+
+TEST(BatchedSPSCQueueSharedTest, Attach_Reads_Geometry_And_Indexes) {
+  std::string name = segment_name("attach");
+  auto producer = BatchedSPSCQueue::create_shared(name, 64, 2, 4, 8);
+
+  for (size_t i = 0; i < 5; i++) {
+    uint8_t *write_ptr = producer->write_ptr();
+    ASSERT_TRUE(write_ptr);
+    std::memset(write_ptr, static_cast<int>(i), 2 * 8);
+    producer->commit_write();
+  }
+
+  // Both queues see the same elements and indexes, at different addresses.
+  auto consumer = BatchedSPSCQueue::attach_shared(name);
+  EXPECT_EQ(consumer->size(), 10);
+  uint8_t *read_ptr = consumer->read_ptr();
+  ASSERT_TRUE(read_ptr);
+  EXPECT_EQ(read_ptr[0], 0);
+  EXPECT_EQ(read_ptr[2 * 8], 1);
+  consumer->commit_read();
+  EXPECT_EQ(producer->size(), 6);
+
+  EXPECT_THROW(BatchedSPSCQueue::create_shared(name, 64, 2, 4, 8),
+               std::system_error);
+}
+
+TEST(BatchedSPSCQueueSharedTest, Invalid_Segments_Are_Rejected) {
+  std::string name = segment_name("invalid");
+  EXPECT_THROW(BatchedSPSCQueue::attach_shared(name), std::system_error);
+  EXPECT_THROW(BatchedSPSCQueue::create_shared(name, 64, 3, 4, 8),
+               std::invalid_argument);
+
+  // A segment that does not hold a queue.
+  QueueBuffer segment = QueueBuffer::create_shared(name, 1 << 16);
+  EXPECT_TRUE(segment.is_shared());
+  EXPECT_THROW(BatchedSPSCQueue::attach_shared(name), std::invalid_argument);
+}
+
+TEST(BatchedSPSCQueueSharedTest, Two_Processes_Transfer_In_Order) {
+  std::string name = segment_name("transfer");
+  const size_t nb_elements = 1000000;
+  auto producer = BatchedSPSCQueue::create_shared(name, 1024, 4, 16, 4);
+  producer->set_wait_strategy({WaitPolicy::SpinPark, 64, 16});
+
+  pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0) {
+    // The consumer process reports through its exit status only.
+    auto consumer = BatchedSPSCQueue::attach_shared(name);
+    consumer->set_wait_strategy({WaitPolicy::SpinPark, 64, 16});
+    for (uint32_t expected = 0; expected < nb_elements;) {
+      uint8_t *read_ptr = consumer->wait_read_ptr();
+      for (size_t i = 0; i < 16; i++, expected++) {
+        uint32_t value;
+        std::memcpy(&value, read_ptr + i * sizeof(uint32_t), sizeof(value));
+        if (value != expected)
+          _exit(1);
+      }
+      consumer->commit_read();
+    }
+    _exit(0);
+  }
+
+  for (uint32_t value = 0; value < nb_elements;) {
+    uint8_t *write_ptr = producer->wait_write_ptr();
+    for (size_t i = 0; i < 4; i++, value++)
+      std::memcpy(write_ptr + i * sizeof(uint32_t), &value, sizeof(value));
+    producer->commit_write();
+  }
+
+  int status = 0;
+  ASSERT_EQ(waitpid(pid, &status, 0), pid);
+  ASSERT_TRUE(WIFEXITED(status));
+  EXPECT_EQ(WEXITSTATUS(status), 0);
+}
+
+} // namespace holoflow
@@ -0,0 +1,108 @@
+#include "batched_spsc_queue/batched_spsc_queue.hh"
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace holoflow {
+
+TEST(BatchedSPSCQueueSpanTest, Spans_Stop_At_Capacity_And_Wrap_Point) {
+  constexpr size_t nb_slots = 12;
+  constexpr size_t enqueue_batch_size = 2;
+  constexpr size_t dequeue_batch_size = 3;
+  std::vector<uint8_t> buffer(nb_slots * sizeof(uint16_t));
+  BatchedSPSCQueue queue(nb_slots, enqueue_batch_size, dequeue_batch_size,
+                         sizeof(uint16_t), buffer.data());
+
+  // Empty queue: nothing to read, capacity is 10 elements, so 5 batches.
+  EXPECT_TRUE(queue.read_span(10).empty());
+  auto span = queue.write_span(10);
+  EXPECT_EQ(span.data(), buffer.data());
+  EXPECT_EQ(span.size(), 5 * enqueue_batch_size * sizeof(uint16_t));
+
+  // Only ask for what we want.
+  EXPECT_EQ(queue.write_span(2).size(),
+            2 * enqueue_batch_size * sizeof(uint16_t));
+
+  queue.commit_write(4);
+  EXPECT_EQ(queue.size(), 8);
+
+  // 8 elements, 2 whole dequeue batches.
+  span = queue.read_span(10);
+  EXPECT_EQ(span.data(), buffer.data());
+  EXPECT_EQ(span.size(), 2 * dequeue_batch_size * sizeof(uint16_t));
+  queue.commit_read(2);
+  EXPECT_EQ(queue.size(), 2);
+
+  // Writer is at index 8, only 2 batches fit before the wrap point even
+  // though 4 batches of space are free.
+  span = queue.write_span(10);
+  EXPECT_EQ(span.data(), buffer.data() + 8 * sizeof(uint16_t));
+  EXPECT_EQ(span.size(), 2 * enqueue_batch_size * sizeof(uint16_t));
+  queue.commit_write(2);
+
+  // The writer wrapped, the rest of the free space is at the beginning.
+  span = queue.write_span(10);
+  EXPECT_EQ(span.data(), buffer.data());
+  EXPECT_EQ(span.size(), 2 * enqueue_batch_size * sizeof(uint16_t));
+  queue.commit_write(2);
+  EXPECT_FALSE(queue.write_ptr());
+
+  // Reader is at index 6: 2 batches until the wrap point, then 1 more.
+  EXPECT_EQ(queue.read_span(10).size(),
+            2 * dequeue_batch_size * sizeof(uint16_t));
+  queue.commit_read(2);
+  EXPECT_EQ(queue.read_span(10).size(),
+            1 * dequeue_batch_size * sizeof(uint16_t));
+  queue.commit_read(1);
+  EXPECT_EQ(queue.size(), 1);
+}
+
+TEST(BatchedSPSCQueueSpanTest, Multi_Batch_Transfer_Is_Ordered) {
+  constexpr size_t nb_slots = 3000;
+  constexpr size_t enqueue_batch_size = 10;
+  constexpr size_t dequeue_batch_size = 6;
+  constexpr size_t nb_elements = nb_slots * 100;
+  std::vector<uint8_t> buffer(nb_slots);
+  BatchedSPSCQueue queue(nb_slots, enqueue_batch_size, dequeue_batch_size,
+                         sizeof(uint8_t), buffer.data());
+
+  // Producer mixes single and multi-batch writes.
+  std::thread enqueue_thread([&queue]() {
+    uint8_t data = 0;
+    size_t written = 0;
+    for (size_t i = 0; written < nb_elements; i++) {
+      auto span = queue.write_span(i % 7 + 1);
+      size_t nb_batches = span.size() / enqueue_batch_size;
+      nb_batches =
+          std::min(nb_batches, (nb_elements - written) / enqueue_batch_size);
+      if (nb_batches == 0)
+        continue;
+
+      for (size_t j = 0; j < nb_batches * enqueue_batch_size; j++)
+        span[j] = data++;
+      queue.commit_write(nb_batches);
+      written += nb_batches * enqueue_batch_size;
+    }
+  });
+
+  // Consumer drains everything available.
+  uint8_t expected = 0;
+  size_t read = 0;
+  while (read < nb_elements) {
+    auto span = queue.read_span(nb_slots);
+    if (span.empty())
+      continue;
+
+    for (uint8_t value : span)
+      ASSERT_EQ(value, expected++);
+    queue.commit_read(span.size() / dequeue_batch_size);
+    read += span.size();
+  }
+
+  enqueue_thread.join();
+}
+
+} // namespace holoflow
@@ -0,0 +1,132 @@
+#include "batched_spsc_queue/batched_spsc_queue.hh"
+#include "batched_spsc_queue/static_batched_spsc_queue.hh"
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace holoflow {
+
+template <typename Queue>
+class StaticBatchedSPSCQueueTest : public ::testing::Test {};
+
+using StaticQueueTypes = ::testing::Types<
+    // Power-of-two slot counts, masked index arithmetic.
+    StaticBatchedSPSCQueue<1, 1, 1, 128>, StaticBatchedSPSCQueue<1, 2, 8, 128>,
+    StaticBatchedSPSCQueue<4, 16, 4, 256>,
+    // Other slot counts, compare-and-branch index arithmetic.
+    StaticBatchedSPSCQueue<1, 3, 2, 102>, StaticBatchedSPSCQueue<2, 5, 3, 105>>;
+TYPED_TEST_SUITE(StaticBatchedSPSCQueueTest, StaticQueueTypes);
+
+TYPED_TEST(StaticBatchedSPSCQueueTest, Capacity_Is_Respected) {
+  using Queue = TypeParam;
+  constexpr size_t nb_slots = Queue::nb_slots();
+  constexpr size_t enqueue_batch_size = Queue::enqueue_batch_size();
+  constexpr size_t dequeue_batch_size = Queue::dequeue_batch_size();
+
+  std::vector<uint8_t> buffer(Queue::buffer_size());
+
+  // Shift the internal indexes by every possible amount, as in the capacity
+  // tests of the runtime queue.
+  for (size_t i = 0; i < nb_slots * 2; i++) {
+    Queue queue(buffer.data());
+    for (size_t j = 0; j < i; j++) {
+      for (size_t k = 0; k < dequeue_batch_size; k++) {
+        ASSERT_TRUE(queue.write_ptr());
+        queue.commit_write();
+      }
+      for (size_t k = 0; k < enqueue_batch_size; k++) {
+        ASSERT_TRUE(queue.read_ptr());
+        queue.commit_read();
+      }
+    }
+    ASSERT_EQ(queue.size(), 0);
+
+    size_t nb_enqueues = (nb_slots - enqueue_batch_size) / enqueue_batch_size;
+    for (size_t j = 0; j < nb_enqueues; j++) {
+      ASSERT_TRUE(queue.write_ptr());
+      queue.commit_write();
+    }
+    ASSERT_FALSE(queue.write_ptr());
+    ASSERT_EQ(queue.size(), nb_enqueues * enqueue_batch_size);
+
+    size_t nb_dequeues =
+        (nb_enqueues * enqueue_batch_size) / dequeue_batch_size;
+    for (size_t j = 0; j < nb_dequeues; j++) {
+      ASSERT_TRUE(queue.read_ptr());
+      queue.commit_read();
+    }
+    ASSERT_FALSE(queue.read_ptr());
+  }
+}
+
+TYPED_TEST(StaticBatchedSPSCQueueTest, Fill_Matches_The_Runtime_Queue) {
+  using Queue = TypeParam;
+  std::vector<uint8_t> static_buffer(Queue::buffer_size());
+  std::vector<uint8_t> runtime_buffer(Queue::buffer_size());
+  Queue static_queue(static_buffer.data());
+  BatchedSPSCQueue runtime_queue(
+      Queue::nb_slots(), Queue::enqueue_batch_size(),
+      Queue::dequeue_batch_size(), Queue::element_size(),
+      runtime_buffer.data());
+
+  // Both queues hold as much as the writer can enqueue, and drain in the
+  // same number of batches.
+  static_queue.fill();
+  runtime_queue.fill();
+  EXPECT_FALSE(static_queue.write_ptr());
+  EXPECT_FALSE(runtime_queue.write_ptr());
+  ASSERT_EQ(runtime_queue.size(), static_queue.size());
+  EXPECT_EQ(static_queue.size(),
+            Queue::nb_slots() - Queue::enqueue_batch_size());
+
+  while (static_queue.read_ptr()) {
+    ASSERT_TRUE(runtime_queue.read_ptr());
+    static_queue.commit_read();
+    runtime_queue.commit_read();
+  }
+  EXPECT_FALSE(runtime_queue.read_ptr());
+  EXPECT_EQ(runtime_queue.size(), static_queue.size());
+}
+
+TYPED_TEST(StaticBatchedSPSCQueueTest, Batches_Are_Contiguous_And_Ordered) {
+  using Queue = TypeParam;
+  constexpr size_t element_size = Queue::element_size();
+  constexpr size_t enqueue_batch_size = Queue::enqueue_batch_size();
+  constexpr size_t dequeue_batch_size = Queue::dequeue_batch_size();
+  constexpr size_t nb_elements = Queue::nb_slots() * 50;
+
+  std::vector<uint8_t> buffer(Queue::buffer_size());
+  Queue queue(buffer.data());
+
+  std::thread enqueue_thread([&queue]() {
+    uint8_t data = 0;
+    for (size_t i = 0; i < nb_elements; i += enqueue_batch_size) {
+      uint8_t *write_ptr = queue.write_ptr();
+      while (!write_ptr)
+        write_ptr = queue.write_ptr();
+
+      for (size_t j = 0; j < enqueue_batch_size; j++)
+        write_ptr[j * element_size] = data++;
+      queue.commit_write();
+    }
+  });
+
+  uint8_t expected = 0;
+  for (size_t i = 0; i + dequeue_batch_size <= nb_elements;
+       i += dequeue_batch_size) {
+    uint8_t *read_ptr = queue.read_ptr();
+    while (!read_ptr)
+      read_ptr = queue.read_ptr();
+
+    for (size_t j = 0; j < dequeue_batch_size; j++)
+      ASSERT_EQ(read_ptr[j * element_size], expected++);
+    queue.commit_read();
+  }
+
+  enqueue_thread.join();
+}
+
+} // namespace holoflow
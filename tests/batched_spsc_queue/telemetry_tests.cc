@@ -0,0 +1,63 @@
+#include "batched_spsc_queue/batched_spsc_queue.hh"
+
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace holoflow {
+
+TEST(BatchedSPSCQueueTelemetryTest, Counters_Follow_Operations) {
+  std::vector<uint8_t> buffer(16);
+  BatchedSPSCQueue queue(16, 2, 4, sizeof(uint8_t), buffer.data());
+
+  // Stall on an empty queue, then fill it and stall on a full one.
+  EXPECT_FALSE(queue.read_ptr());
+  EXPECT_TRUE(queue.read_span(1).empty());
+  for (size_t i = 0; i < 7; i++) {
+    ASSERT_TRUE(queue.write_ptr());
+    queue.commit_write();
+  }
+  EXPECT_FALSE(queue.write_ptr());
+
+  // Enough traffic to cross several sample periods.
+  for (size_t i = 0; i < 3; i++) {
+    ASSERT_TRUE(queue.read_ptr());
+    queue.commit_read();
+  }
+  for (size_t i = 0; i < QUEUE_OCCUPANCY_SAMPLE_PERIOD * 2; i++) {
+    ASSERT_TRUE(queue.write_ptr());
+    queue.commit_write();
+    ASSERT_TRUE(queue.write_ptr());
+    queue.commit_write();
+    ASSERT_TRUE(queue.read_ptr());
+    queue.commit_read();
+  }
+
+  QueueTelemetry telemetry = queue.telemetry();
+  uint64_t nb_samples =
+      std::accumulate(telemetry.occupancy_histogram.begin(),
+                      telemetry.occupancy_histogram.end(), uint64_t{0});
+
+#ifdef HOLOFLOW_QUEUE_TELEMETRY
+  EXPECT_TRUE(telemetry.enabled);
+  EXPECT_EQ(telemetry.read_stalls, 2);
+  EXPECT_EQ(telemetry.write_stalls, 1);
+  EXPECT_EQ(telemetry.write_batches, 7 + QUEUE_OCCUPANCY_SAMPLE_PERIOD * 4);
+  EXPECT_EQ(telemetry.read_batches, 3 + QUEUE_OCCUPANCY_SAMPLE_PERIOD * 2);
+  EXPECT_EQ(telemetry.high_water_mark, 14);
+  EXPECT_EQ(nb_samples, telemetry.write_batches /
+                            QUEUE_OCCUPANCY_SAMPLE_PERIOD);
+#else
+  EXPECT_FALSE(telemetry.enabled);
+  EXPECT_EQ(telemetry.read_stalls, 0);
+  EXPECT_EQ(telemetry.write_stalls, 0);
+  EXPECT_EQ(telemetry.write_batches, 0);
+  EXPECT_EQ(telemetry.read_batches, 0);
+  EXPECT_EQ(telemetry.high_water_mark, 0);
+  EXPECT_EQ(nb_samples, 0);
+#endif
+}
+
+} // namespace holoflow
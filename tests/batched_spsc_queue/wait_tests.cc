@@ -0,0 +1,153 @@
+#include "batched_spsc_queue/batched_spsc_queue.hh"
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace holoflow {
+
+class BatchedSPSCQueueWaitTest
+    : public ::testing::TestWithParam<
+          std::tuple<WaitPolicy, std::chrono::microseconds,
+                     std::chrono::microseconds, size_t, size_t, size_t>> {};
+
+TEST_P(BatchedSPSCQueueWaitTest, Blocking_Transfer_Is_Ordered) {
+  // Test parameters.
+  auto [policy, enqueue_delay, dequeue_delay, nb_slots, enqueue_batch_size,
+        dequeue_batch_size] = GetParam();
+
+  // Create the queue.
+  std::vector<uint8_t> buffer(nb_slots);
+  BatchedSPSCQueue queue(nb_slots, enqueue_batch_size, dequeue_batch_size,
+                         sizeof(uint8_t), buffer.data());
+  queue.set_wait_strategy({policy, 64, 16});
+
+  // Enough batches to wrap around the queue a few times.
+  const size_t nb_elements = nb_slots * 20;
+
+  // Enqueue thread.
+  std::thread enqueue_thread(
+      [&queue, nb_elements, enqueue_batch_size, enqueue_delay]() {
+        uint8_t data = 0;
+        for (size_t i = 0; i < nb_elements; i += enqueue_batch_size) {
+          uint8_t *write_ptr = queue.wait_write_ptr();
+          for (size_t j = 0; j < enqueue_batch_size; j++)
+            write_ptr[j] = data++;
+          queue.commit_write();
+
+          if (enqueue_delay.count())
+            std::this_thread::sleep_for(enqueue_delay);
+        }
+      });
+
+  // Dequeue on the test thread.
+  uint8_t expected = 0;
+  for (size_t i = 0; i < nb_elements; i += dequeue_batch_size) {
+    uint8_t *read_ptr = queue.wait_read_ptr();
+    for (size_t j = 0; j < dequeue_batch_size; j++)
+      ASSERT_EQ(read_ptr[j], expected++);
+    queue.commit_read();
+
+    if (dequeue_delay.count())
+      std::this_thread::sleep_for(dequeue_delay);
+  }
+
+  enqueue_thread.join();
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    BatchedSPSCQueueWaitTestSuite, BatchedSPSCQueueWaitTest,
+    ::testing::Values(
+        // 00
+        std::make_tuple(WaitPolicy::Spin,              // policy
+                        std::chrono::microseconds(0),  // enqueue_delay
+                        std::chrono::microseconds(0),  // dequeue_delay
+                        60,                            // nb_slots
+                        2,                             // enqueue_batch_size
+                        3),                            // dequeue_batch_size
+        // 01
+        std::make_tuple(WaitPolicy::SpinYield,         // policy
+                        std::chrono::microseconds(10), // enqueue_delay
+                        std::chrono::microseconds(0),  // dequeue_delay
+                        60,                            // nb_slots
+                        2,                             // enqueue_batch_size
+                        3),                            // dequeue_batch_size
+        // 02
+        std::make_tuple(WaitPolicy::SpinPark,          // policy
+                        std::chrono::microseconds(10), // enqueue_delay
+                        std::chrono::microseconds(0),  // dequeue_delay
+                        60,                            // nb_slots
+                        2,                             // enqueue_batch_size
+                        3),                            // dequeue_batch_size
+        // 03
+        std::make_tuple(WaitPolicy::SpinPark,          // policy
+                        std::chrono::microseconds(0),  // enqueue_delay
+                        std::chrono::microseconds(10), // dequeue_delay
+                        60,                            // nb_slots
+                        3,                             // enqueue_batch_size
+                        2),                            // dequeue_batch_size
+        // 04
+        std::make_tuple(WaitPolicy::SpinPark,          // policy
+                        std::chrono::microseconds(0),  // enqueue_delay
+                        std::chrono::microseconds(0),  // dequeue_delay
+                        60,                            // nb_slots
+                        10,                            // enqueue_batch_size
+                        30)));                         // dequeue_batch_size
+
+TEST(BatchedSPSCQueueParkingTest, Timed_Wait_Times_Out) {
+  std::vector<uint8_t> buffer(10);
+  BatchedSPSCQueue queue(10, 5, 5, sizeof(uint8_t), buffer.data());
+
+  for (WaitPolicy policy :
+       {WaitPolicy::Spin, WaitPolicy::SpinYield, WaitPolicy::SpinPark}) {
+    queue.set_wait_strategy({policy, 64, 16});
+
+    // Empty queue: nothing to read.
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(queue.wait_read_ptr(std::chrono::milliseconds(20)), nullptr);
+    EXPECT_GE(std::chrono::steady_clock::now() - start,
+              std::chrono::milliseconds(20));
+
+    // Full queue: nothing to write.
+    ASSERT_TRUE(queue.wait_write_ptr(std::chrono::milliseconds(20)));
+    queue.commit_write();
+    start = std::chrono::steady_clock::now();
+    EXPECT_EQ(queue.wait_write_ptr(std::chrono::milliseconds(20)), nullptr);
+    EXPECT_GE(std::chrono::steady_clock::now() - start,
+              std::chrono::milliseconds(20));
+
+    // A batch is available right away.
+    EXPECT_TRUE(queue.wait_read_ptr(std::chrono::milliseconds(20)));
+    queue.commit_read();
+  }
+}
+
+TEST(BatchedSPSCQueueParkingTest, Parked_Reader_Is_Woken_Up) {
+  std::vector<uint8_t> buffer(10);
+  BatchedSPSCQueue queue(10, 1, 1, sizeof(uint8_t), buffer.data());
+  queue.set_wait_strategy({WaitPolicy::SpinPark, 0, 0});
+
+  std::thread dequeue_thread([&queue]() {
+    uint8_t *read_ptr = queue.wait_read_ptr(std::chrono::seconds(10));
+    ASSERT_TRUE(read_ptr);
+    EXPECT_EQ(read_ptr[0], 42);
+    queue.commit_read();
+  });
+
+  // Give the reader time to park.
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  auto start = std::chrono::steady_clock::now();
+  uint8_t *write_ptr = queue.write_ptr();
+  ASSERT_TRUE(write_ptr);
+  write_ptr[0] = 42;
+  queue.commit_write();
+  dequeue_thread.join();
+
+  // The reader was woken up by the commit, not by its timeout.
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+}
+
+} // namespace holoflow
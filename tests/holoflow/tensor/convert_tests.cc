@@ -0,0 +1,192 @@
+#include "holoflow/tensor/convert.hh"
+#include "holoflow/tensor/tensor.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace holoflow {
+
+/// Returns the element at `element` of type `dtype`, as a `double`.
+static double read(DType dtype, const std::byte *element) {
+  auto as = [element]<typename T>(T) {
+    T value;
+    std::memcpy(&value, element, sizeof(T));
+    return static_cast<double>(value);
+  };
+  switch (dtype) {
+  case DType::U8:
+    return as(uint8_t{});
+  case DType::U16:
+    return as(uint16_t{});
+  case DType::I16:
+    return as(int16_t{});
+  case DType::F32:
+    return as(float{});
+  default:
+    return as(double{});
+  }
+}
+
+/// Stores `value` at `element` as type `dtype`.
+static void write(DType dtype, std::byte *element, double value) {
+  auto as = [element, value]<typename T>(T) {
+    T typed = static_cast<T>(value);
+    std::memcpy(element, &typed, sizeof(T));
+  };
+  switch (dtype) {
+  case DType::U8:
+    return as(uint8_t{});
+  case DType::U16:
+    return as(uint16_t{});
+  case DType::I16:
+    return as(int16_t{});
+  case DType::F32:
+    return as(float{});
+  default:
+    return as(double{});
+  }
+}
+
+/// Returns the `i`-th test input of type `dtype`.
+static double input(DType dtype, size_t i) {
+  const size_t hash = i * 2654435761u;
+  switch (dtype) {
+  case DType::U8:
+    return static_cast<double>(hash % 256);
+  case DType::U16:
+    return static_cast<double>(hash % 65536);
+  case DType::I16:
+    return static_cast<double>(hash % 65536) - 32768;
+  default:
+    // Multiples of 1/8 from -1000 to 20000, so that the scale and offset of
+    // the narrowing tests give ties and saturate both ways.
+    if (i % 97 == 5)
+      return std::numeric_limits<double>::quiet_NaN();
+    if (i % 97 == 6)
+      return std::numeric_limits<double>::infinity();
+    return static_cast<double>(hash % 168000) * 0.125 - 1000;
+  }
+}
+
+/// Returns the lowest and highest values of the integer type `dtype`.
+static std::pair<double, double> range(DType dtype) {
+  switch (dtype) {
+  case DType::U8:
+    return {0, 255};
+  case DType::U16:
+    return {0, 65535};
+  default:
+    return {-32768, 32767};
+  }
+}
+
+class ConvertTest
+    : public testing::TestWithParam<
+          std::tuple<SimdLevel, std::tuple<DType, DType, size_t, bool>>> {};
+
+TEST_P(ConvertTest, Matches_Scalar_Reference) {
+  auto [level, conversion] = GetParam();
+  auto [src_dtype, dst_dtype, cols, strided] = conversion;
+  const size_t rows = 3;
+  const size_t src_size = dtype_size(src_dtype);
+  const size_t dst_size = dtype_size(dst_dtype);
+  const bool widen = dst_dtype == DType::F32 || dst_dtype == DType::F64;
+
+  // Padded rows, and every other or third element if strided.
+  const size_t src_step = strided ? 2 : 1;
+  const size_t dst_step = strided ? 3 : 1;
+  const size_t src_pitch = (cols * src_step + 5) * src_size;
+  const size_t dst_pitch = (cols * dst_step + 3) * dst_size;
+  std::vector<std::byte> src_buffer(rows * src_pitch);
+  std::vector<std::byte> dst_buffer(rows * dst_pitch);
+  Tensor src(TensorDescriptor(src_dtype, {rows, cols},
+                              {src_pitch, src_step * src_size}),
+             src_buffer.data());
+  Tensor dst(TensorDescriptor(dst_dtype, {rows, cols},
+                              {dst_pitch, dst_step * dst_size}),
+             dst_buffer.data());
+
+  // A scale of 4 keeps the products exact when narrowing, so that every level
+  // rounds the same values.
+  const double scale = widen ? 0.01 : 4;
+  const double offset = widen ? -1.5 : -100.5;
+  for (size_t i = 0; i < rows; i++)
+    for (size_t j = 0; j < cols; j++)
+      write(src_dtype,
+            src_buffer.data() + i * src_pitch + j * src_step * src_size,
+            input(src_dtype, i * cols + j));
+
+  convert(src, dst,
+          {.scale = scale, .offset = offset, .max_simd_level = level});
+
+  const bool single = src_dtype == DType::F32 || dst_dtype == DType::F32;
+  for (size_t i = 0; i < rows; i++) {
+    for (size_t j = 0; j < cols; j++) {
+      double value = input(src_dtype, i * cols + j);
+      double actual =
+          read(dst_dtype,
+               dst_buffer.data() + i * dst_pitch + j * dst_step * dst_size);
+
+      double expected;
+      if (single)
+        expected = static_cast<float>(value) * static_cast<float>(scale) +
+                   static_cast<float>(offset);
+      else
+        expected = value * scale + offset;
+
+      if (widen) {
+        double tolerance = (std::abs(expected) + 1) * (single ? 1e-6 : 1e-14);
+        ASSERT_NEAR(actual, expected, tolerance) << "at (" << i << ", " << j
+                                                 << ")";
+      } else {
+        auto [lowest, highest] = range(dst_dtype);
+        expected = std::isnan(expected) ? lowest : expected;
+        expected = std::nearbyint(std::clamp(expected, lowest, highest));
+        ASSERT_EQ(actual, expected) << "at (" << i << ", " << j << ")";
+      }
+    }
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    ConvertTests, ConvertTest,
+    testing::Combine(
+        testing::Values(SimdLevel::Scalar, SimdLevel::SSE4, SimdLevel::AVX2,
+                        SimdLevel::AVX512),
+        testing::Values(
+            std::make_tuple(DType::U8, DType::F32, 512, false),  // 00
+            std::make_tuple(DType::U16, DType::F32, 37, false),  // 01
+            std::make_tuple(DType::I16, DType::F32, 100, true),  // 02
+            std::make_tuple(DType::U8, DType::F64, 61, false),   // 03
+            std::make_tuple(DType::I16, DType::F64, 300, true),  // 04
+            std::make_tuple(DType::F32, DType::U8, 515, false),  // 05
+            std::make_tuple(DType::F32, DType::U16, 67, true),   // 06
+            std::make_tuple(DType::F32, DType::I16, 100, false), // 07
+            std::make_tuple(DType::F64, DType::U16, 45, false),  // 08
+            std::make_tuple(DType::F64, DType::I16, 300, true),  // 09
+            std::make_tuple(DType::F64, DType::U8, 1, false)))); // 10
+
+TEST(ConvertDeathTest, Unsupported_Conversions) {
+  std::vector<float> a(16);
+  std::vector<double> b(16);
+  std::vector<uint8_t> c(8);
+  Tensor f32(TensorDescriptor(DType::F32, {4, 4}, {16, 4}),
+             reinterpret_cast<std::byte *>(a.data()));
+  Tensor f64(TensorDescriptor(DType::F64, {4, 4}, {32, 8}),
+             reinterpret_cast<std::byte *>(b.data()));
+  Tensor u8(TensorDescriptor(DType::U8, {4, 2}, {2, 1}),
+            reinterpret_cast<std::byte *>(c.data()));
+
+  EXPECT_DEATH(convert(f32, f64), "");
+  EXPECT_DEATH(convert(f32, u8), "");
+}
+
+} // namespace holoflow
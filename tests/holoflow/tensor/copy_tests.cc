@@ -0,0 +1,139 @@
+#include "holoflow/tensor/copy.hh"
+#include "holoflow/tensor/tensor.hh"
+
+#include <complex>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace holoflow {
+
+/// Returns the element at `(i, j)` of a 2D tensor of `T`.
+template <typename T> static T at(const Tensor &tensor, size_t i, size_t j) {
+  return *reinterpret_cast<const T *>(tensor.raw_data() +
+                                      i * tensor.desc().strides()[0] +
+                                      j * tensor.desc().strides()[1]);
+}
+
+/// Returns a dense `rows x cols` tensor of `T` over `buffer`.
+template <typename T>
+static Tensor make_dense(std::vector<T> &buffer, size_t rows, size_t cols) {
+  buffer.assign(rows * cols, T{});
+  return Tensor(TensorDescriptor(dtype_of<T>, {rows, cols},
+                                 {cols * sizeof(T), sizeof(T)}),
+                reinterpret_cast<std::byte *>(buffer.data()));
+}
+
+class CopyLayoutTest
+    : public testing::TestWithParam<
+          std::tuple<size_t, size_t, size_t, bool, NonTemporal>> {};
+
+TEST_P(CopyLayoutTest, Padded_Source_To_Dense) {
+  auto [rows, cols, padding, transposed, non_temporal] = GetParam();
+
+  // The source is stored with padded rows, and read transposed if requested.
+  const size_t src_rows = transposed ? cols : rows;
+  const size_t src_cols = transposed ? rows : cols;
+  const size_t pitch = src_cols + padding;
+  std::vector<int32_t> src_buffer(src_rows * pitch);
+  for (size_t i = 0; i < src_buffer.size(); i++)
+    src_buffer[i] = static_cast<int32_t>(i);
+  Tensor src(TensorDescriptor(DType::I32, {src_rows, src_cols},
+                              {pitch * sizeof(int32_t), sizeof(int32_t)}),
+             reinterpret_cast<std::byte *>(src_buffer.data()));
+  if (transposed)
+    src = src.transpose(0, 1);
+
+  std::vector<int32_t> dst_buffer;
+  Tensor dst = make_dense(dst_buffer, rows, cols);
+  copy(src, dst, {.non_temporal = non_temporal});
+
+  for (size_t i = 0; i < rows; i++)
+    for (size_t j = 0; j < cols; j++)
+      ASSERT_EQ(at<int32_t>(dst, i, j), at<int32_t>(src, i, j))
+          << "at (" << i << ", " << j << ")";
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    CopyLayoutTests, CopyLayoutTest,
+    testing::Values(
+        // Inner runs.
+        std::make_tuple(7, 13, 0, false, NonTemporal::Never),      // 00
+        std::make_tuple(7, 13, 3, false, NonTemporal::Never),      // 01
+        std::make_tuple(5, 1000, 24, false, NonTemporal::Always),  // 02
+        std::make_tuple(64, 64, 0, false, NonTemporal::Always),    // 03
+        // Tiled transposes, with partial tiles.
+        std::make_tuple(32, 32, 0, true, NonTemporal::Never),      // 04
+        std::make_tuple(100, 37, 5, true, NonTemporal::Never),     // 05
+        std::make_tuple(1, 70, 2, true, NonTemporal::Auto),        // 06
+        std::make_tuple(129, 65, 0, true, NonTemporal::Always)));  // 07
+
+TEST(CopyTest, Strided_Crop_Of_A_3D_Tensor) {
+  // 2x6x8 uint16_t, of which every other column of a 2x3x5 crop is copied.
+  std::vector<uint16_t> src_buffer(2 * 6 * 8);
+  for (size_t i = 0; i < src_buffer.size(); i++)
+    src_buffer[i] = static_cast<uint16_t>(i);
+  Tensor tensor(TensorDescriptor(DType::U16, {2, 6, 8}, {96, 16, 2}),
+                reinterpret_cast<std::byte *>(src_buffer.data()));
+  Tensor src = tensor.crop({0, 1, 2}, {2, 3, 5}).slice(2, 0, 5, 2);
+
+  std::vector<uint16_t> dst_buffer(2 * 3 * 3);
+  Tensor dst(TensorDescriptor(DType::U16, {2, 3, 3}, {18, 6, 2}),
+             reinterpret_cast<std::byte *>(dst_buffer.data()));
+  copy(src, dst);
+
+  for (size_t i = 0; i < 2; i++)
+    for (size_t j = 0; j < 3; j++)
+      for (size_t k = 0; k < 3; k++)
+        EXPECT_EQ(dst_buffer[i * 9 + j * 3 + k],
+                  src_buffer[i * 48 + (j + 1) * 8 + 2 + 2 * k]);
+}
+
+TEST(CopyTest, Broadcast_Source) {
+  std::vector<double> row = {1.5, 2.5, 3.5};
+  Tensor src(TensorDescriptor(DType::F64, {3}, {8}),
+             reinterpret_cast<std::byte *>(row.data()));
+
+  std::vector<double> dst_buffer;
+  Tensor dst = make_dense(dst_buffer, 4, 3);
+  copy(src.broadcast({4, 3}), dst);
+
+  for (size_t i = 0; i < 4; i++)
+    for (size_t j = 0; j < 3; j++)
+      EXPECT_EQ(at<double>(dst, i, j), row[j]);
+}
+
+TEST(CopyTest, Complex_Transpose_Into_Padded_Destination) {
+  using Complex = std::complex<double>;
+  std::vector<Complex> src_buffer;
+  Tensor src = make_dense(src_buffer, 40, 3);
+  for (size_t i = 0; i < src_buffer.size(); i++)
+    src_buffer[i] = Complex(static_cast<double>(i), -static_cast<double>(i));
+
+  std::vector<Complex> dst_buffer(3 * 48);
+  Tensor dst(TensorDescriptor(DType::Complex128, {3, 40},
+                              {48 * sizeof(Complex), sizeof(Complex)}),
+             reinterpret_cast<std::byte *>(dst_buffer.data()));
+  copy(src.transpose(0, 1), dst);
+
+  for (size_t i = 0; i < 3; i++)
+    for (size_t j = 0; j < 40; j++)
+      EXPECT_EQ(at<Complex>(dst, i, j), src_buffer[j * 3 + i]);
+  EXPECT_EQ(dst_buffer[40], Complex());
+}
+
+TEST(CopyTest, Mismatched_Tensors) {
+  std::vector<float> a_buffer;
+  std::vector<float> b_buffer;
+  std::vector<int32_t> c_buffer;
+  Tensor a = make_dense(a_buffer, 4, 4);
+  Tensor b = make_dense(b_buffer, 4, 2);
+  Tensor c = make_dense(c_buffer, 4, 4);
+
+  EXPECT_DEATH(copy(a, b), "");
+  EXPECT_DEATH(copy(a, c), "");
+}
+
+} // namespace holoflow
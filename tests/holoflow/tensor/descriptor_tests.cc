@@ -1,50 +1,80 @@
 #include "holoflow/tensor/descriptor.hh"
 
+#include <vector>
+
 #include <gtest/gtest.h>
 
 namespace holoflow {
 
 TEST(TensorDescriptorTest, ConstructorInitialization) {
-  TensorDescriptor desc("float", sizeof(float), {4, 4}, {16, 4});
-  EXPECT_EQ(desc.type_name(), "float");
+  TensorDescriptor desc(DType::F32, {4, 4}, {16, 4});
+  EXPECT_EQ(desc.dtype(), DType::F32);
+  EXPECT_EQ(desc.type_name(), "f32");
   EXPECT_EQ(desc.type_size(), sizeof(float));
   EXPECT_EQ(desc.shape(), std::vector<std::size_t>({4, 4}));
   EXPECT_EQ(desc.strides(), std::vector<std::size_t>({16, 4}));
 }
 
 TEST(TensorDescriptorTest, ConstructorThrowsForMismatchedShapeAndStrides) {
-  EXPECT_DEATH(TensorDescriptor("float", sizeof(float), {4, 4}, {16}), "");
+  EXPECT_DEATH(TensorDescriptor(DType::F32, {4, 4}, {16}), "");
 }
 
 TEST(TensorDescriptorTest, ConstructorThrowsForIncompatibleStrides) {
-  EXPECT_DEATH(TensorDescriptor("float", sizeof(float), {4, 4}, {8, 4}), "");
+  EXPECT_DEATH(TensorDescriptor(DType::F32, {4, 4}, {8, 4}), "");
 }
 
 TEST(TensorDescriptorTest, ConstructorAllowsEmptyShape) {
-  TensorDescriptor desc("float", sizeof(float), {}, {});
+  TensorDescriptor desc(DType::F32, {}, {});
   EXPECT_TRUE(desc.shape().empty());
   EXPECT_TRUE(desc.strides().empty());
 }
 
+TEST(TensorDescriptorTest, ConstructorThrowsForTooManyDimensions) {
+  std::vector<std::size_t> shape(MAX_TENSOR_RANK + 1, 1);
+  std::vector<std::size_t> strides(MAX_TENSOR_RANK + 1, sizeof(float));
+  EXPECT_DEATH(TensorDescriptor(DType::F32, shape, strides), "");
+}
+
+TEST(TensorDescriptorTest, CopyKeepsEverything) {
+  TensorDescriptor desc(DType::Complex64, {2, 3, 4}, {128, 32, 8});
+  TensorDescriptor copy = desc;
+  EXPECT_EQ(copy.dtype(), DType::Complex64);
+  EXPECT_EQ(copy.shape(), std::vector<std::size_t>({2, 3, 4}));
+  EXPECT_EQ(copy.strides(), std::vector<std::size_t>({128, 32, 8}));
+  EXPECT_EQ(copy, desc);
+}
+
 TEST(TensorDescriptorTest, EqualityOperator) {
-  TensorDescriptor desc1("float", sizeof(float), {4, 4}, {16, 4});
-  TensorDescriptor desc2("float", sizeof(float), {4, 4}, {16, 4});
+  TensorDescriptor desc1(DType::F32, {4, 4}, {16, 4});
+  TensorDescriptor desc2(DType::F32, {4, 4}, {16, 4});
   EXPECT_TRUE(desc1 == desc2);
 }
 
 TEST(TensorDescriptorTest, InequalityOperator) {
-  TensorDescriptor desc1("float", sizeof(float), {4, 4}, {16, 4});
-  TensorDescriptor desc2("float", sizeof(float), {4, 5}, {20, 4});
+  TensorDescriptor desc1(DType::F32, {4, 4}, {16, 4});
+  TensorDescriptor desc2(DType::F32, {4, 5}, {20, 4});
+  EXPECT_TRUE(desc1 != desc2);
+}
+
+TEST(TensorDescriptorTest, InequalityOperatorSameSizeTypes) {
+  TensorDescriptor desc1(DType::F32, {4, 4}, {16, 4});
+  TensorDescriptor desc2(DType::I32, {4, 4}, {16, 4});
   EXPECT_TRUE(desc1 != desc2);
 }
 
 TEST(TensorDescriptorTest, SizeInBytesNonEmpty) {
-  TensorDescriptor desc("float", sizeof(float), {4, 4}, {16, 4});
+  TensorDescriptor desc(DType::F32, {4, 4}, {16, 4});
   EXPECT_EQ(desc.size_in_bytes(), 4 * 16); // 4 rows * 16 bytes per row
 }
 
+TEST(TensorDescriptorTest, SizeInBytesOfCrop) {
+  // A 100x100 crop of a frame of 128 floats per row spans whole rows.
+  TensorDescriptor crop(DType::F32, {100, 100}, {512, 4});
+  EXPECT_EQ(crop.size_in_bytes(), 100 * 512);
+}
+
 TEST(TensorDescriptorTest, SizeInBytesEmpty) {
-  TensorDescriptor desc("float", sizeof(float), {}, {});
+  TensorDescriptor desc(DType::F32, {}, {});
   EXPECT_EQ(desc.size_in_bytes(), 0);
 }
 
@@ -0,0 +1,238 @@
+#include "holoflow/tensor/fft.hh"
+#include "holoflow/tensor/tensor.hh"
+#include "holoflow/tensor/thread_pool.hh"
+
+#include <cmath>
+#include <complex>
+#include <cstring>
+#include <numbers>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace holoflow {
+
+using Complex = std::complex<double>;
+
+/// Returns the direct DFT of `x`, of sign -1 for the forward transform.
+static std::vector<Complex> dft(const std::vector<Complex> &x, int sign) {
+  const size_t n = x.size();
+  std::vector<Complex> y(n);
+  for (size_t k = 0; k < n; k++) {
+    std::complex<long double> sum = 0;
+    for (size_t j = 0; j < n; j++) {
+      long double angle = sign * 2 * std::numbers::pi_v<long double> *
+                          static_cast<long double>(j * k % n) / n;
+      sum += std::complex<long double>(x[j].real(), x[j].imag()) *
+             std::polar(1.0L, angle);
+    }
+    y[k] = Complex(static_cast<double>(sum.real()),
+                   static_cast<double>(sum.imag()));
+  }
+  return y;
+}
+
+/// A 2D complex tensor of `dtype` over its own buffer, dense or with its rows
+/// padded.
+struct TestFrame {
+  TestFrame(DType dtype, size_t rows, size_t cols, size_t padding)
+      : dtype(dtype), rows(rows), cols(cols), pitch(cols + padding) {
+    buffer.resize(rows * pitch * dtype_size(dtype));
+  }
+
+  Tensor tensor() {
+    const size_t size = dtype_size(dtype);
+    return Tensor(TensorDescriptor(dtype, {rows, cols}, {pitch * size, size}),
+                  buffer.data());
+  }
+
+  Complex get(size_t i, size_t j) const {
+    const std::byte *element =
+        buffer.data() + (i * pitch + j) * dtype_size(dtype);
+    if (dtype == DType::Complex64) {
+      std::complex<float> value;
+      std::memcpy(&value, element, sizeof(value));
+      return Complex(value.real(), value.imag());
+    }
+    Complex value;
+    std::memcpy(&value, element, sizeof(value));
+    return value;
+  }
+
+  void set(size_t i, size_t j, Complex value) {
+    std::byte *element = buffer.data() + (i * pitch + j) * dtype_size(dtype);
+    if (dtype == DType::Complex64) {
+      std::complex<float> narrow(static_cast<float>(value.real()),
+                                 static_cast<float>(value.imag()));
+      std::memcpy(element, &narrow, sizeof(narrow));
+    } else {
+      std::memcpy(element, &value, sizeof(value));
+    }
+  }
+
+  DType dtype;
+  size_t rows;
+  size_t cols;
+  size_t pitch;
+  std::vector<std::byte> buffer;
+};
+
+class FftTest
+    : public testing::TestWithParam<
+          std::tuple<SimdLevel,
+                     std::tuple<DType, size_t, size_t, size_t, bool>>> {};
+
+TEST_P(FftTest, Matches_Direct_Dft) {
+  auto [level, params] = GetParam();
+  auto [dtype, rows, cols, nb_axes, in_place] = params;
+  const double tolerance = dtype == DType::Complex64 ? 1e-5 : 1e-12;
+
+  TestFrame src(dtype, rows, cols, 3);
+  for (size_t i = 0; i < rows; i++)
+    for (size_t j = 0; j < cols; j++)
+      src.set(i, j, Complex(std::sin(0.37 * i + 1.3 * j), std::cos(0.11 * j)));
+
+  // The reference transforms the rows, then the columns.
+  std::vector<std::vector<Complex>> expected(rows);
+  for (size_t i = 0; i < rows; i++) {
+    std::vector<Complex> row(cols);
+    for (size_t j = 0; j < cols; j++)
+      row[j] = src.get(i, j);
+    expected[i] = dft(row, -1);
+  }
+  if (nb_axes == 2) {
+    for (size_t j = 0; j < cols; j++) {
+      std::vector<Complex> col(rows);
+      for (size_t i = 0; i < rows; i++)
+        col[i] = expected[i][j];
+      col = dft(col, -1);
+      for (size_t i = 0; i < rows; i++)
+        expected[i][j] = col[i];
+    }
+  }
+  double norm = 0;
+  for (const std::vector<Complex> &row : expected)
+    for (Complex value : row)
+      norm = std::max(norm, std::abs(value));
+
+  ThreadPool pool(3);
+  FftOptions options{.pool = &pool, .max_simd_level = level};
+  TestFrame dst(dtype, rows, cols, 0);
+  TestFrame &out = in_place ? src : dst;
+  Tensor input = src.tensor();
+  Tensor output = out.tensor();
+  if (nb_axes == 1)
+    fft(input, output, options);
+  else
+    fft2(input, output, options);
+
+  for (size_t i = 0; i < rows; i++)
+    for (size_t j = 0; j < cols; j++)
+      ASSERT_LT(std::abs(out.get(i, j) - expected[i][j]),
+                tolerance * (norm + 1))
+          << "at (" << i << ", " << j << ")";
+
+  // The inverse transform gives the input back.
+  options.direction = FftDirection::Inverse;
+  if (nb_axes == 1)
+    fft(output, output, options);
+  else
+    fft2(output, output, options);
+  for (size_t i = 0; i < rows; i++)
+    for (size_t j = 0; j < cols; j++)
+      ASSERT_LT(std::abs(out.get(i, j) -
+                         Complex(std::sin(0.37 * i + 1.3 * j),
+                                 std::cos(0.11 * j))),
+                tolerance * 10)
+          << "at (" << i << ", " << j << ")";
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    FftTests, FftTest,
+    testing::Combine(
+        testing::Values(SimdLevel::Scalar, SimdLevel::SSE4, SimdLevel::AVX2,
+                        SimdLevel::AVX512),
+        testing::Values(
+            std::make_tuple(DType::Complex64, 1, 1, 1, false),     // 00
+            std::make_tuple(DType::Complex64, 5, 64, 1, false),    // 01
+            std::make_tuple(DType::Complex128, 3, 60, 1, true),    // 02
+            std::make_tuple(DType::Complex128, 20, 97, 1, false),  // 03
+            std::make_tuple(DType::Complex64, 32, 32, 2, false),   // 04
+            std::make_tuple(DType::Complex64, 18, 50, 2, true),    // 05
+            std::make_tuple(DType::Complex128, 12, 35, 2, false),  // 06
+            std::make_tuple(DType::Complex128, 49, 8, 2, true),    // 07
+            std::make_tuple(DType::Complex64, 1, 2048, 2, true)))); // 08
+
+TEST(FftPlanTest, Plans_Are_Cached_By_Layout) {
+  TestFrame a(DType::Complex64, 8, 8, 0);
+  TestFrame b(DType::Complex64, 8, 8, 0);
+  TestFrame padded(DType::Complex64, 8, 8, 1);
+
+  auto plan = FftPlan::cached(a.tensor().desc(), b.tensor().desc(), 2);
+  EXPECT_EQ(FftPlan::cached(b.tensor().desc(), a.tensor().desc(), 2), plan);
+  EXPECT_NE(FftPlan::cached(padded.tensor().desc(), b.tensor().desc(), 2),
+            plan);
+  EXPECT_NE(FftPlan::cached(a.tensor().desc(), b.tensor().desc(), 1), plan);
+}
+
+TEST(FftPlanTest, Least_Recently_Used_Plans_Are_Dropped) {
+  // Frames of distinct widths, all but the first one used once.
+  std::vector<TestFrame> frames;
+  for (size_t i = 0; i <= FFT_PLAN_CACHE_SIZE; i++)
+    frames.emplace_back(DType::Complex64, 2, i + 1, 0);
+  auto descriptor = [&frames](size_t i) { return frames[i].tensor().desc(); };
+
+  auto first = FftPlan::cached(descriptor(0), descriptor(0), 1);
+  auto second = FftPlan::cached(descriptor(1), descriptor(1), 1);
+  for (size_t i = 2; i < FFT_PLAN_CACHE_SIZE; i++) {
+    FftPlan::cached(descriptor(i), descriptor(i), 1);
+    EXPECT_EQ(FftPlan::cached(descriptor(0), descriptor(0), 1), first);
+  }
+
+  // The cache is full, the next plan drops the second one.
+  FftPlan::cached(descriptor(FFT_PLAN_CACHE_SIZE),
+                  descriptor(FFT_PLAN_CACHE_SIZE), 1);
+  EXPECT_EQ(FftPlan::cached(descriptor(0), descriptor(0), 1), first);
+  EXPECT_NE(FftPlan::cached(descriptor(1), descriptor(1), 1), second);
+}
+
+TEST(FftPlanTest, Batch_Of_Frames) {
+  // Two frames transformed at once match each transformed on its own.
+  const size_t size = 16;
+  std::vector<std::complex<float>> batch(2 * size * size);
+  for (size_t i = 0; i < batch.size(); i++)
+    batch[i] = std::complex<float>(static_cast<float>(i % 13), 1);
+  std::vector<std::complex<float>> frames = batch;
+
+  Tensor batch_tensor(TensorDescriptor(DType::Complex64, {2, size, size},
+                                       {size * size * 8, size * 8, 8}),
+                      reinterpret_cast<std::byte *>(batch.data()));
+  fft2(batch_tensor, batch_tensor);
+  for (size_t f = 0; f < 2; f++) {
+    Tensor frame(TensorDescriptor(DType::Complex64, {size, size},
+                                  {size * 8, 8}),
+                 reinterpret_cast<std::byte *>(frames.data() +
+                                               f * size * size));
+    fft2(frame, frame);
+  }
+  for (size_t i = 0; i < batch.size(); i++)
+    ASSERT_EQ(batch[i], frames[i]) << "at " << i;
+}
+
+TEST(FftPlanTest, Invalid_Transforms) {
+  std::vector<std::complex<float>> buffer(16);
+  auto *data = reinterpret_cast<std::byte *>(buffer.data());
+  Tensor real(TensorDescriptor(DType::F32, {4, 4}, {16, 4}), data);
+  Tensor frame(TensorDescriptor(DType::Complex64, {4, 4}, {32, 8}), data);
+  Tensor other(TensorDescriptor(DType::Complex64, {2, 8}, {64, 8}), data);
+  Tensor row(TensorDescriptor(DType::Complex64, {16}, {8}), data);
+
+  EXPECT_DEATH(fft(real, real), "");
+  EXPECT_DEATH(fft2(frame, other), "");
+  EXPECT_DEATH(fft2(row, row), "");
+  auto plan = FftPlan::cached(frame.desc(), frame.desc(), 2);
+  EXPECT_DEATH(plan->execute(other, other), "");
+}
+
+} // namespace holoflow
@@ -0,0 +1,296 @@
+#include "holoflow/tensor/reduce.hh"
+#include "holoflow/tensor/tensor.hh"
+#include "holoflow/tensor/thread_pool.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace holoflow {
+
+/// Returns the element at `element` of type `dtype`, as a `double`.
+static double read(DType dtype, const std::byte *element) {
+  auto as = [element]<typename T>(T) {
+    T value;
+    std::memcpy(&value, element, sizeof(T));
+    return static_cast<double>(value);
+  };
+  switch (dtype) {
+  case DType::U8:
+    return as(uint8_t{});
+  case DType::U16:
+    return as(uint16_t{});
+  case DType::I32:
+    return as(int32_t{});
+  case DType::F32:
+    return as(float{});
+  default:
+    return as(double{});
+  }
+}
+
+/// Stores the `i`-th test value of type `dtype` at `element`.
+static void write(DType dtype, std::byte *element, size_t i) {
+  auto as = [element]<typename T>(T value) {
+    std::memcpy(element, &value, sizeof(T));
+  };
+  const size_t hash = i * 2654435761u % 100003;
+  switch (dtype) {
+  case DType::U8:
+    return as(static_cast<uint8_t>(hash));
+  case DType::U16:
+    return as(static_cast<uint16_t>(hash));
+  case DType::I32:
+    return as(static_cast<int32_t>(hash) - 50000);
+  case DType::F32:
+    return as(1000.0f + static_cast<float>(hash) * 1e-3f);
+  default:
+    return as(-5.0 + static_cast<double>(hash) * 1e-4);
+  }
+}
+
+/// A 3D tensor of `dtype` filled with test values, dense or with its rows
+/// padded and its last two dimensions transposed.
+struct TestTensor {
+  TestTensor(DType dtype, size_t d0, size_t d1, size_t d2, bool strided) {
+    const size_t size = dtype_size(dtype);
+    const size_t pitch = (strided ? d2 + 3 : d2) * size;
+    buffer.resize(d0 * d1 * pitch);
+    Tensor dense(TensorDescriptor(dtype, {d0, d1, d2},
+                                  {d1 * pitch, pitch, size}),
+                 buffer.data());
+    for (size_t i = 0; i < d0; i++)
+      for (size_t j = 0; j < d1; j++)
+        for (size_t k = 0; k < d2; k++)
+          write(dtype, dense.raw_data() + i * d1 * pitch + j * pitch + k * size,
+                (i * d1 + j) * d2 + k);
+    tensor = strided ? dense.transpose(1, 2) : dense;
+  }
+
+  /// Returns the element at `(i, j, k)`.
+  double at(size_t i, size_t j, size_t k) const {
+    const Dims &strides = tensor.desc().strides();
+    return read(tensor.desc().dtype(),
+                tensor.raw_data() + i * strides[0] + j * strides[1] +
+                    k * strides[2]);
+  }
+
+  /// Returns the relative error allowed on sums, which `F32` tensors
+  /// accumulate in `float` lanes.
+  double tolerance() const {
+    return tensor.desc().dtype() == DType::F32 ? 1e-6 : 1e-12;
+  }
+
+  std::vector<std::byte> buffer;
+  Tensor tensor{TensorDescriptor(DType::U8, {0}, {1}), nullptr};
+};
+
+class ReduceTest
+    : public testing::TestWithParam<
+          std::tuple<SimdLevel,
+                     std::tuple<DType, size_t, size_t, size_t, bool, size_t>>> {
+};
+
+TEST_P(ReduceTest, Stats_Match_Reference) {
+  auto [level, params] = GetParam();
+  auto [dtype, d0, d1, d2, strided, nb_threads] = params;
+  TestTensor test(dtype, d0, d1, d2, strided);
+  const Dims &shape = test.tensor.desc().shape();
+
+  long double sum = 0;
+  double min = std::numeric_limits<double>::infinity();
+  double max = -std::numeric_limits<double>::infinity();
+  for (size_t i = 0; i < shape[0]; i++) {
+    for (size_t j = 0; j < shape[1]; j++) {
+      for (size_t k = 0; k < shape[2]; k++) {
+        double value = test.at(i, j, k);
+        sum += value;
+        min = std::min(min, value);
+        max = std::max(max, value);
+      }
+    }
+  }
+  const size_t count = d0 * d1 * d2;
+  const long double mean = sum / count;
+  long double m2 = 0;
+  for (size_t i = 0; i < shape[0]; i++)
+    for (size_t j = 0; j < shape[1]; j++)
+      for (size_t k = 0; k < shape[2]; k++)
+        m2 += (test.at(i, j, k) - mean) * (test.at(i, j, k) - mean);
+
+  ThreadPool pool(nb_threads);
+  ReduceOptions options{
+      .pool = &pool, .min_task_size = 1000, .max_simd_level = level};
+  TensorStats stats = holoflow::stats(test.tensor, options);
+
+  EXPECT_EQ(stats.count, count);
+  EXPECT_EQ(stats.min, min);
+  EXPECT_EQ(stats.max, max);
+  EXPECT_NEAR(stats.sum, static_cast<double>(sum),
+              std::abs(static_cast<double>(sum)) * test.tolerance() + 1e-9);
+  EXPECT_NEAR(stats.mean, static_cast<double>(mean),
+              std::abs(static_cast<double>(mean)) * test.tolerance());
+  EXPECT_NEAR(stats.variance, static_cast<double>(m2 / count),
+              static_cast<double>(m2 / count) * 1e-6);
+  EXPECT_EQ(holoflow::sum(test.tensor, options), stats.sum);
+}
+
+TEST_P(ReduceTest, Axis_Sums_Match_Reference) {
+  auto [level, params] = GetParam();
+  auto [dtype, d0, d1, d2, strided, nb_threads] = params;
+  TestTensor test(dtype, d0, d1, d2, strided);
+  const Dims &shape = test.tensor.desc().shape();
+  ThreadPool pool(nb_threads);
+  ReduceOptions options{
+      .pool = &pool, .min_task_size = 1000, .max_simd_level = level};
+
+  for (size_t axis = 0; axis < 3; axis++) {
+    Dims out_shape;
+    for (size_t d = 0; d < 3; d++)
+      if (d != axis)
+        out_shape.push_back(shape[d]);
+    std::vector<double> sums(out_shape[0] * out_shape[1]);
+    std::vector<float> means(sums.size());
+    Tensor sum_tensor(TensorDescriptor(DType::F64, out_shape,
+                                       {out_shape[1] * sizeof(double),
+                                        sizeof(double)}),
+                      reinterpret_cast<std::byte *>(sums.data()));
+    Tensor mean_tensor(TensorDescriptor(DType::F32, out_shape,
+                                        {out_shape[1] * sizeof(float),
+                                         sizeof(float)}),
+                       reinterpret_cast<std::byte *>(means.data()));
+    holoflow::sum(test.tensor, axis, sum_tensor, options);
+    holoflow::mean(test.tensor, axis, mean_tensor, options);
+
+    for (size_t a = 0; a < out_shape[0]; a++) {
+      for (size_t b = 0; b < out_shape[1]; b++) {
+        long double expected = 0;
+        for (size_t r = 0; r < shape[axis]; r++) {
+          size_t index[3];
+          index[axis] = r;
+          index[axis == 0 ? 1 : 0] = a;
+          index[axis == 2 ? 1 : 2] = b;
+          expected += test.at(index[0], index[1], index[2]);
+        }
+        const double reference = static_cast<double>(expected);
+        const double mean = reference / static_cast<double>(shape[axis]);
+        ASSERT_NEAR(sums[a * out_shape[1] + b], reference,
+                    std::abs(reference) * test.tolerance() + 1e-9)
+            << "axis " << axis << " at (" << a << ", " << b << ")";
+        ASSERT_NEAR(means[a * out_shape[1] + b], mean,
+                    std::abs(mean) * (test.tolerance() + 1e-7))
+            << "axis " << axis << " at (" << a << ", " << b << ")";
+      }
+    }
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    ReduceTests, ReduceTest,
+    testing::Combine(
+        testing::Values(SimdLevel::Scalar, SimdLevel::SSE4, SimdLevel::AVX2,
+                        SimdLevel::AVX512),
+        testing::Values(
+            std::make_tuple(DType::U8, 4, 30, 50, false, 1),      // 00
+            std::make_tuple(DType::U16, 3, 17, 1100, true, 4),    // 01
+            std::make_tuple(DType::I32, 1, 1, 5000, false, 3),    // 02
+            std::make_tuple(DType::F32, 10, 64, 64, false, 4),    // 03
+            std::make_tuple(DType::F32, 5, 33, 70, true, 2),      // 04
+            std::make_tuple(DType::F64, 7, 1, 2049, false, 4),    // 05
+            std::make_tuple(DType::F64, 2, 1500, 3, true, 1)))); // 06
+
+TEST(ReduceBatchTest, Float_Batch_Keeps_Precision) {
+  // 1000 frames of 64x64 values around 1000, whose spread is much smaller
+  // than their magnitude.
+  const size_t nb_elements = 1000 * 64 * 64;
+  std::vector<float> buffer(nb_elements);
+  for (size_t i = 0; i < nb_elements; i++)
+    buffer[i] = 1000.0f + static_cast<float>(i % 7) * 0.125f;
+  Tensor batch(TensorDescriptor(DType::F32, {1000, 64, 64},
+                                {64 * 64 * 4, 64 * 4, 4}),
+               reinterpret_cast<std::byte *>(buffer.data()));
+
+  // The mean of i % 7 over the batch, and its variance.
+  long double sum = 0;
+  long double sum_squares = 0;
+  for (size_t i = 0; i < nb_elements; i++) {
+    sum += i % 7;
+    sum_squares += (i % 7) * (i % 7);
+  }
+  const long double mean = sum / nb_elements;
+  const long double variance = sum_squares / nb_elements - mean * mean;
+
+  ThreadPool pool(4);
+  TensorStats stats = holoflow::stats(batch, {.pool = &pool});
+  EXPECT_NEAR(stats.mean, static_cast<double>(1000 + mean * 0.125L), 1e-9);
+  EXPECT_NEAR(stats.variance,
+              static_cast<double>(variance * 0.125L * 0.125L), 1e-6);
+
+  // The temporal mean of each pixel.
+  std::vector<double> means(64 * 64);
+  Tensor frame(TensorDescriptor(DType::F64, {64, 64}, {64 * 8, 8}),
+               reinterpret_cast<std::byte *>(means.data()));
+  holoflow::mean(batch, 0, frame, {.pool = &pool});
+  for (size_t i = 0; i < means.size(); i++) {
+    long double expected = 0;
+    for (size_t t = 0; t < 1000; t++)
+      expected += buffer[t * 64 * 64 + i];
+    ASSERT_NEAR(means[i], static_cast<double>(expected / 1000), 1e-10)
+        << "at pixel " << i;
+  }
+}
+
+TEST(ReduceBatchTest, Empty_Tensor) {
+  Tensor empty(TensorDescriptor(DType::F32, {0, 4}, {16, 4}), nullptr);
+  TensorStats stats = holoflow::stats(empty);
+  EXPECT_EQ(stats.count, 0);
+  EXPECT_EQ(stats.sum, 0);
+  EXPECT_TRUE(std::isnan(stats.mean));
+  EXPECT_TRUE(std::isnan(stats.variance));
+}
+
+TEST(ReduceBatchTest, Empty_Axis_Reductions) {
+  // Nothing to write, even to a padded destination.
+  Tensor empty(TensorDescriptor(DType::F32, {2, 0, 3}, {0, 12, 4}), nullptr);
+  Tensor empty_dst(TensorDescriptor(DType::F64, {0, 3}, {32, 8}), nullptr);
+  holoflow::sum(empty, 0, empty_dst);
+  holoflow::mean(empty, 0, empty_dst);
+
+  // The sum of nothing is 0, its mean is undefined.
+  Tensor no_rows(TensorDescriptor(DType::F32, {0, 3}, {12, 4}), nullptr);
+  std::vector<double> buffer(3, 1.0);
+  Tensor sums(TensorDescriptor(DType::F64, {3}, {8}),
+              reinterpret_cast<std::byte *>(buffer.data()));
+  holoflow::sum(no_rows, 0, sums);
+  for (double value : buffer)
+    EXPECT_EQ(value, 0);
+  holoflow::mean(no_rows, 0, sums);
+  for (double value : buffer)
+    EXPECT_TRUE(std::isnan(value));
+}
+
+TEST(ReduceBatchTest, Invalid_Reductions) {
+  std::vector<std::complex<float>> complex_buffer(16);
+  std::vector<float> buffer(16);
+  Tensor complex(TensorDescriptor(DType::Complex64, {4, 4}, {32, 8}),
+                 reinterpret_cast<std::byte *>(complex_buffer.data()));
+  Tensor matrix(TensorDescriptor(DType::F32, {4, 4}, {16, 4}),
+                reinterpret_cast<std::byte *>(buffer.data()));
+  Tensor row(TensorDescriptor(DType::F32, {4}, {4}),
+             reinterpret_cast<std::byte *>(buffer.data()));
+  Tensor wrong_shape(TensorDescriptor(DType::F32, {3}, {4}),
+                     reinterpret_cast<std::byte *>(buffer.data()));
+
+  EXPECT_DEATH(holoflow::stats(complex), "");
+  EXPECT_DEATH(holoflow::sum(matrix, 2, row), "");
+  EXPECT_DEATH(holoflow::sum(matrix, 0, wrong_shape), "");
+}
+
+} // namespace holoflow
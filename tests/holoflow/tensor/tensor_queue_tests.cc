@@ -0,0 +1,89 @@
+#include "holoflow/tensor/tensor_queue.hh"
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace holoflow {
+
+TEST(TensorQueueTest, Batches_Are_Views_On_The_Buffer) {
+  // 2x3 frames of uint16_t, with rows padded to 8 bytes.
+  TensorDescriptor frame(DType::U16, {2, 3}, {8, 2});
+  std::vector<uint8_t> buffer(8 * frame.size_in_bytes());
+  TensorQueue queue(frame, 8, 2, 4, buffer.data());
+
+  Tensor *write_tensor = queue.write_tensor();
+  ASSERT_TRUE(write_tensor);
+  EXPECT_EQ(write_tensor->desc().shape(), std::vector<size_t>({2, 2, 3}));
+  EXPECT_EQ(write_tensor->desc().strides(), std::vector<size_t>({16, 8, 2}));
+  EXPECT_EQ(write_tensor->data<uint16_t>(),
+            reinterpret_cast<uint16_t *>(buffer.data()));
+  queue.commit_write();
+  EXPECT_FALSE(queue.read_tensor());
+
+  write_tensor = queue.write_tensor();
+  ASSERT_TRUE(write_tensor);
+  EXPECT_EQ(write_tensor->data<uint16_t>(),
+            reinterpret_cast<uint16_t *>(buffer.data() + 32));
+  queue.commit_write();
+
+  const Tensor *read_tensor = queue.read_tensor();
+  ASSERT_TRUE(read_tensor);
+  EXPECT_EQ(read_tensor->desc().shape(), std::vector<size_t>({4, 2, 3}));
+  EXPECT_EQ(read_tensor->desc().strides(), std::vector<size_t>({16, 8, 2}));
+  EXPECT_EQ(read_tensor->data<uint16_t>(),
+            reinterpret_cast<const uint16_t *>(buffer.data()));
+  queue.commit_read();
+  EXPECT_FALSE(queue.read_tensor());
+}
+
+TEST(TensorQueueTest, Tensors_Follow_Batch_Size_Changes) {
+  TensorDescriptor frame(DType::F32, {4}, {4});
+  std::vector<uint8_t> buffer(8 * frame.size_in_bytes());
+  TensorQueue queue(frame, 8, 1, 2, buffer.data());
+
+  queue.queue().request_enqueue_batch_size(2);
+  for (size_t i = 0; i < 2; i++) {
+    Tensor *write_tensor = queue.write_tensor();
+    ASSERT_TRUE(write_tensor);
+    EXPECT_EQ(write_tensor->desc().shape(), std::vector<size_t>({1, 4}));
+    queue.commit_write();
+  }
+
+  // The new size applies once the write index is a multiple of it.
+  Tensor *write_tensor = queue.write_tensor();
+  ASSERT_TRUE(write_tensor);
+  EXPECT_EQ(write_tensor->desc().shape(), std::vector<size_t>({2, 4}));
+  EXPECT_EQ(write_tensor->data<float>(),
+            reinterpret_cast<float *>(buffer.data() + 32));
+}
+
+TEST(TensorQueueTest, Frames_Go_Through) {
+  const size_t nb_frames = 1000;
+  TensorDescriptor frame(DType::I32, {3}, {4});
+  std::vector<uint8_t> buffer(64 * frame.size_in_bytes());
+  TensorQueue queue(frame, 64, 4, 8, buffer.data());
+
+  std::thread producer([&queue, nb_frames]() {
+    for (size_t i = 0; i < nb_frames; i += 4) {
+      Tensor *batch = queue.wait_write_tensor();
+      int32_t *data = batch->data<int32_t>();
+      for (size_t j = 0; j < 4 * 3; j++)
+        data[j] = static_cast<int32_t>(i * 3 + j);
+      queue.commit_write();
+    }
+  });
+
+  for (size_t i = 0; i < nb_frames; i += 8) {
+    const Tensor *batch = queue.wait_read_tensor();
+    const int32_t *data = batch->data<int32_t>();
+    for (size_t j = 0; j < 8 * 3; j++)
+      ASSERT_EQ(data[j], static_cast<int32_t>(i * 3 + j));
+    queue.commit_read();
+  }
+  producer.join();
+}
+
+} // namespace holoflow
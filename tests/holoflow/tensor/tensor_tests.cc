@@ -1,14 +1,17 @@
 #include "holoflow/tensor/descriptor.hh"
 #include "holoflow/tensor/tensor.hh"
 
+#include <cstdint>
 #include <memory>
+#include <optional>
+#include <vector>
 
 #include <gtest/gtest.h>
 
 namespace holoflow {
 
 TEST(TensorTest, ConstructorInitialization) {
-  TensorDescriptor desc("float", sizeof(float), {4, 4}, {16, 4});
+  TensorDescriptor desc(DType::F32, {4, 4}, {16, 4});
   auto buffer = std::make_unique<std::byte[]>(desc.size_in_bytes());
   Tensor tensor(desc, buffer.get());
   EXPECT_EQ(tensor.desc(), desc);
@@ -16,7 +19,7 @@ TEST(TensorTest, ConstructorInitialization) {
 }
 
 TEST(TensorTest, DataAccessCorrectType) {
-  TensorDescriptor desc("uint16_t", sizeof(uint16_t), {4, 4}, {8, 2});
+  TensorDescriptor desc(DType::U16, {4, 4}, {8, 2});
   auto buffer = std::make_unique<std::byte[]>(desc.size_in_bytes());
   Tensor tensor(desc, buffer.get());
   uint16_t *data = tensor.data<uint16_t>();
@@ -25,10 +28,115 @@ TEST(TensorTest, DataAccessCorrectType) {
 }
 
 TEST(TensorTest, DataAccessIncorrectTypeSize) {
-  TensorDescriptor desc("float", sizeof(float), {4, 4}, {16, 4});
+  TensorDescriptor desc(DType::F32, {4, 4}, {16, 4});
   auto buffer = std::make_unique<std::byte[]>(desc.size_in_bytes());
   Tensor tensor(desc, buffer.get());
-  EXPECT_DEATH(tensor.data<std::byte>(), "");
+  EXPECT_DEATH(tensor.data<uint8_t>(), "");
+}
+
+TEST(TensorTest, DataAccessIncorrectTypeSameSize) {
+  TensorDescriptor desc(DType::F32, {4, 4}, {16, 4});
+  auto buffer = std::make_unique<std::byte[]>(desc.size_in_bytes());
+  Tensor tensor(desc, buffer.get());
+  EXPECT_DEATH(tensor.data<int32_t>(), "");
+}
+
+/// Returns a dense 3x4 `int32_t` tensor holding 0 to 11 in `buffer`.
+static Tensor make_matrix(std::vector<int32_t> &buffer) {
+  buffer.resize(12);
+  for (size_t i = 0; i < buffer.size(); i++)
+    buffer[i] = static_cast<int32_t>(i);
+  return Tensor(TensorDescriptor(DType::I32, {3, 4}, {16, 4}),
+                reinterpret_cast<std::byte *>(buffer.data()));
+}
+
+/// Returns the element at `(i, j)` of a 2D `int32_t` tensor.
+static int32_t at(const Tensor &tensor, size_t i, size_t j) {
+  return *reinterpret_cast<const int32_t *>(
+      tensor.raw_data() + i * tensor.desc().strides()[0] +
+      j * tensor.desc().strides()[1]);
+}
+
+TEST(TensorTest, SliceSharesData) {
+  std::vector<int32_t> buffer;
+  Tensor matrix = make_matrix(buffer);
+
+  Tensor columns = matrix.slice(1, 1, 4, 2);
+  EXPECT_EQ(columns.desc().shape(), std::vector<std::size_t>({3, 2}));
+  EXPECT_EQ(columns.desc().strides(), std::vector<std::size_t>({16, 8}));
+  EXPECT_EQ(at(columns, 2, 1), 11);
+  EXPECT_FALSE(columns.is_contiguous());
+
+  Tensor rows = matrix.slice(0, 1, 3);
+  EXPECT_EQ(rows.raw_data(), matrix.raw_data() + 16);
+  EXPECT_TRUE(rows.is_contiguous());
+  EXPECT_DEATH(matrix.slice(0, 2, 4), "");
+}
+
+TEST(TensorTest, CropSelectsRegion) {
+  std::vector<int32_t> buffer;
+  Tensor matrix = make_matrix(buffer);
+
+  Tensor roi = matrix.crop({1, 1}, {2, 2});
+  EXPECT_EQ(roi.desc().shape(), std::vector<std::size_t>({2, 2}));
+  EXPECT_EQ(at(roi, 0, 0), 5);
+  EXPECT_EQ(at(roi, 1, 1), 10);
+  EXPECT_DEATH(matrix.crop({2, 0}, {2, 4}), "");
+}
+
+TEST(TensorTest, TransposeSwapsStrides) {
+  std::vector<int32_t> buffer;
+  Tensor matrix = make_matrix(buffer);
+
+  Tensor transposed = matrix.transpose(0, 1);
+  EXPECT_EQ(transposed.desc().shape(), std::vector<std::size_t>({4, 3}));
+  EXPECT_EQ(at(transposed, 3, 2), 11);
+  EXPECT_EQ(at(transposed, 1, 2), 9);
+  EXPECT_FALSE(transposed.is_contiguous());
+  EXPECT_EQ(transposed.desc().size_in_bytes(), matrix.desc().size_in_bytes());
+
+  Tensor back = transposed.permute({1, 0});
+  EXPECT_EQ(back.desc().strides(), matrix.desc().strides());
+  EXPECT_DEATH(matrix.permute({0, 0}), "");
+}
+
+TEST(TensorTest, ReshapeWhenLayoutAllows) {
+  std::vector<int32_t> buffer;
+  Tensor matrix = make_matrix(buffer);
+
+  std::optional<Tensor> flat = matrix.reshape({12});
+  ASSERT_TRUE(flat);
+  EXPECT_EQ(flat->desc().strides(), std::vector<std::size_t>({4}));
+
+  // Rows of a column crop can be split, but not merged.
+  Tensor columns = matrix.slice(1, 0, 3);
+  std::optional<Tensor> split = columns.reshape({3, 1, 3});
+  ASSERT_TRUE(split);
+  EXPECT_EQ(split->desc().strides(), std::vector<std::size_t>({16, 12, 4}));
+  EXPECT_FALSE(columns.reshape({9}));
+
+  // Every other column is evenly spaced, and can be merged.
+  std::optional<Tensor> even = matrix.slice(1, 0, 4, 2).reshape({6});
+  ASSERT_TRUE(even);
+  EXPECT_EQ(even->desc().strides(), std::vector<std::size_t>({8}));
+  EXPECT_FALSE(matrix.transpose(0, 1).reshape({12}));
+
+  std::optional<Tensor> rows = matrix.slice(0, 0, 2).reshape({2, 2, 2});
+  ASSERT_TRUE(rows);
+  EXPECT_EQ(rows->desc().strides(), std::vector<std::size_t>({16, 8, 4}));
+  EXPECT_DEATH(matrix.reshape({5, 2}), "");
+}
+
+TEST(TensorTest, BroadcastRepeatsWithZeroStrides) {
+  std::vector<int32_t> buffer;
+  Tensor matrix = make_matrix(buffer);
+
+  Tensor row = matrix.slice(0, 2, 3);
+  Tensor repeated = row.broadcast({2, 3, 4});
+  EXPECT_EQ(repeated.desc().shape(), std::vector<std::size_t>({2, 3, 4}));
+  EXPECT_EQ(repeated.desc().strides(), std::vector<std::size_t>({0, 0, 4}));
+  EXPECT_EQ(at(repeated.slice(0, 1, 2).reshape({3, 4}).value(), 1, 3), 11);
+  EXPECT_DEATH(matrix.broadcast({2, 4}), "");
 }
 
 } // namespace holoflow
@@ -0,0 +1,65 @@
+#include "holoflow/tensor/tensor.hh"
+#include "holoflow/tensor/tensor_view.hh"
+
+#include <cstdint>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace holoflow {
+
+TEST(TensorViewTest, Indexing_Follows_Strides) {
+  // 3x4 uint16_t with rows padded to 12 bytes.
+  std::vector<uint16_t> buffer(3 * 6);
+  Tensor tensor(TensorDescriptor(DType::U16, {3, 4}, {12, 2}),
+                reinterpret_cast<std::byte *>(buffer.data()));
+
+  TensorView<uint16_t, 2> view(tensor);
+  EXPECT_EQ(view.shape(0), 3);
+  EXPECT_EQ(view.shape(1), 4);
+  EXPECT_EQ(view.stride(0), 12);
+  for (size_t i = 0; i < 3; i++)
+    for (size_t j = 0; j < 4; j++)
+      view(i, j) = static_cast<uint16_t>(i * 10 + j);
+
+  EXPECT_EQ(buffer[0], 0);
+  EXPECT_EQ(buffer[3], 3);
+  EXPECT_EQ(buffer[6], 10);
+  EXPECT_EQ(buffer[15], 23);
+  EXPECT_EQ(&view(2, 1), buffer.data() + 13);
+}
+
+TEST(TensorViewTest, Contiguous_Rows) {
+  std::vector<float> buffer(2 * 3 * 8);
+  Tensor tensor(TensorDescriptor(DType::F32, {2, 3, 5}, {96, 32, 4}),
+                reinterpret_cast<std::byte *>(buffer.data()));
+
+  ContiguousTensorView<float, 3> view(tensor);
+  EXPECT_EQ(view.row(1, 2), buffer.data() + 24 + 16);
+  EXPECT_EQ(&view(1, 2, 3), buffer.data() + 24 + 16 + 3);
+
+  const Tensor &const_tensor = tensor;
+  TensorView<const float, 3> const_view(const_tensor);
+  EXPECT_EQ(&const_view(1, 2, 3), &view(1, 2, 3));
+}
+
+TEST(TensorViewTest, Wrong_Type_Or_Rank) {
+  std::vector<float> buffer(16);
+  Tensor tensor(TensorDescriptor(DType::F32, {4, 4}, {16, 4}),
+                reinterpret_cast<std::byte *>(buffer.data()));
+
+  EXPECT_DEATH((TensorView<int32_t, 2>(tensor)), "");
+  EXPECT_DEATH((TensorView<float, 3>(tensor)), "");
+}
+
+TEST(TensorViewTest, Strided_Inner_Dimension_Is_Not_Contiguous) {
+  std::vector<float> buffer(32);
+  Tensor tensor(TensorDescriptor(DType::F32, {4, 4}, {32, 8}),
+                reinterpret_cast<std::byte *>(buffer.data()));
+
+  TensorView<float, 2> view(tensor);
+  EXPECT_EQ(&view(1, 1), buffer.data() + 10);
+  EXPECT_DEATH((ContiguousTensorView<float, 2>(tensor)), "");
+}
+
+} // namespace holoflow
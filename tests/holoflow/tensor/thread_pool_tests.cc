@@ -0,0 +1,51 @@
+#include "holoflow/tensor/thread_pool.hh"
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace holoflow {
+
+TEST(ThreadPoolTest, Every_Task_Runs_Once) {
+  ThreadPool pool(4);
+  EXPECT_EQ(pool.size(), 4);
+
+  for (size_t nb_tasks : {0, 1, 3, 100}) {
+    std::vector<std::atomic<int>> calls(nb_tasks);
+    pool.parallel_for(nb_tasks, [&](size_t i) { calls[i]++; });
+    for (size_t i = 0; i < nb_tasks; i++)
+      EXPECT_EQ(calls[i].load(), 1) << "task " << i << " of " << nb_tasks;
+  }
+}
+
+TEST(ThreadPoolTest, Single_Thread_Runs_On_Caller) {
+  ThreadPool pool(1);
+  EXPECT_EQ(pool.size(), 1);
+
+  std::vector<std::thread::id> ids(8);
+  pool.parallel_for(ids.size(),
+                    [&](size_t i) { ids[i] = std::this_thread::get_id(); });
+  for (std::thread::id id : ids)
+    EXPECT_EQ(id, std::this_thread::get_id());
+}
+
+TEST(ThreadPoolTest, Concurrent_Callers) {
+  ThreadPool pool(3);
+  std::atomic<size_t> total = 0;
+
+  auto caller = [&]() {
+    for (int batch = 0; batch < 200; batch++)
+      pool.parallel_for(10, [&](size_t i) { total += i; });
+  };
+  std::thread a(caller);
+  std::thread b(caller);
+  a.join();
+  b.join();
+
+  EXPECT_EQ(total.load(), 2 * 200 * 45);
+}
+
+} // namespace holoflow
@@ -0,0 +1,113 @@
+#include "batched_spsc_queue/batched_spsc_queue.hh"
+#include "batched_spsc_queue/queue_buffer.hh"
+#include "queue_io/disk_recorder.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+namespace holoflow {
+namespace {
+/// Returns the content of the file at `path`.
+std::vector<uint8_t> read_file(const std::string &path) {
+  std::ifstream file(path, std::ios::binary);
+  return {std::istreambuf_iterator<char>(file),
+          std::istreambuf_iterator<char>()};
+}
+} // namespace
+
+class DiskRecorderTest
+    : public testing::TestWithParam<
+          std::tuple<size_t, size_t, size_t, size_t, size_t, bool>> {};
+
+TEST_P(DiskRecorderTest, Stream_Is_Recorded_Entirely) {
+  auto [nb_slots, enqueue_batch_size, dequeue_batch_size, element_size,
+        nb_elements, zero_copy] = GetParam();
+  std::string path = testing::TempDir() + "holoflow-recorder-" +
+                     std::to_string(getpid()) + ".raw";
+
+  BatchedSPSCQueue queue(nb_slots, enqueue_batch_size, dequeue_batch_size,
+                         element_size,
+                         QueueBuffer::allocate(nb_slots * element_size));
+  RecorderOptions options;
+  options.write_size = 3 * DiskRecorder::DIRECT_IO_ALIGNMENT;
+  options.preallocate = nb_elements * element_size;
+
+  std::vector<uint8_t> expected(nb_elements * element_size);
+  for (size_t i = 0; i < expected.size(); i++)
+    expected[i] = static_cast<uint8_t>(i * 7 + i / 251);
+
+  {
+    DiskRecorder recorder(queue, path, options);
+
+    std::thread enqueue_thread([&queue, &expected, enqueue_batch_size]() {
+      size_t batch_bytes = enqueue_batch_size * queue.element_size();
+      for (size_t i = 0; i < expected.size(); i += batch_bytes) {
+        uint8_t *write_ptr = queue.wait_write_ptr();
+        std::copy_n(expected.data() + i, batch_bytes, write_ptr);
+        queue.commit_write();
+      }
+      queue.close();
+    });
+    recorder.run();
+    enqueue_thread.join();
+
+    RecorderStats stats = recorder.stats();
+    EXPECT_EQ(stats.bytes_written, expected.size());
+    EXPECT_EQ(stats.zero_copy, zero_copy);
+    EXPECT_EQ(queue.size(), 0);
+  }
+
+  EXPECT_EQ(read_file(path), expected);
+  unlink(path.c_str());
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    DiskRecorderTests, DiskRecorderTest,
+    testing::Values(
+        // Whole pages, written straight from the queue buffer.
+        std::make_tuple(16, 1, 2, 4096, 37, true),      // 00
+        std::make_tuple(64, 4, 1, 4096, 200, true),     // 01
+        // Staged, with a partial batch and a partial last write.
+        std::make_tuple(60, 3, 5, 100, 1002, false),    // 02
+        std::make_tuple(1024, 1, 16, 64, 10000, false), // 03
+        std::make_tuple(8, 1, 1, 1000, 3, false)));     // 04
+
+TEST(DiskRecorderTest, Empty_Stream_Gives_Empty_File) {
+  std::string path = testing::TempDir() + "holoflow-recorder-empty-" +
+                     std::to_string(getpid()) + ".raw";
+  BatchedSPSCQueue queue(16, 1, 1, 4096, QueueBuffer::allocate(16 * 4096));
+  RecorderOptions options;
+  options.preallocate = 1 << 20;
+
+  {
+    DiskRecorder recorder(queue, path, options);
+    queue.close();
+    recorder.run();
+    EXPECT_EQ(recorder.stats().bytes_written, 0);
+    EXPECT_FALSE(recorder.poll());
+  }
+
+  EXPECT_TRUE(read_file(path).empty());
+  unlink(path.c_str());
+}
+
+TEST(DiskRecorderTest, Invalid_Options) {
+  BatchedSPSCQueue queue(16, 1, 1, 4096, QueueBuffer::allocate(16 * 4096));
+  RecorderOptions options;
+  options.max_in_flight = 0;
+
+  EXPECT_THROW(DiskRecorder(queue, testing::TempDir() + "unused", options),
+               std::invalid_argument);
+}
+
+} // namespace holoflow
@@ -0,0 +1,206 @@
+#include "batched_spsc_queue/batched_spsc_queue.hh"
+#include "queue_io/replay_source.hh"
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+namespace holoflow {
+namespace {
+/// Writes `content` to a new file and returns its path.
+std::string write_file(const std::string &name,
+                       const std::vector<uint8_t> &content) {
+  std::string path = testing::TempDir() + "holoflow-replay-" + name + "-" +
+                     std::to_string(getpid()) + ".raw";
+  std::ofstream file(path, std::ios::binary);
+  file.write(reinterpret_cast<const char *>(content.data()),
+             static_cast<std::streamsize>(content.size()));
+  return path;
+}
+
+/// Returns `size` bytes of a recognizable pattern.
+std::vector<uint8_t> pattern(size_t size) {
+  std::vector<uint8_t> content(size);
+  for (size_t i = 0; i < size; i++)
+    content[i] = static_cast<uint8_t>(i * 7 + i / 251);
+  return content;
+}
+} // namespace
+
+class ReplaySourceTest
+    : public testing::TestWithParam<
+          std::tuple<size_t, size_t, size_t, size_t, size_t, bool>> {};
+
+TEST_P(ReplaySourceTest, Recording_Is_Replayed) {
+  auto [nb_slots, enqueue_batch_size, dequeue_batch_size, frame_size,
+        nb_frames, zero_copy] = GetParam();
+  std::vector<uint8_t> content = pattern(nb_frames * frame_size + 3);
+  std::string path = write_file("replayed", content);
+
+  size_t element_size = zero_copy ? sizeof(const uint8_t *) : frame_size;
+  std::vector<uint8_t> buffer(nb_slots * element_size);
+  BatchedSPSCQueue queue(nb_slots, enqueue_batch_size, dequeue_batch_size,
+                         element_size, buffer.data());
+  ReplayOptions options;
+  options.zero_copy = zero_copy;
+  options.frame_size = frame_size;
+  options.prefetch = 4096;
+
+  ReplaySource source(queue, path, options);
+  EXPECT_EQ(source.nb_frames(), nb_frames);
+  size_t nb_replayed = nb_frames / enqueue_batch_size * enqueue_batch_size;
+
+  std::thread replay_thread([&source]() { source.run(); });
+
+  std::vector<uint8_t> received;
+  auto receive = [&](const uint8_t *elements, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+      const uint8_t *element = elements + i * element_size;
+      const uint8_t *frame = zero_copy ? ReplaySource::frame(element) : element;
+      received.insert(received.end(), frame, frame + frame_size);
+    }
+  };
+  while (!queue.is_closed()) {
+    if (uint8_t *read_ptr = queue.read_ptr()) {
+      receive(read_ptr, dequeue_batch_size);
+      queue.commit_read();
+    }
+  }
+  size_t count = 0;
+  while (uint8_t *read_ptr = queue.read_ptr_partial(count)) {
+    receive(read_ptr, count);
+    queue.commit_read_partial(count);
+  }
+  replay_thread.join();
+
+  EXPECT_EQ(source.frames_replayed(), nb_replayed);
+  content.resize(nb_replayed * frame_size);
+  EXPECT_EQ(received, content);
+  unlink(path.c_str());
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    ReplaySourceTests, ReplaySourceTest,
+    testing::Values(
+        std::make_tuple(16, 1, 1, 100, 1000, false),  // 00
+        std::make_tuple(60, 3, 5, 64, 1001, false),   // 01
+        std::make_tuple(16, 4, 2, 5000, 40, false),   // 02
+        std::make_tuple(16, 1, 4, 100, 1000, true),   // 03
+        std::make_tuple(64, 8, 4, 4096, 203, true))); // 04
+
+TEST(ReplaySourceTest, Fixed_Rate_Is_Paced) {
+  std::string path = write_file("fixed-rate", pattern(50 * 8));
+  std::vector<uint8_t> buffer(64 * 8);
+  BatchedSPSCQueue queue(64, 1, 1, 8, buffer.data());
+  ReplayOptions options;
+  options.pacing = ReplayPacing::FixedRate;
+  options.fps = 1000;
+
+  ReplaySource source(queue, path, options);
+  auto start = std::chrono::steady_clock::now();
+  while (source.poll()) {
+    if (queue.read_ptr())
+      queue.commit_read();
+  }
+
+  // The 50th frame is due 49 ms after the first one.
+  EXPECT_GE(std::chrono::steady_clock::now() - start,
+            std::chrono::milliseconds(49));
+  EXPECT_EQ(source.frames_replayed(), 50);
+  unlink(path.c_str());
+}
+
+TEST(ReplaySourceTest, Timestamps_Are_Followed) {
+  // Each frame starts with its capture time in microseconds.
+  const std::vector<uint64_t> stamps = {1000, 1500, 21000, 22000};
+  std::vector<uint8_t> content(stamps.size() * 16);
+  for (size_t i = 0; i < stamps.size(); i++)
+    std::memcpy(content.data() + i * 16, &stamps[i], sizeof(uint64_t));
+  std::string path = write_file("timestamps", content);
+
+  std::vector<uint8_t> buffer(8 * 16);
+  BatchedSPSCQueue queue(8, 2, 2, 16, buffer.data());
+  ReplayOptions options;
+  options.pacing = ReplayPacing::Timestamps;
+  options.timestamp = [](const uint8_t *frame) {
+    uint64_t stamp;
+    std::memcpy(&stamp, frame, sizeof(stamp));
+    return std::chrono::microseconds(stamp);
+  };
+
+  ReplaySource source(queue, path, options);
+  auto start = std::chrono::steady_clock::now();
+  source.run();
+
+  // The last batch is due when its last frame is, 21 ms after the first one.
+  EXPECT_GE(std::chrono::steady_clock::now() - start,
+            std::chrono::milliseconds(21));
+  EXPECT_EQ(queue.size(), 4);
+  EXPECT_TRUE(queue.is_closed());
+  unlink(path.c_str());
+}
+
+TEST(ReplaySourceTest, Batch_Size_Follows_Reconfiguration) {
+  std::vector<uint8_t> content = pattern(40 * 8);
+  std::string path = write_file("reconfigured", content);
+  std::vector<uint8_t> buffer(24 * 8);
+  BatchedSPSCQueue queue(24, 2, 2, 8, buffer.data());
+
+  ReplaySource source(queue, path);
+  std::vector<uint8_t> received;
+  while (source.poll()) {
+    // Switch to batches of 4 frames after the first few.
+    if (source.frames_replayed() == 6)
+      queue.request_enqueue_batch_size(4);
+    if (uint8_t *read_ptr = queue.read_ptr()) {
+      received.insert(received.end(), read_ptr, read_ptr + 2 * 8);
+      queue.commit_read();
+    }
+  }
+  while (uint8_t *read_ptr = queue.read_ptr()) {
+    received.insert(received.end(), read_ptr, read_ptr + 2 * 8);
+    queue.commit_read();
+  }
+
+  EXPECT_EQ(queue.enqueue_batch_size(), 4);
+  EXPECT_EQ(source.frames_replayed(), 40);
+  EXPECT_EQ(received, content);
+  unlink(path.c_str());
+}
+
+TEST(ReplaySourceTest, Invalid_Options) {
+  std::string path = write_file("invalid", pattern(64));
+  std::vector<uint8_t> buffer(16 * 8);
+  BatchedSPSCQueue queue(16, 1, 1, 8, buffer.data());
+
+  ReplayOptions fixed_rate;
+  fixed_rate.pacing = ReplayPacing::FixedRate;
+  EXPECT_THROW(ReplaySource(queue, path, fixed_rate), std::invalid_argument);
+
+  ReplayOptions timestamps;
+  timestamps.pacing = ReplayPacing::Timestamps;
+  EXPECT_THROW(ReplaySource(queue, path, timestamps), std::invalid_argument);
+
+  std::vector<uint8_t> wide_buffer(16 * 32);
+  BatchedSPSCQueue wide_queue(16, 1, 1, 32, wide_buffer.data());
+  ReplayOptions zero_copy;
+  zero_copy.zero_copy = true;
+  zero_copy.frame_size = 32;
+  EXPECT_THROW(ReplaySource(wide_queue, path, zero_copy),
+               std::invalid_argument);
+
+  EXPECT_THROW(ReplaySource(queue, path + ".missing"), std::system_error);
+  unlink(path.c_str());
+}
+
+} // namespace holoflow